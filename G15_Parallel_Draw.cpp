@@ -0,0 +1,279 @@
+/**************************************************************************************************
+*
+* \file G15_Parallel_Draw.cpp
+* \brief Guideline 15: Design for the Addition of Types or Operations
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <DrawCommands.h> ---------------------------------------------------------------------------
+
+//#include <Point.h>
+#include <vector>
+
+struct DrawCommand
+{
+   enum Kind { circle, square };
+
+   Kind kind;
+   Point center;
+   double size;
+};
+
+inline bool operator==( DrawCommand const& lhs, DrawCommand const& rhs )
+{
+   return lhs.kind == rhs.kind && lhs.center.x == rhs.center.x &&
+          lhs.center.y == rhs.center.y && lhs.size == rhs.size;
+}
+
+using DrawCommands = std::vector<DrawCommand>;
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <DrawCommands.h>
+
+class Shape
+{
+ public:
+   Shape() = default;
+
+   virtual ~Shape() = default;
+
+   virtual void draw( DrawCommands& commands ) const = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+//#include <Shape.h>
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius, Point center = {} )
+      : radius_( radius )
+      , center_( center )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void draw( DrawCommands& commands ) const override;
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Circle.cpp> -------------------------------------------------------------------------------
+
+//#include <Circle.h>
+
+void Circle::draw( DrawCommands& commands ) const
+{
+   commands.push_back( DrawCommand{ DrawCommand::circle, center_, radius_ } );
+}
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+//#include <Shape.h>
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side, Point center = {} )
+      : side_( side )
+      , center_( center )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void draw( DrawCommands& commands ) const override;
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Square.cpp> -------------------------------------------------------------------------------
+
+//#include <Square.h>
+
+void Square::draw( DrawCommands& commands ) const
+{
+   commands.push_back( DrawCommand{ DrawCommand::square, center_, side_ } );
+}
+
+
+//---- <ParallelFor.h> ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct ParallelPolicy
+{
+   std::size_t threads{ std::max( std::thread::hardware_concurrency(), 1U ) };
+   std::size_t chunkSize{ 4096U };
+};
+
+// Splits the index range [0,size) into chunks of 'policy.chunkSize' indices and calls
+// 'f( chunk, begin, end )' once for every chunk. Every worker thread initially owns a
+// contiguous range of chunks. As soon as a worker has processed all of its own chunks,
+// it steals the remaining chunks of the other workers, one chunk at a time.
+template< typename F >
+void parallelForChunks( std::size_t size, ParallelPolicy const& policy, F f )
+{
+   std::size_t const chunkSize( std::max( policy.chunkSize, std::size_t{1U} ) );
+   std::size_t const chunks( ( size + chunkSize - 1U ) / chunkSize );
+   std::size_t const workers( std::min( std::max( policy.threads, std::size_t{1U} ), chunks ) );
+
+   if( workers <= 1U ) {
+      for( std::size_t chunk=0U; chunk<chunks; ++chunk ) {
+         f( chunk, chunk*chunkSize, std::min( (chunk+1U)*chunkSize, size ) );
+      }
+      return;
+   }
+
+   struct alignas(64) Queue
+   {
+      std::atomic<std::size_t> next{};
+      std::size_t end{};
+   };
+
+   auto queues = std::make_unique<Queue[]>( workers );
+   for( std::size_t w=0U; w<workers; ++w ) {
+      queues[w].next = w * chunks / workers;
+      queues[w].end  = (w+1U) * chunks / workers;
+   }
+
+   auto const work = [&]( std::size_t self )
+   {
+      for( std::size_t i=0U; i<workers; ++i )
+      {
+         Queue& queue = queues[(self+i) % workers];
+         for( std::size_t chunk = queue.next++; chunk < queue.end; chunk = queue.next++ ) {
+            f( chunk, chunk*chunkSize, std::min( (chunk+1U)*chunkSize, size ) );
+         }
+      }
+   };
+
+   std::vector<std::jthread> threads{};
+   threads.reserve( workers-1U );
+   for( std::size_t w=1U; w<workers; ++w ) {
+      threads.emplace_back( work, w );
+   }
+   work( 0U );
+}
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <DrawCommands.h>
+//#include <ParallelFor.h>
+#include <memory>
+#include <vector>
+class Shape;
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, DrawCommands& commands );
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, DrawCommands& commands,
+                    ParallelPolicy const& policy );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Shape.h>
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, DrawCommands& commands )
+{
+   for ( auto const& shape : shapes )
+   {
+      shape->draw( commands );
+   }
+}
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, DrawCommands& commands,
+                    ParallelPolicy const& policy )
+{
+   std::size_t const chunkSize( std::max( policy.chunkSize, std::size_t{1U} ) );
+   std::vector<DrawCommands> buffers( ( shapes.size() + chunkSize - 1U ) / chunkSize );
+
+   // Every chunk of shapes is drawn into its own command buffer ...
+   parallelForChunks( shapes.size(), policy,
+      [&]( std::size_t chunk, std::size_t begin, std::size_t end )
+      {
+         DrawCommands& buffer = buffers[chunk];
+         for( std::size_t i=begin; i<end; ++i ) {
+            shapes[i]->draw( buffer );
+         }
+      } );
+
+   // ... and the buffers are merged in chunk order, resulting in the same sequence of draw
+   // commands as the serial drawAllShapes(), independent of the scheduling of the chunks
+   for( auto const& buffer : buffers ) {
+      commands.insert( end(commands), begin(buffer), end(buffer) );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   // Creating some shapes
+   Shapes shapes{};
+   for( int i=0; i<10000; ++i ) {
+      Point const center{ 0.5*i, 0.25*i };
+      if( i % 3 == 0 ) shapes.emplace_back( std::make_unique<Square>( 1.2, center ) );
+      else             shapes.emplace_back( std::make_unique<Circle>( 2.3, center ) );
+   }
+
+   // Drawing all shapes serially and in parallel
+   DrawCommands serial{};
+   drawAllShapes( shapes, serial );
+
+   DrawCommands parallel{};
+   drawAllShapes( shapes, parallel, ParallelPolicy{ 4U, 256U } );
+
+   return ( serial == parallel ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
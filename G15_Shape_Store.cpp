@@ -0,0 +1,219 @@
+/**************************************************************************************************
+*
+* \file G15_Shape_Store.cpp
+* \brief Guideline 15: Design for the Addition of Types or Operations
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <DrawCircle.h> -----------------------------------------------------------------------------
+
+class Circle;
+
+void draw( Circle const& circle );
+
+
+//---- <DrawCircle.cpp> ---------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <DrawCircle.h>
+//#include /* some graphics library */
+
+void draw( Circle const& circle )
+{
+   // ... Implementing the logic for drawing a circle
+}
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <DrawSquare.h> -----------------------------------------------------------------------------
+
+class Square;
+
+void draw( Square const& square );
+
+
+//---- <DrawSquare.cpp> ---------------------------------------------------------------------------
+
+//#include <DrawSquare.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+void draw( Square const& square )
+{
+   // ... Implementing the logic for drawing a square
+}
+
+
+//---- <ShapeStore.h> -----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// The ShapeStore keeps one contiguous array per concrete shape type instead of a single
+// array of pointers to heap-allocated shapes. Since the type of every element of an array
+// is known statically, operations on all shapes don't require any kind of dispatch.
+template< typename... ShapeTs >
+class ShapeStore
+{
+ public:
+   template< typename ShapeT, typename... Args >
+   ShapeT& emplace( Args&&... args )
+   {
+      return std::get<std::vector<ShapeT>>( shapes_ ).emplace_back( std::forward<Args>(args)... );
+   }
+
+   template< typename ShapeT >
+   std::span<ShapeT const> get() const
+   {
+      return std::get<std::vector<ShapeT>>( shapes_ );
+   }
+
+   template< typename ShapeT >
+   void reserve( std::size_t capacity )
+   {
+      std::get<std::vector<ShapeT>>( shapes_ ).reserve( capacity );
+   }
+
+   std::size_t size() const
+   {
+      return ( std::get<std::vector<ShapeTs>>( shapes_ ).size() + ... );
+   }
+
+   void clear()
+   {
+      ( std::get<std::vector<ShapeTs>>( shapes_ ).clear(), ... );
+   }
+
+   // Applies the given operation to all shapes, one type after another
+   template< typename Op >
+   void forEach( Op op ) const
+   {
+      ( forEachOf<ShapeTs>( op ), ... );
+   }
+
+ private:
+   template< typename ShapeT, typename Op >
+   void forEachOf( Op& op ) const
+   {
+      for( auto const& shape : std::get<std::vector<ShapeT>>( shapes_ ) )
+      {
+         op( shape );
+      }
+   }
+
+   std::tuple<std::vector<ShapeTs>...> shapes_;
+};
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <ShapeStore.h>
+
+using Shapes = ShapeStore<Circle,Square>;
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <Shapes.h>
+
+void drawAllShapes( Shapes const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <DrawCircle.h>
+//#include <DrawSquare.h>
+
+void drawAllShapes( Shapes const& shapes )
+{
+   shapes.forEach( []( auto const& shape ){ draw( shape ); } );
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shapes.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+
+int main()
+{
+   Shapes shapes{};
+
+   // Creating some shapes
+   shapes.emplace<Circle>( 2.3 );
+   shapes.emplace<Square>( 1.2 );
+   shapes.emplace<Circle>( 4.1 );
+
+   // Drawing all shapes (first all circles, then all squares)
+   drawAllShapes( shapes );
+
+   return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,244 @@
+/**************************************************************************************************
+*
+* \file G15_Shape_Store_Performance.cpp
+* \brief Guideline 15: Design for the Addition of Types or Operations
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to draw all
+* shapes stored in a std::vector of std::unique_ptrs to a Shape base class in comparison to
+* drawing all shapes stored in a type-sorted ShapeStore.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );      // Minimum size of the generated containers
+constexpr size_t maxSize( 10000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_POINTER_VECTOR 1  // std::vector<std::unique_ptr<Shape>>, virtual dispatch
+#define BENCHMARK_SHAPE_STORE    1  // One contiguous array per shape type, no dispatch
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Point --------------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- Pointer vector implementation --------------------------------------------------------------
+
+namespace pointer_vector {
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw() const = 0;
+};
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void draw() const override { benchmark::DoNotOptimize( radius_ ); }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void draw() const override { benchmark::DoNotOptimize( side_ ); }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      shape->draw();
+   }
+}
+
+} // namespace pointer_vector
+
+
+//---- ShapeStore implementation ------------------------------------------------------------------
+
+namespace shape_store {
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+void draw( Circle const& circle ) { benchmark::DoNotOptimize( circle.radius() ); }
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+void draw( Square const& square ) { benchmark::DoNotOptimize( square.side() ); }
+
+template< typename... ShapeTs >
+class ShapeStore
+{
+ public:
+   template< typename ShapeT, typename... Args >
+   ShapeT& emplace( Args&&... args )
+   {
+      return std::get<std::vector<ShapeT>>( shapes_ ).emplace_back( std::forward<Args>(args)... );
+   }
+
+   std::size_t size() const
+   {
+      return ( std::get<std::vector<ShapeTs>>( shapes_ ).size() + ... );
+   }
+
+   template< typename Op >
+   void forEach( Op op ) const
+   {
+      ( forEachOf<ShapeTs>( op ), ... );
+   }
+
+ private:
+   template< typename ShapeT, typename Op >
+   void forEachOf( Op& op ) const
+   {
+      for( auto const& shape : std::get<std::vector<ShapeT>>( shapes_ ) )
+      {
+         op( shape );
+      }
+   }
+
+   std::tuple<std::vector<ShapeTs>...> shapes_;
+};
+
+using Shapes = ShapeStore<Circle,Square>;
+
+void drawAllShapes( Shapes const& shapes )
+{
+   shapes.forEach( []( auto const& shape ){ draw( shape ); } );
+}
+
+} // namespace shape_store
+
+
+//---- Benchmark for the pointer vector -----------------------------------------------------------
+
+static void drawPointerVector(benchmark::State& state)
+{
+   using namespace pointer_vector;
+
+   Shapes shapes{};
+   shapes.reserve( state.range(0) );
+   for( int64_t i=0; i<state.range(0); ++i ) {
+      if( is_circle() ) shapes.emplace_back( std::make_unique<Circle>( get_random_size() ) );
+      else              shapes.emplace_back( std::make_unique<Square>( get_random_size() ) );
+   }
+
+   for( auto _ : state )
+   {
+      drawAllShapes( shapes );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_POINTER_VECTOR
+BENCHMARK(drawPointerVector)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for the ShapeStore ---------------------------------------------------------------
+
+static void drawShapeStore(benchmark::State& state)
+{
+   using namespace shape_store;
+
+   Shapes shapes{};
+   for( int64_t i=0; i<state.range(0); ++i ) {
+      if( is_circle() ) shapes.emplace<Circle>( get_random_size() );
+      else              shapes.emplace<Square>( get_random_size() );
+   }
+
+   for( auto _ : state )
+   {
+      drawAllShapes( shapes );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_SHAPE_STORE
+BENCHMARK(drawShapeStore)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
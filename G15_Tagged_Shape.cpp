@@ -0,0 +1,218 @@
+/**************************************************************************************************
+*
+* \file G15_Tagged_Shape.cpp
+* \brief Guideline 15: Design for the Addition of Types or Operations
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <ShapeType.h> ------------------------------------------------------------------------------
+
+enum ShapeType
+{
+   circle,
+   square,
+   shapeTypeCount  // Number of shape types; has to remain the last enumerator
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <DrawCircle.h> -----------------------------------------------------------------------------
+
+class Circle;
+
+void draw( Circle const& circle );
+
+
+//---- <DrawCircle.cpp> ---------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <DrawCircle.h>
+//#include /* some graphics library */
+
+void draw( Circle const& circle )
+{
+   // ... Implementing the logic for drawing a circle
+}
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <DrawSquare.h> -----------------------------------------------------------------------------
+
+class Square;
+
+void draw( Square const& square );
+
+
+//---- <DrawSquare.cpp> ---------------------------------------------------------------------------
+
+//#include <DrawSquare.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+void draw( Square const& square )
+{
+   // ... Implementing the logic for drawing a square
+}
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ShapeType.h>
+//#include <Square.h>
+#include <type_traits>
+
+// A fixed-size, value-semantic shape record, consisting of the type tag and a union of all
+// concrete shapes. In contrast to a hierarchy of shapes, a Shape doesn't require a dynamic
+// memory allocation and can be stored directly inside a std::vector.
+class Shape
+{
+ public:
+   Shape( Circle const& c )
+      : type_( circle )
+      , circle_( c )
+   {}
+
+   Shape( Square const& s )
+      : type_( square )
+      , square_( s )
+   {}
+
+   ShapeType getType() const { return type_; }
+
+   // The accessors don't check the type tag; calling an accessor that doesn't match the
+   // type tag results in undefined behavior
+   Circle const& asCircle() const { return circle_; }
+   Square const& asSquare() const { return square_; }
+
+ private:
+   ShapeType type_;
+   union {
+      Circle circle_;
+      Square square_;
+   };
+};
+
+static_assert( std::is_trivially_copyable_v<Shape> );
+static_assert( std::is_trivially_destructible_v<Shape> );
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+void drawAllShapes( std::vector<Shape> const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <DrawCircle.h>
+//#include <DrawSquare.h>
+#include <array>
+
+namespace {
+
+using DrawFunction = void(*)( Shape const& );
+
+// The jump table, indexed by the type tag. The order of the entries has to match the
+// order of the enumerators of ShapeType.
+constexpr std::array<DrawFunction,shapeTypeCount> drawTable{
+   []( Shape const& shape ){ draw( shape.asCircle() ); },
+   []( Shape const& shape ){ draw( shape.asSquare() ); }
+};
+
+} // namespace
+
+void drawAllShapes( std::vector<Shape> const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      drawTable[shape.getType()]( shape );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector<Shape>;
+
+   // Creating some shapes, without any dynamic memory allocation per shape
+   Shapes shapes{};
+   shapes.emplace_back( Circle{ 2.3 } );
+   shapes.emplace_back( Square{ 1.2 } );
+   shapes.emplace_back( Circle{ 4.1 } );
+
+   // Drawing all shapes
+   drawAllShapes( shapes );
+
+   return EXIT_SUCCESS;
+}
+
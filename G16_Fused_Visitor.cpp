@@ -0,0 +1,230 @@
+/**************************************************************************************************
+*
+* \file G16_Fused_Visitor.cpp
+* \brief Guideline 16: Use Visitors to Extend Operations
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <ShapeVisitor.h> ---------------------------------------------------------------------------
+
+class Circle;
+class Square;
+
+class ShapeVisitor
+{
+ public:
+   virtual ~ShapeVisitor() = default;
+
+   virtual void visit( Circle const& /*, ...*/ ) const = 0;
+   virtual void visit( Square const& /*, ...*/ ) const = 0;
+   // Possibly more visit() functions, one for each concrete shape
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <ShapeVisitor.h>
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void accept( ShapeVisitor const& v ) = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   void accept( ShapeVisitor const& v ) override { v.visit(*this); }
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   void accept( ShapeVisitor const& v ) override { v.visit(*this); }
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ShapeVisitor.h>
+//#include <Square.h>
+
+class Draw final : public ShapeVisitor
+{
+ public:
+   void visit( Circle const& c /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a circle
+   }
+
+   void visit( Square const& s /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a square
+   }
+};
+
+
+//---- <Area.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ShapeVisitor.h>
+//#include <Square.h>
+#include <numbers>
+
+class Area final : public ShapeVisitor
+{
+ public:
+   void visit( Circle const& c ) const override
+   {
+      total_ += std::numbers::pi * c.radius() * c.radius();
+   }
+
+   void visit( Square const& s ) const override
+   {
+      total_ += s.side() * s.side();
+   }
+
+   double total() const { return total_; }
+
+ private:
+   mutable double total_{};
+};
+
+
+//---- <FusedVisitor.h> ---------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ShapeVisitor.h>
+//#include <Square.h>
+#include <tuple>
+#include <utility>
+
+// Combines several visitors into a single visitor, which applies all of them, one after
+// another, to a shape. Thus several operations can be performed within a single traversal
+// of the shapes, while every shape is still hot in the cache. In case the given visitors
+// are final, the calls to their visit() functions don't require a virtual function call.
+// Temporary visitors are stored by value, whereas visitors given as lvalues are referenced,
+// such that the results of stateful visitors remain accessible after the traversal.
+template< typename... Visitors >
+class FusedVisitor : public ShapeVisitor
+{
+ public:
+   explicit FusedVisitor( Visitors... visitors )
+      : visitors_( std::forward<Visitors>(visitors)... )
+   {}
+
+   void visit( Circle const& c ) const override { visitAll( c ); }
+   void visit( Square const& s ) const override { visitAll( s ); }
+
+ private:
+   template< typename T >
+   void visitAll( T const& t ) const
+   {
+      std::apply( [&t]( auto const&... v ){ ( v.visit( t ), ... ); }, visitors_ );
+   }
+
+   std::tuple<Visitors...> visitors_;
+};
+
+template< typename... Visitors >
+FusedVisitor( Visitors&&... ) -> FusedVisitor<Visitors...>;
+
+
+//---- <VisitAllShapes.h> -------------------------------------------------------------------------
+
+#include <memory>
+#include <vector>
+class Shape;
+class ShapeVisitor;
+
+void visitAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, ShapeVisitor const& v );
+
+
+//---- <VisitAllShapes.cpp> -----------------------------------------------------------------------
+
+//#include <VisitAllShapes.h>
+//#include <Shape.h>
+
+void visitAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes, ShapeVisitor const& v )
+{
+   for( auto const& shape : shapes )
+   {
+      shape->accept( v );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Area.h>
+//#include <Circle.h>
+//#include <Draw.h>
+//#include <FusedVisitor.h>
+//#include <Square.h>
+//#include <VisitAllShapes.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector< std::unique_ptr<Shape> >;
+
+   Shapes shapes{};
+
+   // Creating some shapes
+   shapes.emplace_back( std::make_unique<Circle>( 2.3 ) );
+   shapes.emplace_back( std::make_unique<Square>( 1.2 ) );
+   shapes.emplace_back( std::make_unique<Circle>( 4.1 ) );
+
+   // Drawing all shapes and computing their total area in a single pass
+   Area const area{};
+   visitAllShapes( shapes, FusedVisitor{ Draw{}, area } );
+
+   // Computing the total area in a separate pass
+   Area const reference{};
+   visitAllShapes( shapes, reference );
+
+   return ( area.total() == reference.total() ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
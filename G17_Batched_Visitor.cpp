@@ -0,0 +1,335 @@
+/**************************************************************************************************
+*
+* \file G17_Batched_Visitor.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <variant>
+
+using Shape = std::variant<Circle,Square>;
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+using Shapes = std::vector<Shape>;
+
+
+//---- <ShapeBatches.h> ---------------------------------------------------------------------------
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Keeps shapes grouped by their type. Every alternative of the variant is stored in a separate,
+// contiguous array, such that a batched visitor is handed a std::span of a single concrete type
+// and the per-element dispatch on the index is gone. The type of a shape is resolved once on
+// insertion; visiting the shapes only walks the spans. Note that the order of the shapes is
+// retained per type only.
+template< typename Variant >
+class ShapeBatches;
+
+template< typename... Ts >
+class ShapeBatches< std::variant<Ts...> >
+{
+ public:
+   ShapeBatches() = default;
+
+   explicit ShapeBatches( std::vector< std::variant<Ts...> > const& shapes )
+   {
+      assign( shapes );
+   }
+
+   // Regroups the given shapes, reusing the memory of previous calls
+   void assign( std::vector< std::variant<Ts...> > const& shapes )
+   {
+      std::array<size_t,sizeof...(Ts)> counts{};
+      for( auto const& shape : shapes ) {
+         ++counts[shape.index()];
+      }
+
+      ( std::get< std::vector<Ts> >( batches_ ).clear(), ... );
+      reserve( counts, std::index_sequence_for<Ts...>{} );
+
+      for( auto const& shape : shapes ) {
+         push_back( shape );
+      }
+   }
+
+   // Adds the given shape to the batch of its type
+   template< typename T >
+   void push_back( T shape )
+   {
+      std::get< std::vector<T> >( batches_ ).push_back( std::move(shape) );
+   }
+
+   void push_back( std::variant<Ts...> const& shape )
+   {
+      std::visit( [this]( auto const& s ){ push_back( s ); }, shape );
+   }
+
+   size_t size() const
+   {
+      return ( std::get< std::vector<Ts> >( batches_ ).size() + ... );
+   }
+
+   template< typename T >
+   std::span<T const> get() const
+   {
+      return std::get< std::vector<T> >( batches_ );
+   }
+
+   // Hands every non-empty batch to the given visitor, one alternative after another
+   template< typename Visitor >
+   void visit( Visitor&& visitor ) const
+   {
+      ( visitBatch<Ts>( visitor ), ... );
+   }
+
+ private:
+   template< size_t... Is >
+   void reserve( std::array<size_t,sizeof...(Ts)> const& counts, std::index_sequence<Is...> )
+   {
+      ( std::get<Is>( batches_ ).reserve( counts[Is] ), ... );
+   }
+
+   template< typename T, typename Visitor >
+   void visitBatch( Visitor& visitor ) const
+   {
+      auto const& batch = std::get< std::vector<T> >( batches_ );
+      if( !batch.empty() ) {
+         visitor( std::span<T const>( batch ) );
+      }
+   }
+
+   std::tuple< std::vector<Ts>... > batches_;
+};
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* some graphics library */
+#include <span>
+
+class Draw
+{
+ public:
+   void operator()( std::span<Circle const> circles ) const
+   {
+      /* ... Implementing the logic for drawing a batch of circles ... */
+   }
+   void operator()( std::span<Square const> squares ) const
+   {
+      /* ... Implementing the logic for drawing a batch of squares ... */
+   }
+};
+
+
+//---- <Area.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <numbers>
+#include <span>
+
+class Area
+{
+ public:
+   void operator()( std::span<Circle const> circles )
+   {
+      double sum{};
+      for( auto const& c : circles ) {
+         sum += c.radius() * c.radius();
+      }
+      total_ += std::numbers::pi * sum;
+   }
+   void operator()( std::span<Square const> squares )
+   {
+      double sum{};
+      for( auto const& s : squares ) {
+         sum += s.side() * s.side();
+      }
+      total_ += sum;
+   }
+
+   double total() const { return total_; }
+
+ private:
+   double total_{};
+};
+
+
+//---- <BoundingBox.h> ----------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Point.h>
+//#include <Square.h>
+#include <algorithm>
+#include <limits>
+#include <span>
+
+class BoundingBox
+{
+ public:
+   void operator()( std::span<Circle const> circles )
+   {
+      for( auto const& c : circles ) {
+         extend( c.center(), c.radius() );
+      }
+   }
+   void operator()( std::span<Square const> squares )
+   {
+      for( auto const& s : squares ) {
+         extend( s.center(), 0.5*s.side() );
+      }
+   }
+
+   Point lower() const { return lower_; }
+   Point upper() const { return upper_; }
+
+ private:
+   void extend( Point center, double halfExtent )
+   {
+      lower_.x = std::min( lower_.x, center.x - halfExtent );
+      lower_.y = std::min( lower_.y, center.y - halfExtent );
+      upper_.x = std::max( upper_.x, center.x + halfExtent );
+      upper_.y = std::max( upper_.y, center.y + halfExtent );
+   }
+
+   Point lower_{  std::numeric_limits<double>::max(),  std::numeric_limits<double>::max() };
+   Point upper_{ -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <ShapeBatches.h>
+
+void drawAllShapes( ShapeBatches<Shape> const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Draw.h>
+
+void drawAllShapes( ShapeBatches<Shape> const& shapes )
+{
+   shapes.visit( Draw{} );
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Area.h>
+//#include <BoundingBox.h>
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shapes.h>
+//#include <ShapeBatches.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+
+int main()
+{
+   // The scene keeps its shapes grouped by type from the start
+   ShapeBatches<Shape> shapes{};
+
+   shapes.push_back( Circle{ 2.3 } );
+   shapes.push_back( Square{ 1.2 } );
+   shapes.push_back( Circle{ 4.1 } );
+
+   drawAllShapes( shapes );
+
+   // Applying several batched operations to the same batches
+   Area area{};
+   shapes.visit( area );
+
+   BoundingBox box{};
+   shapes.visit( box );
+
+   // Grouping an existing vector of variants once yields the same batches
+   Shapes const mixed{ Circle{ 2.3 }, Square{ 1.2 }, Circle{ 4.1 } };
+   ShapeBatches<Shape> const regrouped( mixed );
+
+   Area expected{};
+   regrouped.visit( expected );
+
+   return ( shapes.size() == mixed.size() && area.total() == expected.total() )
+          ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
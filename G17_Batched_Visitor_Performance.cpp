@@ -0,0 +1,254 @@
+/**************************************************************************************************
+*
+* \file G17_Batched_Visitor_Performance.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to compute the
+* total area of all shapes, once by means of a std::visit() per element of a std::vector of
+* std::variants, once by means of persistent type-grouped batches, and once by means of batches
+* that are regrouped from the std::vector in every iteration.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstddef>
+#include <numbers>
+#include <random>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 10000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 10000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_VISIT_LOOP      1  // One std::visit() per element
+#define BENCHMARK_BATCHED_VISIT   1  // Persistent batches of a single type
+#define BENCHMARK_REGROUP_VISIT   1  // Batches regrouped in every iteration
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+using Shape  = std::variant<Circle,Square>;
+using Shapes = std::vector<Shape>;
+
+Shapes createShapes( size_t size )
+{
+   Shapes shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      if( is_circle() ) shapes.emplace_back( Circle{ get_random_size() } );
+      else              shapes.emplace_back( Square{ get_random_size() } );
+   }
+   return shapes;
+}
+
+
+//---- Shape batches ------------------------------------------------------------------------------
+
+template< typename Variant >
+class ShapeBatches;
+
+template< typename... Ts >
+class ShapeBatches< std::variant<Ts...> >
+{
+ public:
+   ShapeBatches() = default;
+
+   explicit ShapeBatches( std::vector< std::variant<Ts...> > const& shapes )
+   {
+      assign( shapes );
+   }
+
+   void assign( std::vector< std::variant<Ts...> > const& shapes )
+   {
+      std::array<size_t,sizeof...(Ts)> counts{};
+      for( auto const& shape : shapes ) {
+         ++counts[shape.index()];
+      }
+
+      ( std::get< std::vector<Ts> >( batches_ ).clear(), ... );
+      reserve( counts, std::index_sequence_for<Ts...>{} );
+
+      for( auto const& shape : shapes ) {
+         push_back( shape );
+      }
+   }
+
+   template< typename T >
+   void push_back( T shape )
+   {
+      std::get< std::vector<T> >( batches_ ).push_back( std::move(shape) );
+   }
+
+   void push_back( std::variant<Ts...> const& shape )
+   {
+      std::visit( [this]( auto const& s ){ push_back( s ); }, shape );
+   }
+
+   template< typename Visitor >
+   void visit( Visitor&& visitor ) const
+   {
+      ( visitor( std::span<Ts const>( std::get< std::vector<Ts> >( batches_ ) ) ), ... );
+   }
+
+ private:
+   template< size_t... Is >
+   void reserve( std::array<size_t,sizeof...(Ts)> const& counts, std::index_sequence<Is...> )
+   {
+      ( std::get<Is>( batches_ ).reserve( counts[Is] ), ... );
+   }
+
+   std::tuple< std::vector<Ts>... > batches_;
+};
+
+
+//---- Operations ---------------------------------------------------------------------------------
+
+class Area
+{
+ public:
+   void operator()( Circle const& c ) { total_ += std::numbers::pi * c.radius() * c.radius(); }
+   void operator()( Square const& s ) { total_ += s.side() * s.side(); }
+
+   void operator()( std::span<Circle const> circles )
+   {
+      double sum{};
+      for( auto const& c : circles ) {
+         sum += c.radius() * c.radius();
+      }
+      total_ += std::numbers::pi * sum;
+   }
+
+   void operator()( std::span<Square const> squares )
+   {
+      double sum{};
+      for( auto const& s : squares ) {
+         sum += s.side() * s.side();
+      }
+      total_ += sum;
+   }
+
+   double total() const { return total_; }
+
+ private:
+   double total_{};
+};
+
+
+//---- Benchmark for one std::visit() per element -------------------------------------------------
+
+static void visitLoop(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      Area area{};
+      for( auto const& shape : shapes ) {
+         std::visit( area, shape );
+      }
+      benchmark::DoNotOptimize( area.total() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_VISIT_LOOP
+BENCHMARK(visitLoop)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for persistent batches -----------------------------------------------------------
+
+static void batchedVisit(benchmark::State& state)
+{
+   ShapeBatches<Shape> const batches( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      Area area{};
+      batches.visit( area );
+      benchmark::DoNotOptimize( area.total() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_BATCHED_VISIT
+BENCHMARK(batchedVisit)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for batches regrouped in every iteration -----------------------------------------
+
+static void regroupAndVisit(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+   ShapeBatches<Shape> batches{};
+
+   for( auto _ : state )
+   {
+      Area area{};
+      batches.assign( shapes );
+      batches.visit( area );
+      benchmark::DoNotOptimize( area.total() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_REGROUP_VISIT
+BENCHMARK(regroupAndVisit)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,595 @@
+/**************************************************************************************************
+*
+* \file G17_Dirty_Region.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Rect.h> -----------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+// An axis-aligned rectangle, e.g. a bounding box or a viewport
+struct Rect
+{
+   Point lower;
+   Point upper;
+};
+
+inline bool intersects( Rect const& a, Rect const& b )
+{
+   return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+          a.lower.y <= b.upper.y && b.lower.y <= a.upper.y;
+}
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius, Point center = {} )
+      : radius_( radius )
+      , center_( center )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side, Point center = {} )
+      : side_( side )
+      , center_( center )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <variant>
+
+using Shape = std::variant<Circle,Square>;
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+using Shapes = std::vector<Shape>;
+
+
+//---- <HalfExtent.h> -----------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+
+// Returns the distance from the center of a shape to the border of its bounding box
+class HalfExtent
+{
+ public:
+   double operator()( Circle const& c ) const { return c.radius(); }
+   double operator()( Square const& s ) const { return 0.5 * s.side(); }
+};
+
+
+//---- <BoundingBox.h> ----------------------------------------------------------------------------
+
+//#include <HalfExtent.h>
+//#include <Rect.h>
+//#include <Shape.h>
+#include <variant>
+
+inline Rect boundingBox( Shape const& shape )
+{
+   Point  const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+   double const extent( std::visit( HalfExtent{}, shape ) );
+
+   return Rect{ Point{ center.x - extent, center.y - extent }
+              , Point{ center.x + extent, center.y + extent } };
+}
+
+
+//---- <ShapeGrid.h> ------------------------------------------------------------------------------
+
+//#include <HalfExtent.h>
+//#include <Rect.h>
+//#include <Shapes.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// A uniform grid over the shapes of a 'Shapes' collection. The grid only stores the indices
+// of the shapes: every shape is registered in the single cell that contains its center. Shapes
+// outside of the bounds of the grid are registered in the nearest border cell. Since a shape
+// may reach into the neighboring cells, a query enlarges the given rectangle by the largest
+// half extent of all registered shapes. Inserting and updating a shape is O(1), unless the
+// largest shape shrinks, which requires a linear scan for the new largest half extent. A query
+// only touches the cells overlapping the (enlarged) rectangle.
+class ShapeGrid
+{
+ public:
+   ShapeGrid( Rect bounds, double cellSize )
+      : bounds_( bounds )
+      , cellSize_( cellSize )
+      , columns_( cellCount( bounds.lower.x, bounds.upper.x, cellSize ) )
+      , rows_   ( cellCount( bounds.lower.y, bounds.upper.y, cellSize ) )
+      , cells_( columns_*rows_ )
+   {}
+
+   // Registers all shapes of the given collection
+   void build( Shapes const& shapes )
+   {
+      clear();
+      entries_.reserve( shapes.size() );
+      for( size_t index=0U; index<shapes.size(); ++index ) {
+         insert( index, shapes[index] );
+      }
+   }
+
+   // Registers the shape with the given index. In case the shape is already registered, its
+   // registration is updated instead.
+   void insert( size_t index, Shape const& shape )
+   {
+      if( index >= entries_.size() ) {
+         entries_.resize( index+1U );
+      }
+      if( entries_[index].cell != unregistered ) {
+         update( index, shape );
+         return;
+      }
+      add( index, cellOf( shape ) );
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   // Updates the registration of the shape with the given index after it has been moved or
+   // resized. The shape must have been inserted before.
+   void update( size_t index, Shape const& shape )
+   {
+      size_t const cell( cellOf( shape ) );
+      if( cell != entries_[index].cell ) {
+         remove( index );
+         add( index, cell );
+      }
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   void clear()
+   {
+      for( auto& cell : cells_ ) {
+         cell.clear();
+      }
+      entries_.clear();
+      maxExtent_ = 0.0;
+   }
+
+   // Calls the given operation for all shapes whose bounding box intersects the given rectangle
+   template< typename Op >
+   void query( Rect const& rect, Shapes const& shapes, Op op ) const
+   {
+      Rect const area{ Point{ rect.lower.x - maxExtent_, rect.lower.y - maxExtent_ }
+                     , Point{ rect.upper.x + maxExtent_, rect.upper.y + maxExtent_ } };
+
+      size_t const firstColumn( column( area.lower.x ) );
+      size_t const lastColumn ( column( area.upper.x ) );
+      size_t const firstRow   ( row( area.lower.y ) );
+      size_t const lastRow    ( row( area.upper.y ) );
+
+      for( size_t r=firstRow; r<=lastRow; ++r ) {
+         for( size_t c=firstColumn; c<=lastColumn; ++c ) {
+            for( size_t index : cells_[r*columns_+c] ) {
+               Shape const& shape( shapes[index] );
+               if( intersects( boundingBox( shape ), rect ) ) {
+                  op( shape );
+               }
+            }
+         }
+      }
+   }
+
+ private:
+   static constexpr size_t unregistered = static_cast<size_t>( -1 );
+   static constexpr size_t maxCells = size_t{1U} << 16U;  // Maximum number of cells per dimension
+
+   struct Entry
+   {
+      size_t cell{ unregistered };  // Index of the cell containing the shape
+      size_t slot{};                // Position of the shape index within the cell
+      double extent{};              // Half extent of the shape
+   };
+
+   static size_t cellCount( double lower, double upper, double cellSize )
+   {
+      double const count( std::ceil( ( upper - lower ) / cellSize ) );
+      if( !( cellSize > 0.0 ) || !( count <= static_cast<double>( maxCells ) ) ) {
+         throw std::invalid_argument( "Invalid grid size" );
+      }
+      return ( count > 1.0 ) ? static_cast<size_t>( count ) : 1U;
+   }
+
+   // Maps the given coordinate to a column or row. The range check is performed in floating
+   // point, since converting a value that is out of the range of size_t is undefined.
+   size_t clamp( double value, double lower, size_t count ) const
+   {
+      double const c( std::floor( ( value - lower ) / cellSize_ ) );
+      if( !( c > 0.0 ) ) return 0U;  // Also handles NaN
+      if( c >= static_cast<double>( count-1U ) ) return count-1U;
+      return static_cast<size_t>( c );
+   }
+
+   size_t column( double x ) const { return clamp( x, bounds_.lower.x, columns_ ); }
+   size_t row   ( double y ) const { return clamp( y, bounds_.lower.y, rows_ ); }
+
+   size_t cellOf( Shape const& shape ) const
+   {
+      Point const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+      return row( center.y )*columns_ + column( center.x );
+   }
+
+   void add( size_t index, size_t cell )
+   {
+      entries_[index].cell = cell;
+      entries_[index].slot = cells_[cell].size();
+      cells_[cell].push_back( index );
+   }
+
+   // Swap-and-pop removal of the shape index from its current cell
+   void remove( size_t index )
+   {
+      Entry const entry( entries_[index] );
+      std::vector<size_t>& cell( cells_[entry.cell] );
+
+      size_t const last( cell.back() );
+      cell[entry.slot] = last;
+      entries_[last].slot = entry.slot;
+      cell.pop_back();
+   }
+
+   // Records the half extent of the shape with the given index. In case the largest shape
+   // shrinks, the largest half extent is recomputed.
+   void resize( size_t index, double extent )
+   {
+      double const previous( std::exchange( entries_[index].extent, extent ) );
+      if( extent >= maxExtent_ ) {
+         maxExtent_ = extent;
+      }
+      else if( previous == maxExtent_ ) {
+         maxExtent_ = 0.0;
+         for( Entry const& entry : entries_ ) {
+            maxExtent_ = std::max( maxExtent_, entry.extent );
+         }
+      }
+   }
+
+   Rect bounds_;
+   double cellSize_;
+   size_t columns_;
+   size_t rows_;
+   std::vector<std::vector<size_t>> cells_;
+   std::vector<Entry> entries_;
+   double maxExtent_{};
+};
+
+
+//---- <TrackedShapes.h> --------------------------------------------------------------------------
+
+//#include <BoundingBox.h>
+//#include <Rect.h>
+//#include <ShapeGrid.h>
+//#include <Shapes.h>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// A collection of shapes that keeps track of the shapes that changed since the last draw. All
+// changes have to be applied by means of add() and modify(). A dirty bitset next to the shapes
+// marks the changed shapes. For every changed shape, both the bounding box at the time of the
+// last draw and its current bounding box are part of the dirty region. drawDirty() redraws
+// only the shapes overlapping the dirty region, which are determined by one query of the
+// spatial index per dirty rectangle. Thus the cost of a redraw depends on the number of
+// changes, not on the total number of shapes. Since a redrawn shape may reach beyond the dirty
+// region and overlap shapes that are not redrawn, every shape is drawn clipped to the dirty
+// rectangles it overlaps.
+class TrackedShapes
+{
+ public:
+   TrackedShapes( Rect bounds, double cellSize )
+      : grid_( bounds, cellSize )
+   {}
+
+   size_t add( Shape shape )
+   {
+      size_t const index( shapes_.size() );
+      shapes_.push_back( std::move(shape) );
+      dirty_.push_back( true );
+      changed_.push_back( index );
+      previous_.push_back( boundingBox( shapes_.back() ) );  // Only the current area is dirty
+      grid_.insert( index, shapes_.back() );
+      return index;
+   }
+
+   // Applies the given modification (e.g. a translation) to the shape with the given index
+   template< typename Modifier >
+   void modify( size_t index, Modifier modifier )
+   {
+      // Only the first change since the last draw determines the previously drawn area
+      if( !dirty_[index] ) {
+         dirty_[index] = true;
+         changed_.push_back( index );
+         previous_.push_back( boundingBox( shapes_[index] ) );
+      }
+
+      std::visit( modifier, shapes_[index] );
+      grid_.update( index, shapes_[index] );
+   }
+
+   size_t size() const { return shapes_.size(); }
+
+   Shape const& operator[]( size_t index ) const { return shapes_[index]; }
+
+   // Returns the dirty region as a set of rectangles, e.g. in order to clear the background.
+   // In case the previous and the current bounding box of a changed shape overlap (as for
+   // instance for small movements), the region contains their union; otherwise it contains
+   // both bounding boxes.
+   std::vector<Rect> dirtyRegion() const
+   {
+      std::vector<Rect> region{};
+      region.reserve( changed_.size() );
+      for( size_t i=0U; i<changed_.size(); ++i )
+      {
+         Rect const& previous( previous_[i] );
+         Rect const current( boundingBox( shapes_[changed_[i]] ) );
+
+         if( intersects( previous, current ) ) {
+            region.push_back( Rect{ Point{ std::min( previous.lower.x, current.lower.x )
+                                         , std::min( previous.lower.y, current.lower.y ) }
+                                  , Point{ std::max( previous.upper.x, current.upper.x )
+                                         , std::max( previous.upper.y, current.upper.y ) } } );
+         }
+         else {
+            region.push_back( previous );
+            region.push_back( current );
+         }
+      }
+      return region;
+   }
+
+   // Draws all shapes and resets the change tracking
+   template< typename Op >
+   void drawAll( Op op )
+   {
+      for( Shape const& shape : shapes_ ) {
+         op( shape );
+      }
+      reset();
+   }
+
+   // Draws all shapes overlapping the dirty region and resets the change tracking. The given
+   // operation is called as 'op( shape, clip )' once per dirty rectangle overlapped by the
+   // shape and must not draw outside of the clip rectangle. The background of the dirty region
+   // is expected to be cleared beforehand. Returns the number of drawn shapes.
+   template< typename Op >
+   size_t drawDirty( Op op )
+   {
+      std::vector<Rect> const region( dirtyRegion() );
+
+      // Pairs of the index of a shape and the index of a dirty rectangle it overlaps. Since
+      // every shape is registered in a single cell, a query reports each shape at most once.
+      std::vector<std::pair<size_t,size_t>> hits{};
+      for( size_t rect=0U; rect<region.size(); ++rect ) {
+         grid_.query( region[rect], shapes_, [&]( Shape const& shape ){
+            hits.emplace_back( static_cast<size_t>( &shape - shapes_.data() ), rect );
+         } );
+      }
+
+      // Drawing the shapes in the order of insertion retains the overlap of the shapes, also
+      // in the areas where several dirty rectangles overlap
+      std::sort( begin(hits), end(hits) );
+      size_t drawn{};
+      for( size_t i=0U; i<hits.size(); ++i ) {
+         auto const [index,rect] = hits[i];
+         if( i == 0U || hits[i-1U].first != index ) {
+            ++drawn;
+         }
+         op( shapes_[index], region[rect] );
+      }
+
+      reset();
+      return drawn;
+   }
+
+ private:
+   void reset()
+   {
+      for( size_t index : changed_ ) {
+         dirty_[index] = false;
+      }
+      changed_.clear();
+      previous_.clear();
+   }
+
+   Shapes shapes_{};
+   ShapeGrid grid_;
+   std::vector<bool> dirty_{};      // The dirty bitset, one bit per shape
+   std::vector<size_t> changed_{};  // Indices of the changed shapes
+   std::vector<Rect> previous_{};   // Bounding boxes of the changed shapes at the last draw
+};
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+class Draw
+{
+ public:
+   void operator()( Circle const& c ) const
+   {
+      /* ... Implementing the logic for drawing a circle ... */
+   }
+   void operator()( Square const& s ) const
+   {
+      /* ... Implementing the logic for drawing a square ... */
+   }
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <BoundingBox.h>
+//#include <Circle.h>
+//#include <Draw.h>
+//#include <Square.h>
+//#include <TrackedShapes.h>
+#include <algorithm>
+#include <cstdlib>
+#include <variant>
+#include <vector>
+
+// A coarse raster, which records the last shape drawn on each pixel. A shape covers all pixels
+// whose center lies within its bounding box and within the clip rectangle.
+class Raster
+{
+ public:
+   static constexpr int size = 32;
+
+   void clear( Rect const& clip ) { paint( nullptr, clip ); }
+
+   void draw( Shape const& shape, Rect const& clip )
+   {
+      Rect const box( boundingBox( shape ) );
+      paint( &shape, Rect{ Point{ std::max( box.lower.x, clip.lower.x )
+                                , std::max( box.lower.y, clip.lower.y ) }
+                         , Point{ std::min( box.upper.x, clip.upper.x )
+                                , std::min( box.upper.y, clip.upper.y ) } } );
+   }
+
+   bool operator==( Raster const& ) const = default;
+
+ private:
+   void paint( Shape const* shape, Rect const& area )
+   {
+      for( int y=0; y<size; ++y ) {
+         for( int x=0; x<size; ++x ) {
+            double const cx( x + 0.5 );
+            double const cy( y + 0.5 );
+            if( area.lower.x <= cx && cx <= area.upper.x &&
+                area.lower.y <= cy && cy <= area.upper.y ) {
+               pixels_[y*size+x] = shape;
+            }
+         }
+      }
+   }
+
+   std::vector<Shape const*> pixels_ = std::vector<Shape const*>( size*size, nullptr );
+};
+
+int main()
+{
+   TrackedShapes shapes( Rect{ Point{ 0.0, 0.0 }, Point{ 160.0, 160.0 } }, 16.0 );
+
+   shapes.add( Circle{ 2.3, Point{  10.0,  10.0 } } );
+   shapes.add( Square{ 1.2, Point{  11.0,  11.0 } } );  // Overlapping with the first circle
+   shapes.add( Circle{ 4.1, Point{ 120.0,  80.0 } } );
+   shapes.add( Square{ 3.0, Point{  60.0, 140.0 } } );
+
+   auto const draw = []( Shape const& shape ){ std::visit( Draw{}, shape ); };
+   auto const drawClipped = []( Shape const& shape, Rect const& /*clip*/ ){
+      std::visit( Draw{}, shape );  // Drawing the shape restricted to the clip rectangle
+   };
+
+   // Initially drawing all shapes
+   shapes.drawAll( draw );
+
+   // Moving the first circle; the overlapping square has to be redrawn as well
+   shapes.modify( 0U, []( auto& s ){ s.translate( Point{ 0.5, 0.0 } ); } );
+   size_t const redrawn( shapes.drawDirty( drawClipped ) );
+
+   // Without any changes, nothing needs to be redrawn
+   size_t const unchanged( shapes.drawDirty( drawClipped ) );
+
+   // Three overlapping shapes, of which only the middle one moves. The first square overlaps
+   // both the dirty region and the last square, which does not overlap the dirty region and is
+   // therefore not redrawn. Drawing the first square unclipped would paint over the last one.
+   TrackedShapes layers( Rect{ Point{ 0.0, 0.0 }, Point{ 32.0, 32.0 } }, 8.0 );
+   layers.add( Square{ 12.0, Point{ 12.0, 12.0 } } );
+   layers.add( Circle{  2.0, Point{  8.0, 12.0 } } );
+   layers.add( Square{  6.0, Point{ 19.0, 12.0 } } );
+
+   Raster frame{};
+   layers.drawAll( [&]( Shape const& shape ){
+      frame.draw( shape, Rect{ Point{ 0.0, 0.0 }, Point{ Raster::size, Raster::size } } );
+   } );
+
+   layers.modify( 1U, []( auto& s ){ s.translate( Point{ 0.5, 0.0 } ); } );
+   for( Rect const& rect : layers.dirtyRegion() ) {
+      frame.clear( rect );
+   }
+   size_t const layered( layers.drawDirty( [&]( Shape const& shape, Rect const& clip ){
+      frame.draw( shape, clip );
+   } ) );
+
+   // The partially redrawn frame has to match a completely redrawn frame
+   Raster expected{};
+   layers.drawAll( [&]( Shape const& shape ){
+      expected.draw( shape, Rect{ Point{ 0.0, 0.0 }, Point{ Raster::size, Raster::size } } );
+   } );
+
+   return ( redrawn == 2U && unchanged == 0U && layered == 2U && frame == expected )
+          ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
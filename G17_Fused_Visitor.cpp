@@ -0,0 +1,228 @@
+/**************************************************************************************************
+*
+* \file G17_Fused_Visitor.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <variant>
+
+using Shape = std::variant<Circle,Square>;
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+using Shapes = std::vector<Shape>;
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+class Draw
+{
+ public:
+   void operator()( Circle const& c ) const
+   {
+      /* ... Implementing the logic for drawing a circle ... */
+   }
+   void operator()( Square const& s ) const
+   {
+      /* ... Implementing the logic for drawing a square ... */
+   }
+};
+
+
+//---- <Area.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <numbers>
+
+class Area
+{
+ public:
+   void operator()( Circle const& c ) { total_ += std::numbers::pi * c.radius() * c.radius(); }
+   void operator()( Square const& s ) { total_ += s.side() * s.side(); }
+
+   double total() const { return total_; }
+
+ private:
+   double total_{};
+};
+
+
+//---- <Translate.h> ------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Translate
+{
+ public:
+   explicit Translate( Point offset )
+      : offset_( offset )
+   {}
+
+   template< typename ShapeT >
+   void operator()( ShapeT& shape ) const { shape.translate( offset_ ); }
+
+ private:
+   Point offset_;
+};
+
+
+//---- <Fuse.h> -----------------------------------------------------------------------------------
+
+#include <functional>
+#include <tuple>
+#include <utility>
+
+// Combines several visitors into a single visitor, which applies all of them, one after
+// another, to the currently visited alternative. Thus several operations are performed
+// within a single traversal of the shapes, while every shape is still hot in the cache.
+// Visitors passed as lvalues are stored by reference, i.e. their state can be inspected
+// after the traversal; visitors passed as rvalues are stored by value.
+template< typename... Visitors >
+class Fused
+{
+ public:
+   template< typename... Vs >
+   explicit Fused( Vs&&... visitors )
+      : visitors_( std::forward<Vs>(visitors)... )
+   {}
+
+   template< typename T >
+   void operator()( T&& t )
+   {
+      std::apply( [&t]( auto&... v ){ ( std::invoke( v, t ), ... ); }, visitors_ );
+   }
+
+ private:
+   std::tuple<Visitors...> visitors_;
+};
+
+template< typename... Visitors >
+Fused<Visitors...> fuse( Visitors&&... visitors )
+{
+   return Fused<Visitors...>( std::forward<Visitors>(visitors)... );
+}
+
+
+//---- <VisitAllShapes.h> -------------------------------------------------------------------------
+
+//#include <Shapes.h>
+#include <variant>
+
+template< typename Visitor >
+void visitAllShapes( Shapes& shapes, Visitor&& visitor )
+{
+   for( auto& shape : shapes )
+   {
+      std::visit( visitor, shape );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Area.h>
+//#include <Circle.h>
+//#include <Draw.h>
+//#include <Fuse.h>
+//#include <Shapes.h>
+//#include <Square.h>
+//#include <Translate.h>
+//#include <VisitAllShapes.h>
+#include <cstdlib>
+
+int main()
+{
+   Shapes shapes;
+
+   shapes.emplace_back( Circle{ 2.3 } );
+   shapes.emplace_back( Square{ 1.2 } );
+   shapes.emplace_back( Circle{ 4.1 } );
+
+   // Translating and drawing all shapes and computing their total area in a single pass
+   Area area{};
+   visitAllShapes( shapes, fuse( Translate{ Point{ 1.0, 2.0 } }, Draw{}, area ) );
+
+   // Computing the total area in a separate pass
+   Area reference{};
+   visitAllShapes( shapes, reference );
+
+   return ( area.total() == reference.total() ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
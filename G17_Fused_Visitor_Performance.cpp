@@ -0,0 +1,222 @@
+/**************************************************************************************************
+*
+* \file G17_Fused_Visitor_Performance.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to apply three
+* operations (translate, draw and area) to all shapes in a std::vector of std::variants, once
+* by means of three consecutive passes and once by means of a single pass with a fused visitor.
+* The 'bytes_per_second' counter reports the nominal memory traffic, i.e. one traversal of the
+* std::vector of shapes per pass.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <numbers>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 10000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 10000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_SEQUENTIAL_PASSES 1  // One pass per operation
+#define BENCHMARK_FUSED_PASS        1  // A single pass with a fused visitor
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+using Shape  = std::variant<Circle,Square>;
+using Shapes = std::vector<Shape>;
+
+Shapes createShapes( size_t size )
+{
+   Shapes shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      if( is_circle() ) shapes.emplace_back( Circle{ get_random_size() } );
+      else              shapes.emplace_back( Square{ get_random_size() } );
+   }
+   return shapes;
+}
+
+
+//---- Operations ---------------------------------------------------------------------------------
+
+class Draw
+{
+ public:
+   void operator()( Circle const& c ) const { benchmark::DoNotOptimize( c.radius() ); }
+   void operator()( Square const& s ) const { benchmark::DoNotOptimize( s.side() ); }
+};
+
+class Area
+{
+ public:
+   void operator()( Circle const& c ) { total_ += std::numbers::pi * c.radius() * c.radius(); }
+   void operator()( Square const& s ) { total_ += s.side() * s.side(); }
+
+   double total() const { return total_; }
+
+ private:
+   double total_{};
+};
+
+class Translate
+{
+ public:
+   explicit Translate( Point offset ) : offset_( offset ) {}
+
+   template< typename ShapeT >
+   void operator()( ShapeT& shape ) const { shape.translate( offset_ ); }
+
+ private:
+   Point offset_;
+};
+
+
+//---- Fused visitor ------------------------------------------------------------------------------
+
+template< typename... Visitors >
+class Fused
+{
+ public:
+   template< typename... Vs >
+   explicit Fused( Vs&&... visitors ) : visitors_( std::forward<Vs>(visitors)... ) {}
+
+   template< typename T >
+   void operator()( T&& t )
+   {
+      std::apply( [&t]( auto&... v ){ ( std::invoke( v, t ), ... ); }, visitors_ );
+   }
+
+ private:
+   std::tuple<Visitors...> visitors_;
+};
+
+template< typename... Visitors >
+Fused<Visitors...> fuse( Visitors&&... visitors )
+{
+   return Fused<Visitors...>( std::forward<Visitors>(visitors)... );
+}
+
+template< typename Visitor >
+void visitAllShapes( Shapes& shapes, Visitor&& visitor )
+{
+   for( auto& shape : shapes ) {
+      std::visit( visitor, shape );
+   }
+}
+
+
+//---- Benchmark for sequential passes ------------------------------------------------------------
+
+static void sequentialPasses(benchmark::State& state)
+{
+   Shapes shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      Area area{};
+      visitAllShapes( shapes, Translate{ Point{ 1.0, -1.0 } } );
+      visitAllShapes( shapes, Draw{} );
+      visitAllShapes( shapes, area );
+      benchmark::DoNotOptimize( area.total() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.SetBytesProcessed( 3 * state.iterations() * state.range(0) * sizeof(Shape) );
+}
+#if BENCHMARK_SEQUENTIAL_PASSES
+BENCHMARK(sequentialPasses)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for a single fused pass ----------------------------------------------------------
+
+static void fusedPass(benchmark::State& state)
+{
+   Shapes shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      Area area{};
+      visitAllShapes( shapes, fuse( Translate{ Point{ 1.0, -1.0 } }, Draw{}, area ) );
+      benchmark::DoNotOptimize( area.total() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.SetBytesProcessed( state.iterations() * state.range(0) * sizeof(Shape) );
+}
+#if BENCHMARK_FUSED_PASS
+BENCHMARK(fusedPass)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
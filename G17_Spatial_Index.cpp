@@ -0,0 +1,422 @@
+/**************************************************************************************************
+*
+* \file G17_Spatial_Index.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Rect.h> -----------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+// An axis-aligned rectangle, e.g. a bounding box or a viewport
+struct Rect
+{
+   Point lower;
+   Point upper;
+};
+
+inline bool intersects( Rect const& a, Rect const& b )
+{
+   return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+          a.lower.y <= b.upper.y && b.lower.y <= a.upper.y;
+}
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius, Point center = {} )
+      : radius_( radius )
+      , center_( center )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side, Point center = {} )
+      : side_( side )
+      , center_( center )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <variant>
+
+using Shape = std::variant<Circle,Square>;
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+using Shapes = std::vector<Shape>;
+
+
+//---- <HalfExtent.h> -----------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+
+// Returns the distance from the center of a shape to the border of its bounding box
+class HalfExtent
+{
+ public:
+   double operator()( Circle const& c ) const { return c.radius(); }
+   double operator()( Square const& s ) const { return 0.5 * s.side(); }
+};
+
+
+//---- <BoundingBox.h> ----------------------------------------------------------------------------
+
+//#include <HalfExtent.h>
+//#include <Rect.h>
+//#include <Shape.h>
+#include <variant>
+
+inline Rect boundingBox( Shape const& shape )
+{
+   Point  const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+   double const extent( std::visit( HalfExtent{}, shape ) );
+
+   return Rect{ Point{ center.x - extent, center.y - extent }
+              , Point{ center.x + extent, center.y + extent } };
+}
+
+
+//---- <ShapeGrid.h> ------------------------------------------------------------------------------
+
+//#include <HalfExtent.h>
+//#include <Rect.h>
+//#include <Shapes.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// A uniform grid over the shapes of a 'Shapes' collection. The grid only stores the indices
+// of the shapes: every shape is registered in the single cell that contains its center. Shapes
+// outside of the bounds of the grid are registered in the nearest border cell. Since a shape
+// may reach into the neighboring cells, a query enlarges the given rectangle by the largest
+// half extent of all registered shapes. Inserting and updating a shape is O(1), unless the
+// largest shape shrinks, which requires a linear scan for the new largest half extent. A query
+// only touches the cells overlapping the (enlarged) rectangle.
+class ShapeGrid
+{
+ public:
+   ShapeGrid( Rect bounds, double cellSize )
+      : bounds_( bounds )
+      , cellSize_( cellSize )
+      , columns_( cellCount( bounds.lower.x, bounds.upper.x, cellSize ) )
+      , rows_   ( cellCount( bounds.lower.y, bounds.upper.y, cellSize ) )
+      , cells_( columns_*rows_ )
+   {}
+
+   // Registers all shapes of the given collection
+   void build( Shapes const& shapes )
+   {
+      clear();
+      entries_.reserve( shapes.size() );
+      for( size_t index=0U; index<shapes.size(); ++index ) {
+         insert( index, shapes[index] );
+      }
+   }
+
+   // Registers the shape with the given index. In case the shape is already registered, its
+   // registration is updated instead.
+   void insert( size_t index, Shape const& shape )
+   {
+      if( index >= entries_.size() ) {
+         entries_.resize( index+1U );
+      }
+      if( entries_[index].cell != unregistered ) {
+         update( index, shape );
+         return;
+      }
+      add( index, cellOf( shape ) );
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   // Updates the registration of the shape with the given index after it has been moved or
+   // resized. The shape must have been inserted before.
+   void update( size_t index, Shape const& shape )
+   {
+      size_t const cell( cellOf( shape ) );
+      if( cell != entries_[index].cell ) {
+         remove( index );
+         add( index, cell );
+      }
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   void clear()
+   {
+      for( auto& cell : cells_ ) {
+         cell.clear();
+      }
+      entries_.clear();
+      maxExtent_ = 0.0;
+   }
+
+   // Calls the given operation for all shapes whose bounding box intersects the given rectangle
+   template< typename Op >
+   void query( Rect const& rect, Shapes const& shapes, Op op ) const
+   {
+      Rect const area{ Point{ rect.lower.x - maxExtent_, rect.lower.y - maxExtent_ }
+                     , Point{ rect.upper.x + maxExtent_, rect.upper.y + maxExtent_ } };
+
+      size_t const firstColumn( column( area.lower.x ) );
+      size_t const lastColumn ( column( area.upper.x ) );
+      size_t const firstRow   ( row( area.lower.y ) );
+      size_t const lastRow    ( row( area.upper.y ) );
+
+      for( size_t r=firstRow; r<=lastRow; ++r ) {
+         for( size_t c=firstColumn; c<=lastColumn; ++c ) {
+            for( size_t index : cells_[r*columns_+c] ) {
+               Shape const& shape( shapes[index] );
+               if( intersects( boundingBox( shape ), rect ) ) {
+                  op( shape );
+               }
+            }
+         }
+      }
+   }
+
+ private:
+   static constexpr size_t unregistered = static_cast<size_t>( -1 );
+   static constexpr size_t maxCells = size_t{1U} << 16U;  // Maximum number of cells per dimension
+
+   struct Entry
+   {
+      size_t cell{ unregistered };  // Index of the cell containing the shape
+      size_t slot{};                // Position of the shape index within the cell
+      double extent{};              // Half extent of the shape
+   };
+
+   static size_t cellCount( double lower, double upper, double cellSize )
+   {
+      double const count( std::ceil( ( upper - lower ) / cellSize ) );
+      if( !( cellSize > 0.0 ) || !( count <= static_cast<double>( maxCells ) ) ) {
+         throw std::invalid_argument( "Invalid grid size" );
+      }
+      return ( count > 1.0 ) ? static_cast<size_t>( count ) : 1U;
+   }
+
+   // Maps the given coordinate to a column or row. The range check is performed in floating
+   // point, since converting a value that is out of the range of size_t is undefined.
+   size_t clamp( double value, double lower, size_t count ) const
+   {
+      double const c( std::floor( ( value - lower ) / cellSize_ ) );
+      if( !( c > 0.0 ) ) return 0U;  // Also handles NaN
+      if( c >= static_cast<double>( count-1U ) ) return count-1U;
+      return static_cast<size_t>( c );
+   }
+
+   size_t column( double x ) const { return clamp( x, bounds_.lower.x, columns_ ); }
+   size_t row   ( double y ) const { return clamp( y, bounds_.lower.y, rows_ ); }
+
+   size_t cellOf( Shape const& shape ) const
+   {
+      Point const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+      return row( center.y )*columns_ + column( center.x );
+   }
+
+   void add( size_t index, size_t cell )
+   {
+      entries_[index].cell = cell;
+      entries_[index].slot = cells_[cell].size();
+      cells_[cell].push_back( index );
+   }
+
+   // Swap-and-pop removal of the shape index from its current cell
+   void remove( size_t index )
+   {
+      Entry const entry( entries_[index] );
+      std::vector<size_t>& cell( cells_[entry.cell] );
+
+      size_t const last( cell.back() );
+      cell[entry.slot] = last;
+      entries_[last].slot = entry.slot;
+      cell.pop_back();
+   }
+
+   // Records the half extent of the shape with the given index. In case the largest shape
+   // shrinks, the largest half extent is recomputed.
+   void resize( size_t index, double extent )
+   {
+      double const previous( std::exchange( entries_[index].extent, extent ) );
+      if( extent >= maxExtent_ ) {
+         maxExtent_ = extent;
+      }
+      else if( previous == maxExtent_ ) {
+         maxExtent_ = 0.0;
+         for( Entry const& entry : entries_ ) {
+            maxExtent_ = std::max( maxExtent_, entry.extent );
+         }
+      }
+   }
+
+   Rect bounds_;
+   double cellSize_;
+   size_t columns_;
+   size_t rows_;
+   std::vector<std::vector<size_t>> cells_;
+   std::vector<Entry> entries_;
+   double maxExtent_{};
+};
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+class Draw
+{
+ public:
+   void operator()( Circle const& c ) const
+   {
+      /* ... Implementing the logic for drawing a circle ... */
+   }
+   void operator()( Square const& s ) const
+   {
+      /* ... Implementing the logic for drawing a square ... */
+   }
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <Rect.h>
+//#include <ShapeGrid.h>
+//#include <Shapes.h>
+
+void drawAllShapes( Shapes const& shapes );
+void drawAllShapes( Shapes const& shapes, ShapeGrid const& grid, Rect const& viewport );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Draw.h>
+#include <variant>
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      std::visit( Draw{}, shape );
+   }
+}
+
+// Draws only the shapes that are (partially) visible within the given viewport
+void drawAllShapes( Shapes const& shapes, ShapeGrid const& grid, Rect const& viewport )
+{
+   grid.query( viewport, shapes, []( Shape const& shape ){ std::visit( Draw{}, shape ); } );
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shapes.h>
+//#include <ShapeGrid.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+#include <limits>
+#include <variant>
+
+int main()
+{
+   Shapes shapes;
+
+   shapes.emplace_back( Circle{ 2.3, Point{  10.0,  10.0 } } );
+   shapes.emplace_back( Square{ 1.2, Point{  50.0,  20.0 } } );
+   shapes.emplace_back( Circle{ 4.1, Point{ 120.0,  80.0 } } );
+   shapes.emplace_back( Square{ 3.0, Point{ -10.0, 200.0 } } );  // Outside of the grid bounds
+
+   ShapeGrid grid( Rect{ Point{ 0.0, 0.0 }, Point{ 160.0, 160.0 } }, 16.0 );
+   grid.build( shapes );
+
+   Rect const viewport{ Point{ 0.0, 0.0 }, Point{ 60.0, 40.0 } };
+
+   // Drawing only the visible shapes
+   drawAllShapes( shapes, grid, viewport );
+
+   // Moving the third shape into the viewport and updating the grid accordingly
+   std::visit( []( auto& s ){ s.translate( Point{ -80.0, -60.0 } ); }, shapes[2] );
+   grid.update( 2U, shapes[2] );
+
+   size_t visible{};
+   grid.query( viewport, shapes, [&visible]( Shape const& ){ ++visible; } );
+
+   // Inserting an already registered shape updates its registration instead of duplicating it
+   grid.insert( 2U, shapes[2] );
+
+   // An unbounded viewport is clamped to the grid and contains all shapes
+   double const inf( std::numeric_limits<double>::infinity() );
+   Rect const everything{ Point{ -inf, -inf }, Point{ inf, inf } };
+
+   size_t all{};
+   grid.query( everything, shapes, [&all]( Shape const& ){ ++all; } );
+
+   return ( visible == 3U && all == shapes.size() ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,414 @@
+/**************************************************************************************************
+*
+* \file G17_Spatial_Index_Performance.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to draw the
+* shapes within a viewport covering 1% of the scene, once by drawing all shapes, once by
+* testing the bounding box of every shape, and once by querying a uniform grid. Additionally
+* benchmark the time to move 1% of the shapes and to update the grid accordingly.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 100000 );    // Minimum size of the generated containers
+constexpr size_t maxSize( 10000000 );  // Maximum size of the generated containers
+
+constexpr double sceneSize( 10000.0 );  // Width and height of the scene
+constexpr double viewSize ( 1000.0 );   // Width and height of the viewport (1% of the scene)
+constexpr double shapesPerCell( 4.0 );  // Average number of shapes per grid cell
+
+#define BENCHMARK_DRAW_ALL     1  // Drawing all shapes
+#define BENCHMARK_DRAW_LINEAR  1  // Testing the bounding box of every shape
+#define BENCHMARK_DRAW_GRID    1  // Querying the uniform grid
+#define BENCHMARK_UPDATE_GRID  1  // Moving 1% of the shapes and updating the grid
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::uniform_real_distribution<double> position( 0.0, sceneSize );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+double get_random_position()
+{
+   return position( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+struct Rect
+{
+   Point lower;
+   Point upper;
+};
+
+inline bool intersects( Rect const& a, Rect const& b )
+{
+   return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+          a.lower.y <= b.upper.y && b.lower.y <= a.upper.y;
+}
+
+class Circle
+{
+ public:
+   explicit Circle( double radius, Point center ) : radius_( radius ), center_( center ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double radius_;
+   Point center_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side, Point center ) : side_( side ), center_( center ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+   void translate( Point offset ) { center_.x += offset.x; center_.y += offset.y; }
+
+ private:
+   double side_;
+   Point center_;
+};
+
+using Shape  = std::variant<Circle,Square>;
+using Shapes = std::vector<Shape>;
+
+Shapes createShapes( size_t size )
+{
+   Shapes shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      Point const center{ get_random_position(), get_random_position() };
+      if( is_circle() ) shapes.emplace_back( Circle{ get_random_size(), center } );
+      else              shapes.emplace_back( Square{ get_random_size(), center } );
+   }
+   return shapes;
+}
+
+struct Draw
+{
+   void operator()( Circle const& c ) const { benchmark::DoNotOptimize( c.radius() ); }
+   void operator()( Square const& s ) const { benchmark::DoNotOptimize( s.side() ); }
+};
+
+struct HalfExtent
+{
+   double operator()( Circle const& c ) const { return c.radius(); }
+   double operator()( Square const& s ) const { return 0.5 * s.side(); }
+};
+
+inline Rect boundingBox( Shape const& shape )
+{
+   Point  const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+   double const extent( std::visit( HalfExtent{}, shape ) );
+
+   return Rect{ Point{ center.x - extent, center.y - extent }
+              , Point{ center.x + extent, center.y + extent } };
+}
+
+Rect const viewport{ Point{ 0.5*( sceneSize-viewSize ), 0.5*( sceneSize-viewSize ) }
+                   , Point{ 0.5*( sceneSize+viewSize ), 0.5*( sceneSize+viewSize ) } };
+
+
+//---- Uniform grid -------------------------------------------------------------------------------
+
+class ShapeGrid
+{
+ public:
+   ShapeGrid( Rect bounds, double cellSize )
+      : bounds_( bounds )
+      , cellSize_( cellSize )
+      , columns_( cellCount( bounds.lower.x, bounds.upper.x, cellSize ) )
+      , rows_   ( cellCount( bounds.lower.y, bounds.upper.y, cellSize ) )
+      , cells_( columns_*rows_ )
+   {}
+
+   void build( Shapes const& shapes )
+   {
+      clear();
+      entries_.reserve( shapes.size() );
+      for( size_t index=0U; index<shapes.size(); ++index ) {
+         insert( index, shapes[index] );
+      }
+   }
+
+   void insert( size_t index, Shape const& shape )
+   {
+      if( index >= entries_.size() ) {
+         entries_.resize( index+1U );
+      }
+      if( entries_[index].cell != unregistered ) {
+         update( index, shape );
+         return;
+      }
+      add( index, cellOf( shape ) );
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   void update( size_t index, Shape const& shape )
+   {
+      size_t const cell( cellOf( shape ) );
+      if( cell != entries_[index].cell ) {
+         remove( index );
+         add( index, cell );
+      }
+      resize( index, std::visit( HalfExtent{}, shape ) );
+   }
+
+   void clear()
+   {
+      for( auto& cell : cells_ ) {
+         cell.clear();
+      }
+      entries_.clear();
+      maxExtent_ = 0.0;
+   }
+
+   template< typename Op >
+   void query( Rect const& rect, Shapes const& shapes, Op op ) const
+   {
+      Rect const area{ Point{ rect.lower.x - maxExtent_, rect.lower.y - maxExtent_ }
+                     , Point{ rect.upper.x + maxExtent_, rect.upper.y + maxExtent_ } };
+
+      size_t const firstColumn( column( area.lower.x ) );
+      size_t const lastColumn ( column( area.upper.x ) );
+      size_t const firstRow   ( row( area.lower.y ) );
+      size_t const lastRow    ( row( area.upper.y ) );
+
+      for( size_t r=firstRow; r<=lastRow; ++r ) {
+         for( size_t c=firstColumn; c<=lastColumn; ++c ) {
+            for( size_t index : cells_[r*columns_+c] ) {
+               Shape const& shape( shapes[index] );
+               if( intersects( boundingBox( shape ), rect ) ) {
+                  op( shape );
+               }
+            }
+         }
+      }
+   }
+
+ private:
+   static constexpr size_t unregistered = static_cast<size_t>( -1 );
+   static constexpr size_t maxCells = size_t{1U} << 16U;
+
+   struct Entry
+   {
+      size_t cell{ unregistered };
+      size_t slot{};
+      double extent{};
+   };
+
+   static size_t cellCount( double lower, double upper, double cellSize )
+   {
+      double const count( std::ceil( ( upper - lower ) / cellSize ) );
+      if( !( cellSize > 0.0 ) || !( count <= static_cast<double>( maxCells ) ) ) {
+         throw std::invalid_argument( "Invalid grid size" );
+      }
+      return ( count > 1.0 ) ? static_cast<size_t>( count ) : 1U;
+   }
+
+   size_t clamp( double value, double lower, size_t count ) const
+   {
+      double const c( std::floor( ( value - lower ) / cellSize_ ) );
+      if( !( c > 0.0 ) ) return 0U;
+      if( c >= static_cast<double>( count-1U ) ) return count-1U;
+      return static_cast<size_t>( c );
+   }
+
+   size_t column( double x ) const { return clamp( x, bounds_.lower.x, columns_ ); }
+   size_t row   ( double y ) const { return clamp( y, bounds_.lower.y, rows_ ); }
+
+   size_t cellOf( Shape const& shape ) const
+   {
+      Point const center( std::visit( []( auto const& s ){ return s.center(); }, shape ) );
+      return row( center.y )*columns_ + column( center.x );
+   }
+
+   void add( size_t index, size_t cell )
+   {
+      entries_[index].cell = cell;
+      entries_[index].slot = cells_[cell].size();
+      cells_[cell].push_back( index );
+   }
+
+   void remove( size_t index )
+   {
+      Entry const entry( entries_[index] );
+      std::vector<size_t>& cell( cells_[entry.cell] );
+
+      size_t const last( cell.back() );
+      cell[entry.slot] = last;
+      entries_[last].slot = entry.slot;
+      cell.pop_back();
+   }
+
+   void resize( size_t index, double extent )
+   {
+      double const previous( std::exchange( entries_[index].extent, extent ) );
+      if( extent >= maxExtent_ ) {
+         maxExtent_ = extent;
+      }
+      else if( previous == maxExtent_ ) {
+         maxExtent_ = 0.0;
+         for( Entry const& entry : entries_ ) {
+            maxExtent_ = std::max( maxExtent_, entry.extent );
+         }
+      }
+   }
+
+   Rect bounds_;
+   double cellSize_;
+   size_t columns_;
+   size_t rows_;
+   std::vector<std::vector<size_t>> cells_;
+   std::vector<Entry> entries_;
+   double maxExtent_{};
+};
+
+ShapeGrid createGrid( Shapes const& shapes )
+{
+   double const cellSize( sceneSize / std::sqrt( shapes.size() / shapesPerCell ) );
+   ShapeGrid grid( Rect{ Point{ 0.0, 0.0 }, Point{ sceneSize, sceneSize } }, cellSize );
+   grid.build( shapes );
+   return grid;
+}
+
+
+//---- Benchmark for drawing all shapes -----------------------------------------------------------
+
+static void drawAll(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         std::visit( Draw{}, shape );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_DRAW_ALL
+BENCHMARK(drawAll)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for testing the bounding box of every shape --------------------------------------
+
+static void drawLinear(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         if( intersects( boundingBox( shape ), viewport ) ) {
+            std::visit( Draw{}, shape );
+         }
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_DRAW_LINEAR
+BENCHMARK(drawLinear)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for querying the uniform grid ----------------------------------------------------
+
+static void drawGrid(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+   ShapeGrid const grid( createGrid( shapes ) );
+
+   for( auto _ : state )
+   {
+      grid.query( viewport, shapes, []( Shape const& shape ){ std::visit( Draw{}, shape ); } );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_DRAW_GRID
+BENCHMARK(drawGrid)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for moving shapes and updating the grid ------------------------------------------
+
+static void updateGrid(benchmark::State& state)
+{
+   Shapes shapes( createShapes( state.range(0) ) );
+   ShapeGrid grid( createGrid( shapes ) );
+
+   std::uniform_int_distribution<size_t> pick( 0U, shapes.size()-1U );
+   std::vector<size_t> moved( shapes.size() / 100U );
+   std::generate( begin(moved), end(moved), [&pick]{ return pick( rng ); } );
+
+   double direction( 1.0 );
+
+   for( auto _ : state )
+   {
+      Point const offset{ 25.0*direction, -25.0*direction };
+      for( size_t index : moved ) {
+         std::visit( [offset]( auto& s ){ s.translate( offset ); }, shapes[index] );
+         grid.update( index, shapes[index] );
+      }
+      direction = -direction;
+   }
+
+   state.SetItemsProcessed( state.iterations() * moved.size() );
+}
+#if BENCHMARK_UPDATE_GRID
+BENCHMARK(updateGrid)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
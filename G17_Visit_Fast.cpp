@@ -0,0 +1,233 @@
+/**************************************************************************************************
+*
+* \file G17_Visit_Fast.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <variant>
+
+using Shape = std::variant<Circle,Square>;
+
+
+//---- <Shapes.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <vector>
+
+using Shapes = std::vector<Shape>;
+
+
+//---- <VisitFast.h> ------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace detail {
+
+template< typename Variant, typename T >
+decltype(auto) forwardAlternative( T& t )
+{
+   if constexpr( std::is_lvalue_reference_v<Variant> ) {
+      return ( t );
+   }
+   else {
+      return std::move( t );
+   }
+}
+
+} // namespace detail
+
+// A drop-in alternative to std::visit() for a single variant with up to 16 alternatives.
+// Instead of an indirect call via a table of function pointers, visit_fast() expands into a
+// switch on the index of the variant. Since every case is a direct call, the compiler is able
+// to inline the according function call operator of the visitor and to optimize the
+// surrounding code, e.g. to vectorize a loop.
+template< typename Visitor, typename Variant >
+decltype(auto) visit_fast( Visitor&& visitor, Variant&& variant )
+{
+   using V = std::remove_cvref_t<Variant>;
+   using R = std::invoke_result_t< Visitor
+                                 , decltype( std::get<0>( std::forward<Variant>(variant) ) ) >;
+   constexpr std::size_t N = std::variant_size_v<V>;
+
+   static_assert( N <= 16U, "visit_fast() supports variants with up to 16 alternatives" );
+
+#define VISIT_FAST_CASE( I ) \
+   case I: \
+      if constexpr( I < N ) { \
+         auto& alternative = *std::get_if<I>( &variant ); \
+         return static_cast<R>( std::invoke( std::forward<Visitor>(visitor) \
+                                           , detail::forwardAlternative<Variant>( alternative ) ) ); \
+      } \
+      break
+
+   switch( variant.index() )
+   {
+      VISIT_FAST_CASE(  0 ); VISIT_FAST_CASE(  1 ); VISIT_FAST_CASE(  2 ); VISIT_FAST_CASE(  3 );
+      VISIT_FAST_CASE(  4 ); VISIT_FAST_CASE(  5 ); VISIT_FAST_CASE(  6 ); VISIT_FAST_CASE(  7 );
+      VISIT_FAST_CASE(  8 ); VISIT_FAST_CASE(  9 ); VISIT_FAST_CASE( 10 ); VISIT_FAST_CASE( 11 );
+      VISIT_FAST_CASE( 12 ); VISIT_FAST_CASE( 13 ); VISIT_FAST_CASE( 14 ); VISIT_FAST_CASE( 15 );
+      default: break;
+   }
+
+#undef VISIT_FAST_CASE
+
+   // Only reachable in case the variant is valueless by exception
+   throw std::bad_variant_access{};
+}
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* some graphics library */
+
+class Draw
+{
+ public:
+   void operator()( Circle const& c ) const
+   {
+      /* ... Implementing the logic for drawing a circle ... */
+   }
+   void operator()( Square const& s ) const
+   {
+      /* ... Implementing the logic for drawing a square ... */
+   }
+};
+
+
+//---- <Area.h> -----------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+#include <numbers>
+
+class Area
+{
+ public:
+   double operator()( Circle const& c ) const { return std::numbers::pi * c.radius() * c.radius(); }
+   double operator()( Square const& s ) const { return s.side() * s.side(); }
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <Shapes.h>
+
+void drawAllShapes( Shapes const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Draw.h>
+//#include <VisitFast.h>
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      visit_fast( Draw{}, shape );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Area.h>
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shapes.h>
+//#include <DrawAllShapes.h>
+//#include <VisitFast.h>
+#include <cstdlib>
+
+int main()
+{
+   Shapes shapes;
+
+   shapes.emplace_back( Circle{ 2.3 } );
+   shapes.emplace_back( Square{ 1.2 } );
+   shapes.emplace_back( Circle{ 4.1 } );
+
+   drawAllShapes( shapes );
+
+   // Computing the total area by means of both std::visit() and visit_fast()
+   double total1{};
+   double total2{};
+   for( auto const& shape : shapes ) {
+      total1 += std::visit( Area{}, shape );
+      total2 += visit_fast( Area{}, shape );
+   }
+
+   return ( total1 == total2 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
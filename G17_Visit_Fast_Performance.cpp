@@ -0,0 +1,206 @@
+/**************************************************************************************************
+*
+* \file G17_Visit_Fast_Performance.cpp
+* \brief Guideline 17: Consider std::variant for Implementing Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to compute the
+* total area of all shapes in a std::vector of std::variants, once by means of std::visit()
+* and once by means of the switch-based visit_fast().
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <functional>
+#include <numbers>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_STD_VISIT  1  // std::visit()
+#define BENCHMARK_VISIT_FAST 1  // Switch-based visit_fast()
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+using Shape  = std::variant<Circle,Square>;
+using Shapes = std::vector<Shape>;
+
+Shapes createShapes( size_t size )
+{
+   Shapes shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      if( is_circle() ) shapes.emplace_back( Circle{ get_random_size() } );
+      else              shapes.emplace_back( Square{ get_random_size() } );
+   }
+   return shapes;
+}
+
+struct Area
+{
+   double operator()( Circle const& c ) const { return std::numbers::pi * c.radius() * c.radius(); }
+   double operator()( Square const& s ) const { return s.side() * s.side(); }
+};
+
+
+//---- visit_fast() -------------------------------------------------------------------------------
+
+namespace detail {
+
+template< typename Variant, typename T >
+decltype(auto) forwardAlternative( T& t )
+{
+   if constexpr( std::is_lvalue_reference_v<Variant> ) {
+      return ( t );
+   }
+   else {
+      return std::move( t );
+   }
+}
+
+} // namespace detail
+
+template< typename Visitor, typename Variant >
+decltype(auto) visit_fast( Visitor&& visitor, Variant&& variant )
+{
+   using V = std::remove_cvref_t<Variant>;
+   using R = std::invoke_result_t< Visitor
+                                 , decltype( std::get<0>( std::forward<Variant>(variant) ) ) >;
+   constexpr std::size_t N = std::variant_size_v<V>;
+
+   static_assert( N <= 16U, "visit_fast() supports variants with up to 16 alternatives" );
+
+#define VISIT_FAST_CASE( I ) \
+   case I: \
+      if constexpr( I < N ) { \
+         auto& alternative = *std::get_if<I>( &variant ); \
+         return static_cast<R>( std::invoke( std::forward<Visitor>(visitor) \
+                                           , detail::forwardAlternative<Variant>( alternative ) ) ); \
+      } \
+      break
+
+   switch( variant.index() )
+   {
+      VISIT_FAST_CASE(  0 ); VISIT_FAST_CASE(  1 ); VISIT_FAST_CASE(  2 ); VISIT_FAST_CASE(  3 );
+      VISIT_FAST_CASE(  4 ); VISIT_FAST_CASE(  5 ); VISIT_FAST_CASE(  6 ); VISIT_FAST_CASE(  7 );
+      VISIT_FAST_CASE(  8 ); VISIT_FAST_CASE(  9 ); VISIT_FAST_CASE( 10 ); VISIT_FAST_CASE( 11 );
+      VISIT_FAST_CASE( 12 ); VISIT_FAST_CASE( 13 ); VISIT_FAST_CASE( 14 ); VISIT_FAST_CASE( 15 );
+      default: break;
+   }
+
+#undef VISIT_FAST_CASE
+
+   throw std::bad_variant_access{};
+}
+
+
+//---- Benchmark for std::visit() -----------------------------------------------------------------
+
+static void totalAreaStdVisit(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      double total{};
+      for( auto const& shape : shapes ) {
+         total += std::visit( Area{}, shape );
+      }
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_STD_VISIT
+BENCHMARK(totalAreaStdVisit)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for visit_fast() -----------------------------------------------------------------
+
+static void totalAreaVisitFast(benchmark::State& state)
+{
+   Shapes const shapes( createShapes( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      double total{};
+      for( auto const& shape : shapes ) {
+         total += visit_fast( Area{}, shape );
+      }
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_VISIT_FAST
+BENCHMARK(totalAreaVisitFast)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
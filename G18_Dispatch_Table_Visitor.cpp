@@ -0,0 +1,269 @@
+/**************************************************************************************************
+*
+* \file G18_Dispatch_Table_Visitor.cpp
+* \brief Guideline 18: Beware the Performance of Acyclic Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <TypeId.h> ---------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+
+// Every visitable type is assigned a small, dense integral ID. The ID is assigned exactly
+// once, on first use, and doesn't require RTTI.
+inline std::size_t nextTypeId()
+{
+   static std::atomic<std::size_t> counter{ 0U };
+   return counter++;
+}
+
+template< typename T >
+std::size_t typeId()
+{
+   static std::size_t const id = nextTypeId();
+   return id;
+}
+
+
+//---- <DispatchTable.h> --------------------------------------------------------------------------
+
+#include <bit>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+class AbstractVisitor;
+
+// A compact open-addressing hash table, mapping type IDs to visit functions. Since type IDs
+// are dense, the table is small and collisions are rare, i.e. a lookup typically requires a
+// single probe.
+class DispatchTable
+{
+ public:
+   using VisitFunction = void(*)( AbstractVisitor const&, void const* );
+
+   DispatchTable( std::initializer_list< std::pair<std::size_t,VisitFunction> > entries )
+      : slots_( std::bit_ceil( 2U*entries.size() ) )
+      , mask_( slots_.size() - 1U )
+   {
+      for( auto const& [id,function] : entries ) {
+         std::size_t index = id & mask_;
+         while( slots_[index].function != nullptr ) {
+            index = ( index + 1U ) & mask_;
+         }
+         slots_[index] = Slot{ id, function };
+      }
+   }
+
+   VisitFunction find( std::size_t id ) const
+   {
+      for( std::size_t index = id & mask_; ; index = ( index + 1U ) & mask_ ) {
+         Slot const& slot = slots_[index];
+         if( slot.function == nullptr || slot.id == id ) return slot.function;
+      }
+   }
+
+ private:
+   struct Slot
+   {
+      std::size_t id{};
+      VisitFunction function{};
+   };
+
+   std::vector<Slot> slots_;
+   std::size_t mask_;
+};
+
+
+//---- <AbstractVisitor.h> ------------------------------------------------------------------------
+
+//#include <DispatchTable.h>
+//#include <TypeId.h>
+
+class AbstractVisitor
+{
+ public:
+   virtual ~AbstractVisitor() = default;
+
+   // Forwards the given object to the according visit() function of the concrete visitor,
+   // in case the visitor supports the type T
+   template< typename T >
+   void dispatch( T const& t ) const
+   {
+      if( auto const function = table_->find( typeId<T>() ) ) {
+         function( *this, &t );
+      }
+   }
+
+ protected:
+   explicit AbstractVisitor( DispatchTable const& table )
+      : table_( &table )
+   {}
+
+ private:
+   DispatchTable const* table_;
+};
+
+
+//---- <Visitor.h> --------------------------------------------------------------------------------
+
+//#include <AbstractVisitor.h>
+//#include <DispatchTable.h>
+//#include <TypeId.h>
+
+// Base class for all concrete visitors. The types supported by the visitor 'Derived' are
+// registered once in a single, static dispatch table, which is shared by all instances.
+template< typename Derived, typename... Ts >
+class Visitor : public AbstractVisitor
+{
+ protected:
+   Visitor()
+      : AbstractVisitor( table() )
+   {}
+
+   ~Visitor() override = default;
+
+ private:
+   template< typename T >
+   static void visitFunction( AbstractVisitor const& v, void const* t )
+   {
+      static_cast<Derived const&>( v ).visit( *static_cast<T const*>( t ) );
+   }
+
+   static DispatchTable const& table()
+   {
+      static DispatchTable const table{ { typeId<Ts>(), &visitFunction<Ts> }... };
+      return table;
+   }
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <AbstractVisitor.h>
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+
+   virtual void accept( AbstractVisitor const& v ) = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   void accept( AbstractVisitor const& v ) override { v.dispatch( *this ); }
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   void accept( AbstractVisitor const& v ) override { v.dispatch( *this ); }
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+
+//---- <Draw.h> -----------------------------------------------------------------------------------
+
+//#include <Visitor.h>
+//#include <Circle.h>
+//#include <Square.h>
+
+class Draw : public Visitor<Draw,Circle,Square>
+{
+ public:
+   void visit( Circle const& c ) const
+      { /* ... Implementing the logic for drawing a circle ... */ }
+   void visit( Square const& s ) const
+      { /* ... Implementing the logic for drawing a square ... */ }
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+#include <memory>
+#include <vector>
+class Shape;
+
+void drawAllShapes( std::vector< std::unique_ptr<Shape> > const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Draw.h>
+//#include <Shape.h>
+
+void drawAllShapes( std::vector< std::unique_ptr<Shape> > const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      shape->accept( Draw{} );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <DrawAllShapes.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector< std::unique_ptr<Shape> >;
+
+   Shapes shapes{};
+
+   shapes.emplace_back( std::make_unique<Circle>( 2.3 ) );
+   shapes.emplace_back( std::make_unique<Square>( 1.2 ) );
+   shapes.emplace_back( std::make_unique<Circle>( 4.1 ) );
+
+   drawAllShapes( shapes );
+
+   return EXIT_SUCCESS;
+}
+
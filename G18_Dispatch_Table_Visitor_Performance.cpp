@@ -0,0 +1,320 @@
+/**************************************************************************************************
+*
+* \file G18_Dispatch_Table_Visitor_Performance.cpp
+* \brief Guideline 18: Beware the Performance of Acyclic Visitors
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to visit all
+* shapes of a scene by means of an Acyclic Visitor based on a 'dynamic_cast' in comparison to
+* an Acyclic Visitor based on a type ID dispatch table, for 2 to 64 different shape types.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t size( 100000 );  // Number of shapes in the generated scene
+
+#define BENCHMARK_DYNAMIC_CAST    1  // Acyclic Visitor based on 'dynamic_cast'
+#define BENCHMARK_DISPATCH_TABLE  1  // Acyclic Visitor based on a type ID dispatch table
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+
+size_t get_random_type( size_t types )
+{
+   return std::uniform_int_distribution<size_t>( 0U, types-1U )( rng );
+}
+
+
+//---- Scene generation ---------------------------------------------------------------------------
+
+// Creates a scene of randomly mixed shapes of the types 'ShapeT<0>' to 'ShapeT<N-1>'
+template< template< size_t > class ShapeT, typename Base, size_t... Is >
+std::vector< std::unique_ptr<Base> > createScene( std::index_sequence<Is...> )
+{
+   using Factory = std::unique_ptr<Base>(*)();
+   constexpr Factory factories[] = { []() -> std::unique_ptr<Base> {
+      return std::make_unique< ShapeT<Is> >( static_cast<double>( Is ) ); }... };
+
+   std::vector< std::unique_ptr<Base> > shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      shapes.emplace_back( factories[get_random_type( sizeof...(Is) )]() );
+   }
+   return shapes;
+}
+
+
+//---- dynamic_cast based Acyclic Visitor ---------------------------------------------------------
+
+namespace dynamic_cast_visitor {
+
+class AbstractVisitor
+{
+ public:
+   virtual ~AbstractVisitor() = default;
+};
+
+template< typename T >
+class Visitor
+{
+ protected:
+   virtual ~Visitor() = default;
+
+ public:
+   virtual void visit( T const& ) const = 0;
+};
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void accept( AbstractVisitor const& v ) = 0;
+};
+
+template< size_t I >
+class GenericShape : public Shape
+{
+ public:
+   explicit GenericShape( double size ) : size_( size ) {}
+
+   void accept( AbstractVisitor const& v ) override {
+      if( auto const* gv = dynamic_cast<Visitor<GenericShape> const*>(&v) ) {
+         gv->visit(*this);
+      }
+   }
+
+   double size() const { return size_; }
+
+ private:
+   double size_;
+};
+
+template< typename T >
+class DrawVisitor : public Visitor<T>
+{
+ public:
+   void visit( T const& t ) const override { benchmark::DoNotOptimize( t.size() ); }
+};
+
+template< typename Indices >
+class Draw;
+
+template< size_t... Is >
+class Draw< std::index_sequence<Is...> > : public AbstractVisitor
+                                          , public DrawVisitor< GenericShape<Is> >...
+{};
+
+} // namespace dynamic_cast_visitor
+
+
+//---- Dispatch table based Acyclic Visitor -------------------------------------------------------
+
+namespace dispatch_table_visitor {
+
+inline std::size_t nextTypeId()
+{
+   static std::atomic<std::size_t> counter{ 0U };
+   return counter++;
+}
+
+template< typename T >
+std::size_t typeId()
+{
+   static std::size_t const id = nextTypeId();
+   return id;
+}
+
+class AbstractVisitor;
+
+class DispatchTable
+{
+ public:
+   using VisitFunction = void(*)( AbstractVisitor const&, void const* );
+
+   DispatchTable( std::initializer_list< std::pair<std::size_t,VisitFunction> > entries )
+      : slots_( std::bit_ceil( 2U*entries.size() ) )
+      , mask_( slots_.size() - 1U )
+   {
+      for( auto const& [id,function] : entries ) {
+         std::size_t index = id & mask_;
+         while( slots_[index].function != nullptr ) {
+            index = ( index + 1U ) & mask_;
+         }
+         slots_[index] = Slot{ id, function };
+      }
+   }
+
+   VisitFunction find( std::size_t id ) const
+   {
+      for( std::size_t index = id & mask_; ; index = ( index + 1U ) & mask_ ) {
+         Slot const& slot = slots_[index];
+         if( slot.function == nullptr || slot.id == id ) return slot.function;
+      }
+   }
+
+ private:
+   struct Slot
+   {
+      std::size_t id{};
+      VisitFunction function{};
+   };
+
+   std::vector<Slot> slots_;
+   std::size_t mask_;
+};
+
+class AbstractVisitor
+{
+ public:
+   virtual ~AbstractVisitor() = default;
+
+   template< typename T >
+   void dispatch( T const& t ) const
+   {
+      if( auto const function = table_->find( typeId<T>() ) ) {
+         function( *this, &t );
+      }
+   }
+
+ protected:
+   explicit AbstractVisitor( DispatchTable const& table ) : table_( &table ) {}
+
+ private:
+   DispatchTable const* table_;
+};
+
+template< typename Derived, typename... Ts >
+class Visitor : public AbstractVisitor
+{
+ protected:
+   Visitor() : AbstractVisitor( table() ) {}
+
+ private:
+   template< typename T >
+   static void visitFunction( AbstractVisitor const& v, void const* t )
+   {
+      static_cast<Derived const&>( v ).visit( *static_cast<T const*>( t ) );
+   }
+
+   static DispatchTable const& table()
+   {
+      static DispatchTable const table{ { typeId<Ts>(), &visitFunction<Ts> }... };
+      return table;
+   }
+};
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void accept( AbstractVisitor const& v ) = 0;
+};
+
+template< size_t I >
+class GenericShape : public Shape
+{
+ public:
+   explicit GenericShape( double size ) : size_( size ) {}
+
+   void accept( AbstractVisitor const& v ) override { v.dispatch( *this ); }
+
+   double size() const { return size_; }
+
+ private:
+   double size_;
+};
+
+template< typename Indices >
+class Draw;
+
+template< size_t... Is >
+class Draw< std::index_sequence<Is...> >
+   : public Visitor< Draw< std::index_sequence<Is...> >, GenericShape<Is>... >
+{
+ public:
+   template< typename T >
+   void visit( T const& t ) const { benchmark::DoNotOptimize( t.size() ); }
+};
+
+} // namespace dispatch_table_visitor
+
+
+//---- Benchmark for the dynamic_cast based Acyclic Visitor ---------------------------------------
+
+template< size_t N >
+static void visitDynamicCast(benchmark::State& state)
+{
+   using namespace dynamic_cast_visitor;
+   using Indices = std::make_index_sequence<N>;
+
+   auto const shapes = createScene<GenericShape,Shape>( Indices{} );
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         shape->accept( Draw<Indices>{} );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * size );
+}
+#if BENCHMARK_DYNAMIC_CAST
+BENCHMARK_TEMPLATE(visitDynamicCast,2);
+BENCHMARK_TEMPLATE(visitDynamicCast,4);
+BENCHMARK_TEMPLATE(visitDynamicCast,8);
+BENCHMARK_TEMPLATE(visitDynamicCast,16);
+BENCHMARK_TEMPLATE(visitDynamicCast,32);
+BENCHMARK_TEMPLATE(visitDynamicCast,64);
+#endif
+
+
+//---- Benchmark for the dispatch table based Acyclic Visitor -------------------------------------
+
+template< size_t N >
+static void visitDispatchTable(benchmark::State& state)
+{
+   using namespace dispatch_table_visitor;
+   using Indices = std::make_index_sequence<N>;
+
+   auto const shapes = createScene<GenericShape,Shape>( Indices{} );
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         shape->accept( Draw<Indices>{} );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * size );
+}
+#if BENCHMARK_DISPATCH_TABLE
+BENCHMARK_TEMPLATE(visitDispatchTable,2);
+BENCHMARK_TEMPLATE(visitDispatchTable,4);
+BENCHMARK_TEMPLATE(visitDispatchTable,8);
+BENCHMARK_TEMPLATE(visitDispatchTable,16);
+BENCHMARK_TEMPLATE(visitDispatchTable,32);
+BENCHMARK_TEMPLATE(visitDispatchTable,64);
+#endif
+
@@ -0,0 +1,453 @@
+/**************************************************************************************************
+*
+* \file G19_Pool_Allocated_Strategy.cpp
+* \brief Guideline 19: Use Strategy to Isolate How Things are Done
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <FixedSizePool.h> --------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// A pool of equally sized memory blocks. The blocks are carved from contiguous slabs, each
+// providing memory for a fixed number of blocks. Allocation first reuses a previously freed
+// block (intrusive free list) and otherwise takes the next unused block of the current slab.
+// Both allocation and deallocation are O(1). The pool does not know the type of the objects in
+// its blocks and can therefore not destroy them: all slabs are released at once, but only once
+// all objects have been destroyed, either by means of releaseIfEmpty() or by the destructor.
+class FixedSizePool
+{
+ public:
+   FixedSizePool( size_t blockSize, size_t alignment, size_t blocksPerSlab )
+      : alignment_( std::max( alignment, alignof(FreeBlock) ) )
+      , blockSize_( roundUp( std::max( blockSize, sizeof(FreeBlock) ), alignment_ ) )
+      , blocksPerSlab_( std::max( blocksPerSlab, size_t{1U} ) )
+   {}
+
+   // The pool is referenced by all handles to its objects and can therefore not be moved
+   FixedSizePool( FixedSizePool const& ) = delete;
+   FixedSizePool& operator=( FixedSizePool const& ) = delete;
+
+   ~FixedSizePool()
+   {
+      assert( size_ == 0U );
+      freeSlabs();
+   }
+
+   void* allocate()
+   {
+      if( free_ ) {
+         FreeBlock* const block( free_ );
+         free_ = block->next;
+         ++size_;
+         return block;
+      }
+
+      if( next_ == end_ ) {
+         addSlab();
+      }
+
+      void* const block( next_ );
+      next_ += blockSize_;
+      ++size_;
+      return block;
+   }
+
+   void deallocate( void* block ) noexcept
+   {
+      free_ = ::new( block ) FreeBlock{ free_ };
+      --size_;
+   }
+
+   // Releases all slabs at once, provided that all objects allocated from the pool have been
+   // destroyed. In case any object is still alive, the pool is left unchanged and the function
+   // returns false.
+   bool releaseIfEmpty() noexcept
+   {
+      if( size_ != 0U ) return false;
+      freeSlabs();
+      return true;
+   }
+
+   size_t size() const { return size_; }  // Number of currently allocated blocks
+
+ private:
+   struct FreeBlock
+   {
+      FreeBlock* next;
+   };
+
+   static size_t roundUp( size_t size, size_t alignment )
+   {
+      return ( size + alignment - 1U ) / alignment * alignment;
+   }
+
+   void freeSlabs() noexcept
+   {
+      for( std::byte* slab : slabs_ ) {
+         ::operator delete( slab, std::align_val_t{ alignment_ } );
+      }
+      slabs_.clear();
+      free_ = nullptr;
+      next_ = nullptr;
+      end_  = nullptr;
+   }
+
+   void addSlab()
+   {
+      size_t const bytes( blockSize_ * blocksPerSlab_ );
+      slabs_.push_back( nullptr );  // Added before the allocation, so the slab cannot leak
+      auto* const slab( static_cast<std::byte*>(
+         ::operator new( bytes, std::align_val_t{ alignment_ } ) ) );
+      slabs_.back() = slab;
+      next_ = slab;
+      end_  = slab + bytes;
+   }
+
+   size_t alignment_;
+   size_t blockSize_;
+   size_t blocksPerSlab_;
+   size_t size_{};
+   FreeBlock* free_{};
+   std::byte* next_{};
+   std::byte* end_{};
+   std::vector<std::byte*> slabs_{};
+};
+
+
+//---- <PoolPtr.h> --------------------------------------------------------------------------------
+
+//#include <FixedSizePool.h>
+#include <memory>
+#include <type_traits>
+
+// The deleter of all pool-allocated objects. Since the deleter doesn't depend on the type of
+// the object, a PoolPtr to a derived class converts to a PoolPtr to its base class (e.g. from
+// PoolPtr<Circle> to PoolPtr<Shape>), exactly like std::unique_ptr with std::default_delete.
+class PoolDeleter
+{
+ public:
+   PoolDeleter() = default;
+
+   explicit PoolDeleter( FixedSizePool* pool )
+      : pool_( pool )
+   {}
+
+   template< typename T >
+   void operator()( T* object ) const
+   {
+      // In case of a base class pointer the memory block starts at the most derived object
+      void* block{};
+      if constexpr( std::is_polymorphic_v<T> ) {
+         block = dynamic_cast<void*>( object );
+      }
+      else {
+         block = object;
+      }
+
+      std::destroy_at( object );
+      pool_->deallocate( block );
+   }
+
+ private:
+   FixedSizePool* pool_{};
+};
+
+template< typename T >
+using PoolPtr = std::unique_ptr<T,PoolDeleter>;
+
+
+//---- <ObjectPool.h> -----------------------------------------------------------------------------
+
+//#include <FixedSizePool.h>
+//#include <PoolPtr.h>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// A typed pool for objects of type T. All objects of type T are stored in the contiguous slabs
+// of the pool. The pool has to outlive all objects created by means of create().
+template< typename T >
+class ObjectPool
+{
+ public:
+   explicit ObjectPool( size_t blocksPerSlab = 256U )
+      : pool_( sizeof(T), alignof(T), blocksPerSlab )
+   {}
+
+   template< typename... Args >
+   PoolPtr<T> create( Args&&... args )
+   {
+      void* const block( pool_.allocate() );
+      try {
+         T* const object( ::new( block ) T( std::forward<Args>(args)... ) );
+         return PoolPtr<T>( object, PoolDeleter( &pool_ ) );
+      }
+      catch( ... ) {
+         pool_.deallocate( block );
+         throw;
+      }
+   }
+
+   // Releases all slabs of the pool at once, provided that all objects have been destroyed
+   bool releaseIfEmpty() noexcept { return pool_.releaseIfEmpty(); }
+
+   size_t size() const { return pool_.size(); }
+
+ private:
+   FixedSizePool pool_;
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+
+   virtual void draw( /*some arguments*/ ) const = 0;
+};
+
+
+//---- <DrawStrategy.h> ---------------------------------------------------------------------------
+
+template< typename T >
+class DrawStrategy
+{
+ public:
+   virtual ~DrawStrategy() = default;
+   virtual void draw( T const& ) const = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <DrawStrategy.h>
+//#include <PoolPtr.h>
+#include <utility>
+
+class Circle : public Shape
+{
+ public:
+   using DrawCircleStrategy = DrawStrategy<Circle>;
+
+   explicit Circle( double radius, PoolPtr<DrawCircleStrategy> drawer )
+      : radius_( radius )
+      , drawer_( std::move(drawer) )
+   {
+      /* Checking that the given radius is valid and that
+         the given 'PoolPtr' is not a nullptr */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_->draw( *this /*, some arguments*/ );
+   }
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+   PoolPtr<DrawCircleStrategy> drawer_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <DrawStrategy.h>
+//#include <PoolPtr.h>
+#include <utility>
+
+class Square : public Shape
+{
+ public:
+   using DrawSquareStrategy = DrawStrategy<Square>;
+
+   explicit Square( double side, PoolPtr<DrawSquareStrategy> drawer )
+      : side_( side )
+      , drawer_( std::move(drawer) )
+   {
+      /* Checking that the given side length is valid and that
+         the given 'PoolPtr' is not a nullptr */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_->draw( *this /*, some arguments*/ );
+   }
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+   PoolPtr<DrawSquareStrategy> drawer_;
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+//#include <PoolPtr.h>
+#include <vector>
+class Shape;
+
+void drawAllShapes( std::vector<PoolPtr<Shape>> const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Shape.h>
+
+void drawAllShapes( std::vector<PoolPtr<Shape>> const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      shape->draw( /*some arguments*/ );
+   }
+}
+
+
+//---- <OpenGLCircleStrategy.h> -------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <DrawStrategy.h>
+//#include /* OpenGL graphics library */
+
+class OpenGLCircleStrategy : public DrawStrategy<Circle>
+{
+ public:
+   explicit OpenGLCircleStrategy( /* Drawing related arguments */ )
+   {}
+
+   void draw( Circle const& circle /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a circle by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g. colors, textures, ... */
+};
+
+
+//---- <OpenGLSquareStrategy.h> -------------------------------------------------------------------
+
+//#include <Square.h>
+//#include <DrawStrategy.h>
+//#include /* OpenGL graphics library */
+
+class OpenGLSquareStrategy : public DrawStrategy<Square>
+{
+ public:
+   explicit OpenGLSquareStrategy( /* Drawing related arguments */ )
+   {}
+
+   void draw( Square const& square /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a square by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g. colors, textures, ... */
+};
+
+
+//---- <ScenePools.h> -----------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ObjectPool.h>
+//#include <OpenGLCircleStrategy.h>
+//#include <OpenGLSquareStrategy.h>
+//#include <Square.h>
+
+// One pool per concrete type, i.e. all circles, all squares and all strategies of a scene
+// reside in their own contiguous slabs
+struct ScenePools
+{
+   ObjectPool<Circle> circles{};
+   ObjectPool<Square> squares{};
+   ObjectPool<OpenGLCircleStrategy> circleStrategies{};
+   ObjectPool<OpenGLSquareStrategy> squareStrategies{};
+
+   // Releases all pools, provided that all objects of the scene have been destroyed
+   bool releaseIfEmpty() noexcept
+   {
+      bool released( circles.releaseIfEmpty() );
+      released &= squares.releaseIfEmpty();
+      released &= circleStrategies.releaseIfEmpty();
+      released &= squareStrategies.releaseIfEmpty();
+      return released;
+   }
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <DrawAllShapes.h>
+//#include <Square.h>
+//#include <OpenGLCircleStrategy.h>
+//#include <OpenGLSquareStrategy.h>
+//#include <ScenePools.h>
+#include <vector>
+#include <cstdlib>
+
+int main()
+{
+   using Shapes = std::vector<PoolPtr<Shape>>;
+
+   // The pools have to outlive the shapes
+   ScenePools pools{};
+
+   for( int frame=0; frame<3; ++frame )
+   {
+      Shapes shapes{};
+
+      // Creating some shapes, each one
+      //   equipped with the according OpenGL drawing strategy
+      shapes.emplace_back(
+         pools.circles.create(
+            2.3, pools.circleStrategies.create(/*...red...*/) ) );
+      shapes.emplace_back(
+         pools.squares.create(
+            1.2, pools.squareStrategies.create(/*...green...*/) ) );
+      shapes.emplace_back(
+         pools.circles.create(
+            4.1, pools.circleStrategies.create(/*...blue...*/) ) );
+
+      drawAllShapes(shapes);
+
+      // Destroying the shapes at the end of the frame returns their memory blocks to the
+      // pools; the next frame reuses the blocks without any dynamic memory allocation
+   }
+
+   // Releasing the memory of the entire scene at once, which requires that all shapes
+   // of the scene have been destroyed
+   if( !pools.releaseIfEmpty() ) {
+      return EXIT_FAILURE;
+   }
+
+   // With a shape still alive, the pools refuse to release their memory
+   {
+      PoolPtr<Shape> const circle(
+         pools.circles.create( 1.0, pools.circleStrategies.create() ) );
+      if( pools.releaseIfEmpty() || pools.circles.size() != 1U ) {
+         return EXIT_FAILURE;
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,423 @@
+/**************************************************************************************************
+*
+* \file G19_Pool_Allocated_Strategy_Performance.cpp
+* \brief Guideline 19: Use Strategy to Isolate How Things are Done
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to rebuild,
+* draw and destroy a scene of shapes with drawing strategies per frame, once with every shape
+* and strategy allocated by means of std::make_unique() and once with all shapes and strategies
+* allocated from one object pool per concrete type.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated scenes
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated scenes
+
+#define BENCHMARK_MAKE_UNIQUE 1  // Every shape and strategy allocated by std::make_unique()
+#define BENCHMARK_OBJECT_POOL 1  // All shapes and strategies allocated from object pools
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+struct SceneEntry
+{
+   bool circle;
+   double size;
+};
+
+std::vector<SceneEntry> createScene( size_t size )
+{
+   std::vector<SceneEntry> scene( size );
+   std::generate( begin(scene), end(scene), []{
+      return SceneEntry{ is_circle(), get_random_size() }; } );
+   return scene;
+}
+
+
+//---- Object pool --------------------------------------------------------------------------------
+
+class FixedSizePool
+{
+ public:
+   FixedSizePool( size_t blockSize, size_t alignment, size_t blocksPerSlab )
+      : alignment_( std::max( alignment, alignof(FreeBlock) ) )
+      , blockSize_( roundUp( std::max( blockSize, sizeof(FreeBlock) ), alignment_ ) )
+      , blocksPerSlab_( std::max( blocksPerSlab, size_t{1U} ) )
+   {}
+
+   FixedSizePool( FixedSizePool const& ) = delete;
+   FixedSizePool& operator=( FixedSizePool const& ) = delete;
+
+   ~FixedSizePool()
+   {
+      assert( size_ == 0U );
+      freeSlabs();
+   }
+
+   void* allocate()
+   {
+      if( free_ ) {
+         FreeBlock* const block( free_ );
+         free_ = block->next;
+         ++size_;
+         return block;
+      }
+
+      if( next_ == end_ ) {
+         addSlab();
+      }
+
+      void* const block( next_ );
+      next_ += blockSize_;
+      ++size_;
+      return block;
+   }
+
+   void deallocate( void* block ) noexcept
+   {
+      free_ = ::new( block ) FreeBlock{ free_ };
+      --size_;
+   }
+
+ private:
+   struct FreeBlock
+   {
+      FreeBlock* next;
+   };
+
+   static size_t roundUp( size_t size, size_t alignment )
+   {
+      return ( size + alignment - 1U ) / alignment * alignment;
+   }
+
+   void freeSlabs() noexcept
+   {
+      for( std::byte* slab : slabs_ ) {
+         ::operator delete( slab, std::align_val_t{ alignment_ } );
+      }
+   }
+
+   void addSlab()
+   {
+      size_t const bytes( blockSize_ * blocksPerSlab_ );
+      slabs_.push_back( nullptr );
+      auto* const slab( static_cast<std::byte*>(
+         ::operator new( bytes, std::align_val_t{ alignment_ } ) ) );
+      slabs_.back() = slab;
+      next_ = slab;
+      end_  = slab + bytes;
+   }
+
+   size_t alignment_;
+   size_t blockSize_;
+   size_t blocksPerSlab_;
+   size_t size_{};
+   FreeBlock* free_{};
+   std::byte* next_{};
+   std::byte* end_{};
+   std::vector<std::byte*> slabs_{};
+};
+
+class PoolDeleter
+{
+ public:
+   PoolDeleter() = default;
+
+   explicit PoolDeleter( FixedSizePool* pool ) : pool_( pool ) {}
+
+   template< typename T >
+   void operator()( T* object ) const
+   {
+      void* block{};
+      if constexpr( std::is_polymorphic_v<T> ) {
+         block = dynamic_cast<void*>( object );
+      }
+      else {
+         block = object;
+      }
+
+      std::destroy_at( object );
+      pool_->deallocate( block );
+   }
+
+ private:
+   FixedSizePool* pool_{};
+};
+
+template< typename T >
+using PoolPtr = std::unique_ptr<T,PoolDeleter>;
+
+template< typename T >
+class ObjectPool
+{
+ public:
+   explicit ObjectPool( size_t blocksPerSlab = 256U )
+      : pool_( sizeof(T), alignof(T), blocksPerSlab )
+   {}
+
+   template< typename... Args >
+   PoolPtr<T> create( Args&&... args )
+   {
+      void* const block( pool_.allocate() );
+      try {
+         T* const object( ::new( block ) T( std::forward<Args>(args)... ) );
+         return PoolPtr<T>( object, PoolDeleter( &pool_ ) );
+      }
+      catch( ... ) {
+         pool_.deallocate( block );
+         throw;
+      }
+   }
+
+ private:
+   FixedSizePool pool_;
+};
+
+
+//---- std::make_unique() implementation ----------------------------------------------------------
+
+namespace make_unique {
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw() const = 0;
+};
+
+template< typename T >
+class DrawStrategy
+{
+ public:
+   virtual ~DrawStrategy() = default;
+   virtual void draw( T const& ) const = 0;
+};
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius, std::unique_ptr<DrawStrategy<Circle>> drawer )
+      : radius_( radius ), drawer_( std::move(drawer) ) {}
+
+   void draw() const override { drawer_->draw( *this ); }
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+   std::unique_ptr<DrawStrategy<Circle>> drawer_;
+};
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side, std::unique_ptr<DrawStrategy<Square>> drawer )
+      : side_( side ), drawer_( std::move(drawer) ) {}
+
+   void draw() const override { drawer_->draw( *this ); }
+   double side() const { return side_; }
+
+ private:
+   double side_;
+   std::unique_ptr<DrawStrategy<Square>> drawer_;
+};
+
+class OpenGLCircleStrategy : public DrawStrategy<Circle>
+{
+ public:
+   void draw( Circle const& c ) const override { benchmark::DoNotOptimize( c.radius() ); }
+};
+
+class OpenGLSquareStrategy : public DrawStrategy<Square>
+{
+ public:
+   void draw( Square const& s ) const override { benchmark::DoNotOptimize( s.side() ); }
+};
+
+using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes ) {
+      shape->draw();
+   }
+}
+
+} // namespace make_unique
+
+
+//---- Object pool implementation -----------------------------------------------------------------
+
+namespace object_pool {
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw() const = 0;
+};
+
+template< typename T >
+class DrawStrategy
+{
+ public:
+   virtual ~DrawStrategy() = default;
+   virtual void draw( T const& ) const = 0;
+};
+
+class Circle : public Shape
+{
+ public:
+   explicit Circle( double radius, PoolPtr<DrawStrategy<Circle>> drawer )
+      : radius_( radius ), drawer_( std::move(drawer) ) {}
+
+   void draw() const override { drawer_->draw( *this ); }
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+   PoolPtr<DrawStrategy<Circle>> drawer_;
+};
+
+class Square : public Shape
+{
+ public:
+   explicit Square( double side, PoolPtr<DrawStrategy<Square>> drawer )
+      : side_( side ), drawer_( std::move(drawer) ) {}
+
+   void draw() const override { drawer_->draw( *this ); }
+   double side() const { return side_; }
+
+ private:
+   double side_;
+   PoolPtr<DrawStrategy<Square>> drawer_;
+};
+
+class OpenGLCircleStrategy : public DrawStrategy<Circle>
+{
+ public:
+   void draw( Circle const& c ) const override { benchmark::DoNotOptimize( c.radius() ); }
+};
+
+class OpenGLSquareStrategy : public DrawStrategy<Square>
+{
+ public:
+   void draw( Square const& s ) const override { benchmark::DoNotOptimize( s.side() ); }
+};
+
+struct ScenePools
+{
+   ObjectPool<Circle> circles{};
+   ObjectPool<Square> squares{};
+   ObjectPool<OpenGLCircleStrategy> circleStrategies{};
+   ObjectPool<OpenGLSquareStrategy> squareStrategies{};
+};
+
+using Shapes = std::vector<PoolPtr<Shape>>;
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes ) {
+      shape->draw();
+   }
+}
+
+} // namespace object_pool
+
+
+//---- Benchmark for std::make_unique() -----------------------------------------------------------
+
+static void rebuildMakeUnique(benchmark::State& state)
+{
+   using namespace make_unique;
+
+   std::vector<SceneEntry> const scene( createScene( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      Shapes shapes{};
+      shapes.reserve( scene.size() );
+      for( auto const& entry : scene ) {
+         if( entry.circle )
+            shapes.emplace_back( std::make_unique<Circle>(
+               entry.size, std::make_unique<OpenGLCircleStrategy>() ) );
+         else
+            shapes.emplace_back( std::make_unique<Square>(
+               entry.size, std::make_unique<OpenGLSquareStrategy>() ) );
+      }
+      drawAllShapes( shapes );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_MAKE_UNIQUE
+BENCHMARK(rebuildMakeUnique)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for object pools -----------------------------------------------------------------
+
+static void rebuildObjectPool(benchmark::State& state)
+{
+   using namespace object_pool;
+
+   std::vector<SceneEntry> const scene( createScene( state.range(0) ) );
+   ScenePools pools{};
+
+   for( auto _ : state )
+   {
+      Shapes shapes{};
+      shapes.reserve( scene.size() );
+      for( auto const& entry : scene ) {
+         if( entry.circle )
+            shapes.emplace_back( pools.circles.create(
+               entry.size, pools.circleStrategies.create() ) );
+         else
+            shapes.emplace_back( pools.squares.create(
+               entry.size, pools.squareStrategies.create() ) );
+      }
+      drawAllShapes( shapes );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_OBJECT_POOL
+BENCHMARK(rebuildObjectPool)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,317 @@
+/**************************************************************************************************
+*
+* \file G19_Strategy_Registry.cpp
+* \brief Guideline 19: Use Strategy to Isolate How Things are Done
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+
+   virtual void draw( /*some arguments*/ ) const = 0;
+};
+
+
+//---- <DrawStrategy.h> ---------------------------------------------------------------------------
+
+template< typename T >
+class DrawStrategy
+{
+ public:
+   virtual ~DrawStrategy() = default;
+   virtual void draw( T const& ) const = 0;
+};
+
+
+//---- <StrategyHandle.h> -------------------------------------------------------------------------
+
+// A small, non-owning handle to a shared, immutable strategy. Two handles compare equal if
+// they refer to the same strategy instance, which for instance allows to batch all shapes
+// sharing a strategy.
+template< typename StrategyT >
+class StrategyHandle
+{
+ public:
+   explicit StrategyHandle( StrategyT const& strategy )
+      : strategy_( &strategy )
+   {}
+
+   StrategyT const& operator* () const { return *strategy_; }
+   StrategyT const* operator->() const { return strategy_; }
+
+   friend bool operator==( StrategyHandle, StrategyHandle ) = default;
+
+ private:
+   StrategyT const* strategy_;
+};
+
+
+//---- <StrategyRegistry.h> -----------------------------------------------------------------------
+
+#include <cstddef>
+#include <unordered_set>
+#include <utility>
+
+// Interns strategies of type 'StrategyT': all equal strategies are represented by a single,
+// immutable instance owned by the registry. 'StrategyT' has to be equality comparable and
+// hashable via std::hash. Since the instances are stored in a node-based container, their
+// addresses remain stable. The registry has to outlive all shapes referring to its strategies.
+template< typename StrategyT >
+class StrategyRegistry
+{
+ public:
+   template< typename... Args >
+   StrategyT const& intern( Args&&... args )
+   {
+      // Looking up the strategy before inserting it avoids the allocation of a node for
+      // strategies that have already been interned
+      StrategyT strategy( std::forward<Args>(args)... );
+      auto pos( strategies_.find( strategy ) );
+      if( pos == strategies_.end() ) {
+         pos = strategies_.insert( std::move(strategy) ).first;
+      }
+      return *pos;
+   }
+
+   size_t size() const { return strategies_.size(); }
+
+ private:
+   std::unordered_set<StrategyT> strategies_;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <DrawStrategy.h>
+//#include <StrategyHandle.h>
+
+class Circle : public Shape
+{
+ public:
+   using DrawCircleStrategy = DrawStrategy<Circle>;
+
+   explicit Circle( double radius, StrategyHandle<DrawCircleStrategy> drawer )
+      : radius_( radius )
+      , drawer_( drawer )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_->draw( *this /*, some arguments*/ );
+   }
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+   StrategyHandle<DrawCircleStrategy> drawer_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <DrawStrategy.h>
+//#include <StrategyHandle.h>
+
+class Square : public Shape
+{
+ public:
+   using DrawSquareStrategy = DrawStrategy<Square>;
+
+   explicit Square( double side, StrategyHandle<DrawSquareStrategy> drawer )
+      : side_( side )
+      , drawer_( drawer )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_->draw( *this /*, some arguments*/ );
+   }
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+   StrategyHandle<DrawSquareStrategy> drawer_;
+};
+
+
+//---- <DrawAllShapes.h> --------------------------------------------------------------------------
+
+#include <memory>
+#include <vector>
+class Shape;
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes );
+
+
+//---- <DrawAllShapes.cpp> ------------------------------------------------------------------------
+
+//#include <DrawAllShapes.h>
+//#include <Shape.h>
+
+void drawAllShapes( std::vector<std::unique_ptr<Shape>> const& shapes )
+{
+   for( auto const& shape : shapes )
+   {
+      shape->draw( /*some arguments*/ );
+   }
+}
+
+
+//---- <Color.h> ----------------------------------------------------------------------------------
+
+enum class Color
+{
+   red,
+   green,
+   blue
+};
+
+
+//---- <OpenGLCircleStrategy.h> -------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Color.h>
+//#include <DrawStrategy.h>
+//#include /* OpenGL graphics library */
+#include <cstddef>
+#include <functional>
+
+class OpenGLCircleStrategy : public DrawStrategy<Circle>
+{
+ public:
+   explicit OpenGLCircleStrategy( Color color /*, Further drawing related arguments */ )
+      : color_( color )
+   {}
+
+   void draw( Circle const& circle /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a circle by means of OpenGL
+   }
+
+   Color color() const { return color_; }
+
+   friend bool operator==( OpenGLCircleStrategy const& lhs, OpenGLCircleStrategy const& rhs )
+   {
+      return lhs.color_ == rhs.color_;
+   }
+
+ private:
+   Color color_;
+   /* Further drawing related data members, e.g. textures, ... */
+};
+
+template<>
+struct std::hash<OpenGLCircleStrategy>
+{
+   size_t operator()( OpenGLCircleStrategy const& strategy ) const
+   {
+      return std::hash<Color>{}( strategy.color() );
+   }
+};
+
+
+//---- <OpenGLSquareStrategy.h> -------------------------------------------------------------------
+
+//#include <Color.h>
+//#include <Square.h>
+//#include <DrawStrategy.h>
+//#include /* OpenGL graphics library */
+#include <cstddef>
+#include <functional>
+
+class OpenGLSquareStrategy : public DrawStrategy<Square>
+{
+ public:
+   explicit OpenGLSquareStrategy( Color color /*, Further drawing related arguments */ )
+      : color_( color )
+   {}
+
+   void draw( Square const& square /*, ...*/ ) const override
+   {
+      // ... Implementing the logic for drawing a square by means of OpenGL
+   }
+
+   Color color() const { return color_; }
+
+   friend bool operator==( OpenGLSquareStrategy const& lhs, OpenGLSquareStrategy const& rhs )
+   {
+      return lhs.color_ == rhs.color_;
+   }
+
+ private:
+   Color color_;
+   /* Further drawing related data members, e.g. textures, ... */
+};
+
+template<>
+struct std::hash<OpenGLSquareStrategy>
+{
+   size_t operator()( OpenGLSquareStrategy const& strategy ) const
+   {
+      return std::hash<Color>{}( strategy.color() );
+   }
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <DrawAllShapes.h>
+//#include <Square.h>
+//#include <OpenGLCircleStrategy.h>
+//#include <OpenGLSquareStrategy.h>
+//#include <StrategyRegistry.h>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+
+int main()
+{
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   // The registries have to outlive the shapes
+   StrategyRegistry<OpenGLCircleStrategy> circleStrategies{};
+   StrategyRegistry<OpenGLSquareStrategy> squareStrategies{};
+
+   using CircleHandle = StrategyHandle<DrawStrategy<Circle>>;
+   using SquareHandle = StrategyHandle<DrawStrategy<Square>>;
+
+   Shapes shapes{};
+
+   // Creating some shapes, each one
+   //   equipped with the according, shared OpenGL drawing strategy
+   shapes.emplace_back(
+      std::make_unique<Circle>(
+         2.3, CircleHandle( circleStrategies.intern( Color::red ) ) ) );
+   shapes.emplace_back(
+      std::make_unique<Square>(
+         1.2, SquareHandle( squareStrategies.intern( Color::green ) ) ) );
+   shapes.emplace_back(
+      std::make_unique<Circle>(
+         4.1, CircleHandle( circleStrategies.intern( Color::red ) ) ) );
+
+   drawAllShapes(shapes);
+
+   // Both red circles share a single strategy instance
+   return ( circleStrategies.size() == 1U && squareStrategies.size() == 1U )
+          ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,284 @@
+/**************************************************************************************************
+*
+* \file G19_Strategy_Registry_Performance.cpp
+* \brief Guideline 19: Use Strategy to Isolate How Things are Done
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to create and
+* draw shapes, once with every shape owning its strategy and once with all shapes sharing
+* interned strategies. The 'bytes/shape' counter reports the dynamic memory per shape.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_OWNED_STRATEGIES    1  // Every shape owns a std::unique_ptr to its strategy
+#define BENCHMARK_INTERNED_STRATEGIES 1  // All shapes share interned strategies
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::uniform_int_distribution<int> palette( 0, 7 );
+std::bernoulli_distribution coin{};
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the amount of dynamic memory per shape. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocatedBytes{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   allocatedBytes += bytes;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Scene generation ---------------------------------------------------------------------------
+
+struct SceneEntry
+{
+   bool circle;
+   double size;
+   int color;
+};
+
+std::vector<SceneEntry> createScene( size_t size )
+{
+   std::vector<SceneEntry> scene( size );
+   for( auto& entry : scene ) {
+      entry = SceneEntry{ coin( rng ), dist( rng ), palette( rng ) };
+   }
+   return scene;
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw() const = 0;
+};
+
+template< typename T >
+class DrawStrategy
+{
+ public:
+   virtual ~DrawStrategy() = default;
+   virtual void draw( T const& ) const = 0;
+};
+
+template< typename StrategyT >
+class StrategyHandle
+{
+ public:
+   explicit StrategyHandle( StrategyT const& strategy ) : strategy_( &strategy ) {}
+
+   StrategyT const& operator* () const { return *strategy_; }
+   StrategyT const* operator->() const { return strategy_; }
+
+ private:
+   StrategyT const* strategy_;
+};
+
+template< typename StrategyT >
+class StrategyRegistry
+{
+ public:
+   template< typename... Args >
+   StrategyT const& intern( Args&&... args )
+   {
+      // Looking up the strategy before inserting it avoids the allocation of a node for
+      // strategies that have already been interned
+      StrategyT strategy( std::forward<Args>(args)... );
+      auto pos( strategies_.find( strategy ) );
+      if( pos == strategies_.end() ) {
+         pos = strategies_.insert( std::move(strategy) ).first;
+      }
+      return *pos;
+   }
+
+ private:
+   std::unordered_set<StrategyT> strategies_;
+};
+
+// A shape of type 'Tag', holding its strategy by means of 'Holder'
+template< typename Tag, template< typename > class Holder >
+class BasicShape : public Shape
+{
+ public:
+   explicit BasicShape( double size, Holder<DrawStrategy<BasicShape>> drawer )
+      : size_( size ), drawer_( std::move(drawer) ) {}
+
+   void draw() const override { drawer_->draw( *this ); }
+   double size() const { return size_; }
+
+ private:
+   double size_;
+   Holder<DrawStrategy<BasicShape>> drawer_;
+};
+
+struct CircleTag {};
+struct SquareTag {};
+
+template< typename ShapeT >
+class OpenGLStrategy : public DrawStrategy<ShapeT>
+{
+ public:
+   explicit OpenGLStrategy( int color ) : color_( color ) {}
+
+   void draw( ShapeT const& shape ) const override
+   {
+      benchmark::DoNotOptimize( shape.size() );
+      benchmark::DoNotOptimize( color_ );
+   }
+
+   int color() const { return color_; }
+
+   friend bool operator==( OpenGLStrategy const& lhs, OpenGLStrategy const& rhs )
+   {
+      return lhs.color_ == rhs.color_;
+   }
+
+ private:
+   int color_;
+};
+
+template< typename ShapeT >
+struct std::hash<OpenGLStrategy<ShapeT>>
+{
+   size_t operator()( OpenGLStrategy<ShapeT> const& strategy ) const
+   {
+      return std::hash<int>{}( strategy.color() );
+   }
+};
+
+using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+void drawAllShapes( Shapes const& shapes )
+{
+   for( auto const& shape : shapes ) {
+      shape->draw();
+   }
+}
+
+
+//---- Benchmark for owned strategies -------------------------------------------------------------
+
+static void ownedStrategies(benchmark::State& state)
+{
+   using Circle = BasicShape<CircleTag,std::unique_ptr>;
+   using Square = BasicShape<SquareTag,std::unique_ptr>;
+
+   std::vector<SceneEntry> const scene( createScene( state.range(0) ) );
+   size_t bytes{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocatedBytes );
+
+      Shapes shapes{};
+      shapes.reserve( scene.size() );
+      for( auto const& e : scene ) {
+         if( e.circle )
+            shapes.emplace_back( std::make_unique<Circle>(
+               e.size, std::make_unique<OpenGLStrategy<Circle>>( e.color ) ) );
+         else
+            shapes.emplace_back( std::make_unique<Square>(
+               e.size, std::make_unique<OpenGLStrategy<Square>>( e.color ) ) );
+      }
+      drawAllShapes( shapes );
+
+      bytes = allocatedBytes - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["bytes/shape"] = static_cast<double>( bytes ) / scene.size();
+}
+#if BENCHMARK_OWNED_STRATEGIES
+BENCHMARK(ownedStrategies)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for interned strategies ----------------------------------------------------------
+
+static void internedStrategies(benchmark::State& state)
+{
+   using Circle = BasicShape<CircleTag,StrategyHandle>;
+   using Square = BasicShape<SquareTag,StrategyHandle>;
+
+   using CircleHandle = StrategyHandle<DrawStrategy<Circle>>;
+   using SquareHandle = StrategyHandle<DrawStrategy<Square>>;
+
+   std::vector<SceneEntry> const scene( createScene( state.range(0) ) );
+   size_t bytes{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocatedBytes );
+
+      StrategyRegistry<OpenGLStrategy<Circle>> circleStrategies{};
+      StrategyRegistry<OpenGLStrategy<Square>> squareStrategies{};
+
+      Shapes shapes{};
+      shapes.reserve( scene.size() );
+      for( auto const& e : scene ) {
+         if( e.circle )
+            shapes.emplace_back( std::make_unique<Circle>(
+               e.size, CircleHandle( circleStrategies.intern( e.color ) ) ) );
+         else
+            shapes.emplace_back( std::make_unique<Square>(
+               e.size, SquareHandle( squareStrategies.intern( e.color ) ) ) );
+      }
+      drawAllShapes( shapes );
+
+      bytes = allocatedBytes - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["bytes/shape"] = static_cast<double>( bytes ) / scene.size();
+}
+#if BENCHMARK_INTERNED_STRATEGIES
+BENCHMARK(internedStrategies)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,362 @@
+/**************************************************************************************************
+*
+* \file G23_Inplace_Function.cpp
+* \brief Guideline 23: Prefer a Value-Based Implementation of Strategy and Command
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <InplaceFunction.h> ------------------------------------------------------------------------
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template< typename Signature
+        , size_t Capacity = 32U
+        , size_t Alignment = alignof(std::max_align_t) >
+class inplace_function;
+
+// A move-only replacement for std::function, which stores the callable in an in-class buffer
+// of 'Capacity' bytes. Callables that do not fit into the buffer are rejected at compile time,
+// i.e. an inplace_function never allocates dynamic memory. The invoke function is stored
+// directly in the object, so a call costs a single indirect function call. Calling an empty
+// inplace_function results in a std::bad_function_call exception, which does not require a
+// check for emptiness on the call path.
+template< typename R, typename... Args, size_t Capacity, size_t Alignment >
+class inplace_function<R(Args...),Capacity,Alignment>
+{
+ public:
+   inplace_function() = default;
+
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,inplace_function> &&
+                 std::is_invocable_r_v<R,std::decay_t<F>&,Args...> )
+   inplace_function( F&& f )
+   {
+      using Callable = std::decay_t<F>;
+
+      static_assert( sizeof(Callable) <= Capacity, "Callable exceeds the buffer capacity" );
+      static_assert( Alignment % alignof(Callable) == 0U, "Callable is overaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Callable>
+                   , "Callable must be nothrow move constructible" );
+
+      ::new (buffer_) Callable( std::forward<F>(f) );
+      invoke_ = &invoke<Callable>;
+      ops_ = &ops<Callable>;
+   }
+
+   inplace_function( inplace_function&& other ) noexcept
+      : invoke_( other.invoke_ )
+      , ops_( other.ops_ )
+   {
+      ops_->move( other.buffer_, buffer_ );
+      other.invoke_ = &empty;
+      other.ops_ = &emptyOps;
+   }
+
+   inplace_function& operator=( inplace_function&& other ) noexcept
+   {
+      if( this != &other ) {
+         ops_->destroy( buffer_ );
+         invoke_ = other.invoke_;
+         ops_ = other.ops_;
+         ops_->move( other.buffer_, buffer_ );
+         other.invoke_ = &empty;
+         other.ops_ = &emptyOps;
+      }
+      return *this;
+   }
+
+   ~inplace_function() { ops_->destroy( buffer_ ); }
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( buffer_, std::forward<Args>(args)... );
+   }
+
+   explicit operator bool() const { return ops_ != &emptyOps; }
+
+ private:
+   struct Ops
+   {
+      void (*move)( std::byte* src, std::byte* dst ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename Callable >
+   static R invoke( std::byte const* buffer, Args&&... args )
+   {
+      // Like std::function, a const inplace_function invokes a non-const callable
+      std::byte* const storage( const_cast<std::byte*>( buffer ) );
+      Callable& callable( *std::launder( reinterpret_cast<Callable*>( storage ) ) );
+      return std::invoke( callable, std::forward<Args>(args)... );
+   }
+
+   template< typename Callable >
+   static constexpr Ops ops{
+        []( std::byte* src, std::byte* dst ) noexcept {
+           auto* callable( std::launder( reinterpret_cast<Callable*>( src ) ) );
+           ::new (dst) Callable( std::move(*callable) );
+           callable->~Callable();
+        }
+      , []( std::byte* buffer ) noexcept {
+           std::launder( reinterpret_cast<Callable*>( buffer ) )->~Callable();
+        } };
+
+   static constexpr Ops emptyOps{
+        []( std::byte*, std::byte* ) noexcept {}
+      , []( std::byte* ) noexcept {} };
+
+   static R empty( std::byte const*, Args&&... ) { throw std::bad_function_call{}; }
+
+   R (*invoke_)( std::byte const*, Args&&... ){ &empty };
+   Ops const* ops_{ &emptyOps };
+   alignas(Alignment) std::byte buffer_[Capacity];
+};
+
+
+//---- <FunctionRef.h> ----------------------------------------------------------------------------
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template< typename Signature >
+class function_ref;
+
+// A non-owning reference to a callable. A function_ref consists of two pointers only and is
+// trivially copyable, but it is the responsibility of the user to guarantee that the referenced
+// callable outlives the function_ref.
+template< typename R, typename... Args >
+class function_ref<R(Args...)>
+{
+ public:
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,function_ref> &&
+                 !std::is_function_v<std::remove_reference_t<F>> &&
+                 std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F&& f )
+      : object_( const_cast<void*>( static_cast<void const*>( std::addressof(f) ) ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           using Callable = std::remove_reference_t<F>;
+           return std::invoke( *static_cast<Callable*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   template< typename F >
+      requires ( std::is_function_v<F> && std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F* f )
+      : object_( reinterpret_cast<void*>( f ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           return std::invoke( reinterpret_cast<F*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( object_, std::forward<Args>(args)... );
+   }
+
+ private:
+   void* object_;
+   R (*invoke_)( void*, Args&&... );
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw( /*some arguments*/ ) const = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <InplaceFunction.h>
+#include <utility>
+
+class Circle : public Shape
+{
+ public:
+   using DrawStrategy = inplace_function<void(Circle const& /*, ...*/)>;
+
+   explicit Circle( double radius, DrawStrategy drawer )
+      : radius_( radius )
+      , drawer_( std::move(drawer) )
+   {
+      /* Checking that the given radius is valid and that
+         the given 'inplace_function' instance is not empty */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_( *this /*, some arguments*/ );
+   }
+
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Shape.h>
+//#include <FunctionRef.h>
+
+class Square : public Shape
+{
+ public:
+   // The square only refers to its drawing strategy, which has to outlive the square
+   using DrawStrategy = function_ref<void(Square const& /*, ...*/)>;
+
+   explicit Square( double side, DrawStrategy drawer )
+      : side_( side )
+      , drawer_( drawer )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_( *this /*, some arguments*/ );
+   }
+
+   double side() const { return side_; }
+
+ private:
+   double side_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <OpenGLCircleStrategy.h> -------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include /* OpenGL graphics library */
+
+class OpenGLCircleStrategy
+{
+ public:
+   explicit OpenGLCircleStrategy( /* Drawing related arguments */ )
+   {}
+
+   void operator()( Circle const& circle /*, ...*/ ) const
+   {
+      // ... Implementing the logic for drawing a circle by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g. colors, textures, ... */
+};
+
+
+//---- <OpenGLSquareStrategy.h> -------------------------------------------------------------------
+
+//#include <Square.h>
+//#include /* OpenGL graphics library */
+
+class OpenGLSquareStrategy
+{
+ public:
+   explicit OpenGLSquareStrategy( /* Drawing related arguments */ )
+   {}
+
+   void operator()( Square const& square /*, ...*/ ) const
+   {
+      // ... Implementing the logic for drawing a square by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g. colors, textures, ... */
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <OpenGLCircleStrategy.h>
+//#include <OpenGLSquareStrategy.h>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A drawing strategy, which counts its live instances
+class CountingStrategy
+{
+ public:
+   explicit CountingStrategy( int& live ) : live_( &live ) { ++*live_; }
+   CountingStrategy( CountingStrategy const& other ) : live_( other.live_ ) { ++*live_; }
+   CountingStrategy( CountingStrategy&& other ) noexcept : live_( other.live_ ) { ++*live_; }
+   CountingStrategy& operator=( CountingStrategy const& ) = delete;
+   ~CountingStrategy() { --*live_; }
+
+   void operator()( Circle const& /*, ...*/ ) const {}
+
+ private:
+   int* live_;
+};
+
+int main()
+{
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   // The square strategy is referred to by function_ref and has to outlive the squares
+   OpenGLSquareStrategy const squareStrategy{/*...green...*/};
+
+   Shapes shapes{};
+
+   // Creating some shapes, each one
+   //   equipped with the according OpenGL drawing strategy
+   shapes.emplace_back(
+      std::make_unique<Circle>( 2.3, OpenGLCircleStrategy(/*...red...*/) ) );
+   shapes.emplace_back(
+      std::make_unique<Square>( 1.2, squareStrategy ) );
+   shapes.emplace_back(
+      std::make_unique<Circle>( 4.1, OpenGLCircleStrategy(/*...blue...*/) ) );
+
+   // Drawing all shapes
+   for( auto const& shape : shapes )
+   {
+      shape->draw();
+   }
+
+   // Calling an empty inplace_function results in a std::bad_function_call exception
+   Circle::DrawStrategy empty{};
+   try {
+      empty( Circle{ 1.0, OpenGLCircleStrategy{} } );
+      return EXIT_FAILURE;
+   }
+   catch( std::bad_function_call const& ) {}
+
+   // A moved-from inplace_function is empty, i.e. every callable is destroyed exactly once
+   int live{};
+   {
+      Circle::DrawStrategy first{ CountingStrategy{ live } };
+      Circle::DrawStrategy second( std::move(first) );
+      Circle::DrawStrategy third{};
+      third = std::move(second);
+      if( first || second || !third ) return EXIT_FAILURE;
+   }
+   if( live != 0 ) return EXIT_FAILURE;
+
+   return EXIT_SUCCESS;
+}
+
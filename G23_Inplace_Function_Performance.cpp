@@ -0,0 +1,341 @@
+/**************************************************************************************************
+*
+* \file G23_Inplace_Function_Performance.cpp
+* \brief Guideline 23: Prefer a Value-Based Implementation of Strategy and Command
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to construct,
+* copy (or move) and invoke std::function, inplace_function and function_ref instances. The
+* stored callable is a 24-byte drawing strategy, which exceeds the small buffer of std::function.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_CONSTRUCT 1  // Constructing wrappers from drawing strategies
+#define BENCHMARK_COPY      1  // Copying (inplace_function: moving) all wrappers
+#define BENCHMARK_INVOKE    1  // Invoking all wrappers
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+
+//---- inplace_function ---------------------------------------------------------------------------
+
+template< typename Signature
+        , size_t Capacity = 32U
+        , size_t Alignment = alignof(std::max_align_t) >
+class inplace_function;
+
+// A move-only replacement for std::function, which stores the callable in an in-class buffer
+// of 'Capacity' bytes. Callables that do not fit into the buffer are rejected at compile time,
+// i.e. an inplace_function never allocates dynamic memory. The invoke function is stored
+// directly in the object, so a call costs a single indirect function call. Calling an empty
+// inplace_function results in a std::bad_function_call exception, which does not require a
+// check for emptiness on the call path.
+template< typename R, typename... Args, size_t Capacity, size_t Alignment >
+class inplace_function<R(Args...),Capacity,Alignment>
+{
+ public:
+   inplace_function() = default;
+
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,inplace_function> &&
+                 std::is_invocable_r_v<R,std::decay_t<F>&,Args...> )
+   inplace_function( F&& f )
+   {
+      using Callable = std::decay_t<F>;
+
+      static_assert( sizeof(Callable) <= Capacity, "Callable exceeds the buffer capacity" );
+      static_assert( Alignment % alignof(Callable) == 0U, "Callable is overaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Callable>
+                   , "Callable must be nothrow move constructible" );
+
+      ::new (buffer_) Callable( std::forward<F>(f) );
+      invoke_ = &invoke<Callable>;
+      ops_ = &ops<Callable>;
+   }
+
+   inplace_function( inplace_function&& other ) noexcept
+      : invoke_( other.invoke_ )
+      , ops_( other.ops_ )
+   {
+      ops_->move( other.buffer_, buffer_ );
+      other.invoke_ = &empty;
+      other.ops_ = &emptyOps;
+   }
+
+   inplace_function& operator=( inplace_function&& other ) noexcept
+   {
+      if( this != &other ) {
+         ops_->destroy( buffer_ );
+         invoke_ = other.invoke_;
+         ops_ = other.ops_;
+         ops_->move( other.buffer_, buffer_ );
+         other.invoke_ = &empty;
+         other.ops_ = &emptyOps;
+      }
+      return *this;
+   }
+
+   ~inplace_function() { ops_->destroy( buffer_ ); }
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( buffer_, std::forward<Args>(args)... );
+   }
+
+   explicit operator bool() const { return ops_ != &emptyOps; }
+
+ private:
+   struct Ops
+   {
+      void (*move)( std::byte* src, std::byte* dst ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename Callable >
+   static R invoke( std::byte const* buffer, Args&&... args )
+   {
+      // Like std::function, a const inplace_function invokes a non-const callable
+      std::byte* const storage( const_cast<std::byte*>( buffer ) );
+      Callable& callable( *std::launder( reinterpret_cast<Callable*>( storage ) ) );
+      return std::invoke( callable, std::forward<Args>(args)... );
+   }
+
+   template< typename Callable >
+   static constexpr Ops ops{
+        []( std::byte* src, std::byte* dst ) noexcept {
+           auto* callable( std::launder( reinterpret_cast<Callable*>( src ) ) );
+           ::new (dst) Callable( std::move(*callable) );
+           callable->~Callable();
+        }
+      , []( std::byte* buffer ) noexcept {
+           std::launder( reinterpret_cast<Callable*>( buffer ) )->~Callable();
+        } };
+
+   static constexpr Ops emptyOps{
+        []( std::byte*, std::byte* ) noexcept {}
+      , []( std::byte* ) noexcept {} };
+
+   static R empty( std::byte const*, Args&&... ) { throw std::bad_function_call{}; }
+
+   R (*invoke_)( std::byte const*, Args&&... ){ &empty };
+   Ops const* ops_{ &emptyOps };
+   alignas(Alignment) std::byte buffer_[Capacity];
+};
+
+
+//---- function_ref -------------------------------------------------------------------------------
+
+template< typename Signature >
+class function_ref;
+
+// A non-owning reference to a callable. A function_ref consists of two pointers only and is
+// trivially copyable, but it is the responsibility of the user to guarantee that the referenced
+// callable outlives the function_ref.
+template< typename R, typename... Args >
+class function_ref<R(Args...)>
+{
+ public:
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,function_ref> &&
+                 !std::is_function_v<std::remove_reference_t<F>> &&
+                 std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F&& f )
+      : object_( const_cast<void*>( static_cast<void const*>( std::addressof(f) ) ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           using Callable = std::remove_reference_t<F>;
+           return std::invoke( *static_cast<Callable*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   template< typename F >
+      requires ( std::is_function_v<F> && std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F* f )
+      : object_( reinterpret_cast<void*>( f ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           return std::invoke( reinterpret_cast<F*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( object_, std::forward<Args>(args)... );
+   }
+
+ private:
+   void* object_;
+   R (*invoke_)( void*, Args&&... );
+};
+
+
+//---- Drawing strategy ---------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+// A strategy with some drawing related data, which does not fit into the small buffer
+// of std::function
+class OpenGLCircleStrategy
+{
+ public:
+   explicit OpenGLCircleStrategy( double red, double green, double blue )
+      : red_( red ), green_( green ), blue_( blue ) {}
+
+   void operator()( Circle const& circle ) const
+   {
+      benchmark::DoNotOptimize( circle.radius()*red_ + green_ + blue_ );
+   }
+
+ private:
+   double red_;
+   double green_;
+   double blue_;
+};
+
+using StdFunction     = std::function<void(Circle const&)>;
+using InplaceFunction = inplace_function<void(Circle const&)>;
+using FunctionRef     = function_ref<void(Circle const&)>;
+
+std::vector<OpenGLCircleStrategy> createStrategies( size_t size )
+{
+   std::vector<OpenGLCircleStrategy> strategies{};
+   strategies.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      strategies.emplace_back( get_random_size(), get_random_size(), get_random_size() );
+   }
+   return strategies;
+}
+
+template< typename Function >
+std::vector<Function> createFunctions( std::vector<OpenGLCircleStrategy> const& strategies )
+{
+   std::vector<Function> functions{};
+   functions.reserve( strategies.size() );
+   for( auto const& strategy : strategies ) {
+      functions.emplace_back( strategy );
+   }
+   return functions;
+}
+
+
+//---- Benchmarks for the construction ------------------------------------------------------------
+
+template< typename Function >
+static void construct(benchmark::State& state)
+{
+   auto const strategies( createStrategies( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      auto functions( createFunctions<Function>( strategies ) );
+      benchmark::DoNotOptimize( functions.data() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_CONSTRUCT
+BENCHMARK_TEMPLATE(construct,StdFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(construct,InplaceFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(construct,FunctionRef)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmarks for copy operations -------------------------------------------------------------
+
+template< typename Function >
+static void copy(benchmark::State& state)
+{
+   auto const strategies( createStrategies( state.range(0) ) );
+   auto functions( createFunctions<Function>( strategies ) );
+
+   std::vector<Function> copies{};
+   copies.reserve( functions.size() );
+
+   for( auto _ : state )
+   {
+      copies.clear();
+      for( auto& function : functions ) {
+         if constexpr( std::is_copy_constructible_v<Function> )
+            copies.push_back( function );
+         else
+            copies.push_back( std::move(function) );
+      }
+      benchmark::DoNotOptimize( copies.data() );
+
+      // The moved-from inplace_functions are restored for the next iteration
+      if constexpr( !std::is_copy_constructible_v<Function> )
+         functions.swap( copies );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_COPY
+BENCHMARK_TEMPLATE(copy,StdFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(copy,InplaceFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(copy,FunctionRef)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmarks for invocation ------------------------------------------------------------------
+
+template< typename Function >
+static void invoke(benchmark::State& state)
+{
+   auto const strategies( createStrategies( state.range(0) ) );
+   auto const functions( createFunctions<Function>( strategies ) );
+   Circle const circle( get_random_size() );
+
+   for( auto _ : state )
+   {
+      for( auto const& function : functions ) {
+         function( circle );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_INVOKE
+BENCHMARK_TEMPLATE(invoke,StdFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(invoke,InplaceFunction)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(invoke,FunctionRef)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,436 @@
+/**************************************************************************************************
+*
+* \file G23_Software_Rasterizer.cpp
+* \brief Guideline 23: Prefer a Value-Based Implementation of Strategy and Command
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+class Shape
+{
+ public:
+   virtual ~Shape() = default;
+   virtual void draw( /*some arguments*/ ) const = 0;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+//#include <Shape.h>
+#include <functional>
+#include <utility>
+
+class Circle : public Shape
+{
+ public:
+   using DrawStrategy = std::function<void(Circle const& /*, ...*/)>;
+
+   explicit Circle( double radius, Point center, DrawStrategy drawer )
+      : radius_( radius )
+      , center_( center )
+      , drawer_( std::move(drawer) )
+   {
+      /* Checking that the given radius is valid and that
+         the given 'std::function' instance is not empty */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_( *this /*, some arguments*/ );
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+//#include <Shape.h>
+#include <functional>
+#include <utility>
+
+class Square : public Shape
+{
+ public:
+   using DrawStrategy = std::function<void(Square const& /*, ...*/)>;
+
+   explicit Square( double side, Point center, DrawStrategy drawer )
+      : side_( side )
+      , center_( center )
+      , drawer_( std::move(drawer) )
+   {
+      /* Checking that the given side length is valid and that
+         the given 'std::function' instance is not empty */
+   }
+
+   void draw( /*some arguments*/ ) const override
+   {
+      drawer_( *this /*, some arguments*/ );
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <Framebuffer.h> ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// An in-memory framebuffer of 32-bit pixels, stored row by row
+class Framebuffer
+{
+ public:
+   Framebuffer( size_t width, size_t height )
+      : width_( width )
+      , height_( height )
+      , pixels_( width*height )
+   {}
+
+   size_t width () const { return width_; }
+   size_t height() const { return height_; }
+
+   std::uint32_t*       row( size_t y )       { return pixels_.data() + y*width_; }
+   std::uint32_t const* row( size_t y ) const { return pixels_.data() + y*width_; }
+
+   void clear( std::uint32_t color = 0U ) { std::fill( begin(pixels_), end(pixels_), color ); }
+
+   friend bool operator==( Framebuffer const&, Framebuffer const& ) = default;
+
+ private:
+   size_t width_;
+   size_t height_;
+   std::vector<std::uint32_t> pixels_;
+};
+
+
+//---- <FillSpan.h> -------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// Fills the pixels [begin,end) of the given row with the given color. On SSE2 capable
+// platforms, four pixels are written per instruction.
+inline void fillSpan( std::uint32_t* row, ptrdiff_t begin, ptrdiff_t end, std::uint32_t color )
+{
+#if defined(__SSE2__)
+   __m128i const pixels( _mm_set1_epi32( static_cast<int>( color ) ) );
+   for( ; begin+4 <= end; begin+=4 ) {
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( row + begin ), pixels );
+   }
+#endif
+   std::fill( row + begin, row + end, color );
+}
+
+
+//---- <TileRasterizer.h> -------------------------------------------------------------------------
+
+//#include <FillSpan.h>
+//#include <Framebuffer.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// A CPU rasterizer for circles and squares. Submitted primitives are binned into square tiles
+// of the framebuffer. flush() rasterizes the tiles in parallel; since every tile is processed
+// by a single thread and in submission order, the result is identical for any number of
+// threads. A pixel is covered if its center lies within the primitive.
+class TileRasterizer
+{
+ public:
+   enum class Primitive : std::uint8_t { circle, square };
+
+   TileRasterizer( Framebuffer& framebuffer, size_t tileSize = 64U
+                 , size_t threads = std::max( std::thread::hardware_concurrency(), 1U ) )
+      : framebuffer_( &framebuffer )
+      , tileSize_( checkTileSize( tileSize ) )
+      , tilesX_( ( framebuffer.width()  + tileSize_ - 1U ) / tileSize_ )
+      , tilesY_( ( framebuffer.height() + tileSize_ - 1U ) / tileSize_ )
+      , threads_( std::max( threads, size_t{1U} ) )
+      , bins_( tilesX_*tilesY_ )
+   {}
+
+   // Submits a primitive with the given center and extent (the radius of a circle or half
+   // the side length of a square)
+   void submit( Primitive primitive, double cx, double cy, double extent, std::uint32_t color )
+   {
+      Range const rows   ( range( cy, extent, 0, height() ) );
+      Range const columns( range( cx, extent, 0, width() ) );
+      if( rows.first >= rows.last || columns.first >= columns.last ) return;
+
+      auto const index( static_cast<std::uint32_t>( primitives_.size() ) );
+      primitives_.push_back( Item{ primitive, color, cx, cy, extent } );
+
+      size_t const tx0( static_cast<size_t>( columns.first ) / tileSize_ );
+      size_t const tx1( static_cast<size_t>( columns.last-1 ) / tileSize_ );
+      size_t const ty0( static_cast<size_t>( rows.first ) / tileSize_ );
+      size_t const ty1( static_cast<size_t>( rows.last-1 ) / tileSize_ );
+      for( size_t ty=ty0; ty<=ty1; ++ty ) {
+         for( size_t tx=tx0; tx<=tx1; ++tx ) {
+            bins_[ty*tilesX_+tx].push_back( index );
+         }
+      }
+   }
+
+   // Rasterizes all submitted primitives into the framebuffer
+   void flush()
+   {
+      std::atomic<size_t> next{};
+      auto const work = [this,&next]() {
+         size_t tile{};
+         while( ( tile = next.fetch_add( 1U, std::memory_order_relaxed ) ) < bins_.size() ) {
+            rasterizeTile( tile );
+         }
+      };
+
+      {
+         std::vector<std::jthread> threads{};
+         threads.reserve( threads_-1U );
+         for( size_t t=1U; t<threads_; ++t ) {
+            threads.emplace_back( work );
+         }
+         work();
+      }
+
+      for( auto& bin : bins_ ) {
+         bin.clear();
+      }
+      primitives_.clear();
+   }
+
+ private:
+   struct Item
+   {
+      Primitive primitive;
+      std::uint32_t color;
+      double cx;
+      double cy;
+      double extent;
+   };
+
+   struct Range
+   {
+      ptrdiff_t first;
+      ptrdiff_t last;
+   };
+
+   static size_t checkTileSize( size_t tileSize )
+   {
+      if( tileSize == 0U ) {
+         throw std::invalid_argument( "Invalid tile size" );
+      }
+      return tileSize;
+   }
+
+   ptrdiff_t width () const { return static_cast<ptrdiff_t>( framebuffer_->width() ); }
+   ptrdiff_t height() const { return static_cast<ptrdiff_t>( framebuffer_->height() ); }
+
+   // The pixels [first,last) with their centers in [c-extent,c+extent), clipped to [lower,upper)
+   static Range range( double c, double extent, ptrdiff_t lower, ptrdiff_t upper )
+   {
+      // Clamping in floating point, since the conversion of NaN, infinite or huge values to
+      // ptrdiff_t is undefined; NaN maps to 'lower', i.e. to an empty range
+      auto const bound = [lower,upper]( double x ) {
+         double const pixel( std::ceil( x - 0.5 ) );
+         if( !( pixel > static_cast<double>( lower ) ) ) return lower;
+         if( pixel >= static_cast<double>( upper ) ) return upper;
+         return static_cast<ptrdiff_t>( pixel );
+      };
+      return Range{ bound( c - extent ), bound( c + extent ) };
+   }
+
+   void rasterizeTile( size_t tile )
+   {
+      auto const tx( static_cast<ptrdiff_t>( ( tile % tilesX_ ) * tileSize_ ) );
+      auto const ty( static_cast<ptrdiff_t>( ( tile / tilesX_ ) * tileSize_ ) );
+      auto const tileSize( static_cast<ptrdiff_t>( tileSize_ ) );
+      ptrdiff_t const right ( std::min( tx + tileSize, width() ) );
+      ptrdiff_t const bottom( std::min( ty + tileSize, height() ) );
+
+      for( std::uint32_t const index : bins_[tile] )
+      {
+         Item const& item( primitives_[index] );
+         Range const rows( range( item.cy, item.extent, ty, bottom ) );
+
+         for( ptrdiff_t y=rows.first; y<rows.last; ++y )
+         {
+            double halfWidth( item.extent );
+            if( item.primitive == Primitive::circle ) {
+               double const dy( static_cast<double>( y ) + 0.5 - item.cy );
+               halfWidth = std::sqrt( std::max( 0.0, item.extent*item.extent - dy*dy ) );
+            }
+
+            Range const span( range( item.cx, halfWidth, tx, right ) );
+            std::uint32_t* const row( framebuffer_->row( static_cast<size_t>( y ) ) );
+            fillSpan( row, span.first, span.last, item.color );
+         }
+      }
+   }
+
+   Framebuffer* framebuffer_;
+   size_t tileSize_;
+   size_t tilesX_;
+   size_t tilesY_;
+   size_t threads_;
+   std::vector<Item> primitives_;
+   std::vector<std::vector<std::uint32_t>> bins_;
+};
+
+
+//---- <RasterCircleStrategy.h> -------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <TileRasterizer.h>
+#include <cstdint>
+
+class RasterCircleStrategy
+{
+ public:
+   explicit RasterCircleStrategy( TileRasterizer& rasterizer, std::uint32_t color )
+      : rasterizer_( &rasterizer )
+      , color_( color )
+   {}
+
+   void operator()( Circle const& circle /*, ...*/ ) const
+   {
+      Point const center( circle.center() );
+      rasterizer_->submit( TileRasterizer::Primitive::circle
+                         , center.x, center.y, circle.radius(), color_ );
+   }
+
+ private:
+   TileRasterizer* rasterizer_;
+   std::uint32_t color_;
+};
+
+
+//---- <RasterSquareStrategy.h> -------------------------------------------------------------------
+
+//#include <Square.h>
+//#include <TileRasterizer.h>
+#include <cstdint>
+
+class RasterSquareStrategy
+{
+ public:
+   explicit RasterSquareStrategy( TileRasterizer& rasterizer, std::uint32_t color )
+      : rasterizer_( &rasterizer )
+      , color_( color )
+   {}
+
+   void operator()( Square const& square /*, ...*/ ) const
+   {
+      Point const center( square.center() );
+      rasterizer_->submit( TileRasterizer::Primitive::square
+                         , center.x, center.y, 0.5*square.side(), color_ );
+   }
+
+ private:
+   TileRasterizer* rasterizer_;
+   std::uint32_t color_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Framebuffer.h>
+//#include <RasterCircleStrategy.h>
+//#include <RasterSquareStrategy.h>
+//#include <TileRasterizer.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   constexpr std::uint32_t red  ( 0xFF0000FFU );
+   constexpr std::uint32_t green( 0xFF00FF00U );
+   constexpr std::uint32_t blue ( 0xFFFF0000U );
+
+   Framebuffer parallel( 640U, 480U );
+   Framebuffer serial  ( 640U, 480U );
+
+   TileRasterizer rasterizer( parallel, 64U, 4U );
+   TileRasterizer reference ( serial, 64U, 1U );
+
+   // Drawing the same scene into two framebuffers, once with four threads and once with a
+   // single thread
+   for( TileRasterizer* r : { &rasterizer, &reference } )
+   {
+      Shapes shapes{};
+
+      // Creating some shapes, each one
+      //   equipped with the according rasterizer drawing strategy
+      shapes.emplace_back(
+         std::make_unique<Circle>(
+            123.0, Point{ 200.0, 150.0 }, RasterCircleStrategy( *r, red ) ) );
+      shapes.emplace_back(
+         std::make_unique<Square>(
+            180.0, Point{ 300.0, 260.0 }, RasterSquareStrategy( *r, green ) ) );
+      shapes.emplace_back(
+         std::make_unique<Circle>(
+            90.0, Point{ 600.0, 450.0 }, RasterCircleStrategy( *r, blue ) ) );
+
+      // Drawing all shapes
+      for( auto const& shape : shapes )
+      {
+         shape->draw();
+      }
+
+      r->flush();
+   }
+
+   bool const correct( parallel == serial &&
+                       parallel.row( 150U )[200U] == red &&
+                       parallel.row( 260U )[300U] == green &&
+                       parallel.row( 470U )[630U] == blue &&
+                       parallel.row( 0U )[639U] == 0U );
+
+   return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
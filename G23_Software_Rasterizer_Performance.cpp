@@ -0,0 +1,280 @@
+/**************************************************************************************************
+*
+* \file G23_Software_Rasterizer_Performance.cpp
+* \brief Guideline 23: Prefer a Value-Based Implementation of Strategy and Command
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to rasterize a
+* scene of random circles and squares into a 1920x1080 framebuffer by means of the tile-parallel
+* software rasterizer, for an increasing number of worker threads.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t width ( 1920U );   // Width of the framebuffer
+constexpr size_t height( 1080U );   // Height of the framebuffer
+constexpr size_t shapes( 10000U );  // Number of shapes per frame
+constexpr size_t tileSize( 64U );   // Width and height of the tiles
+
+#define BENCHMARK_TILE_RASTERIZER 1  // Tile-parallel rasterization with 1 to 8 threads
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 50.0 );
+std::uniform_real_distribution<double> xpos( 0.0, static_cast<double>( width ) );
+std::uniform_real_distribution<double> ypos( 0.0, static_cast<double>( height ) );
+std::uniform_int_distribution<std::uint32_t> colors{};
+std::bernoulli_distribution coin{};
+
+
+//---- Tile rasterizer ----------------------------------------------------------------------------
+
+// An in-memory framebuffer of 32-bit pixels, stored row by row
+class Framebuffer
+{
+ public:
+   Framebuffer( size_t width, size_t height )
+      : width_( width )
+      , height_( height )
+      , pixels_( width*height )
+   {}
+
+   size_t width () const { return width_; }
+   size_t height() const { return height_; }
+
+   std::uint32_t*       row( size_t y )       { return pixels_.data() + y*width_; }
+   std::uint32_t const* row( size_t y ) const { return pixels_.data() + y*width_; }
+
+   void clear( std::uint32_t color = 0U ) { std::fill( begin(pixels_), end(pixels_), color ); }
+
+   friend bool operator==( Framebuffer const&, Framebuffer const& ) = default;
+
+ private:
+   size_t width_;
+   size_t height_;
+   std::vector<std::uint32_t> pixels_;
+};
+
+// Fills the pixels [begin,end) of the given row with the given color. On SSE2 capable
+// platforms, four pixels are written per instruction.
+inline void fillSpan( std::uint32_t* row, ptrdiff_t begin, ptrdiff_t end, std::uint32_t color )
+{
+#if defined(__SSE2__)
+   __m128i const pixels( _mm_set1_epi32( static_cast<int>( color ) ) );
+   for( ; begin+4 <= end; begin+=4 ) {
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( row + begin ), pixels );
+   }
+#endif
+   std::fill( row + begin, row + end, color );
+}
+
+// A CPU rasterizer for circles and squares. Submitted primitives are binned into square tiles
+// of the framebuffer. flush() rasterizes the tiles in parallel; since every tile is processed
+// by a single thread and in submission order, the result is identical for any number of
+// threads. A pixel is covered if its center lies within the primitive.
+class TileRasterizer
+{
+ public:
+   enum class Primitive : std::uint8_t { circle, square };
+
+   TileRasterizer( Framebuffer& framebuffer, size_t tileSize = 64U
+                 , size_t threads = std::max( std::thread::hardware_concurrency(), 1U ) )
+      : framebuffer_( &framebuffer )
+      , tileSize_( checkTileSize( tileSize ) )
+      , tilesX_( ( framebuffer.width()  + tileSize_ - 1U ) / tileSize_ )
+      , tilesY_( ( framebuffer.height() + tileSize_ - 1U ) / tileSize_ )
+      , threads_( std::max( threads, size_t{1U} ) )
+      , bins_( tilesX_*tilesY_ )
+   {}
+
+   // Submits a primitive with the given center and extent (the radius of a circle or half
+   // the side length of a square)
+   void submit( Primitive primitive, double cx, double cy, double extent, std::uint32_t color )
+   {
+      Range const rows   ( range( cy, extent, 0, height() ) );
+      Range const columns( range( cx, extent, 0, width() ) );
+      if( rows.first >= rows.last || columns.first >= columns.last ) return;
+
+      auto const index( static_cast<std::uint32_t>( primitives_.size() ) );
+      primitives_.push_back( Item{ primitive, color, cx, cy, extent } );
+
+      size_t const tx0( static_cast<size_t>( columns.first ) / tileSize_ );
+      size_t const tx1( static_cast<size_t>( columns.last-1 ) / tileSize_ );
+      size_t const ty0( static_cast<size_t>( rows.first ) / tileSize_ );
+      size_t const ty1( static_cast<size_t>( rows.last-1 ) / tileSize_ );
+      for( size_t ty=ty0; ty<=ty1; ++ty ) {
+         for( size_t tx=tx0; tx<=tx1; ++tx ) {
+            bins_[ty*tilesX_+tx].push_back( index );
+         }
+      }
+   }
+
+   // Rasterizes all submitted primitives into the framebuffer
+   void flush()
+   {
+      std::atomic<size_t> next{};
+      auto const work = [this,&next]() {
+         size_t tile{};
+         while( ( tile = next.fetch_add( 1U, std::memory_order_relaxed ) ) < bins_.size() ) {
+            rasterizeTile( tile );
+         }
+      };
+
+      {
+         std::vector<std::jthread> threads{};
+         threads.reserve( threads_-1U );
+         for( size_t t=1U; t<threads_; ++t ) {
+            threads.emplace_back( work );
+         }
+         work();
+      }
+
+      for( auto& bin : bins_ ) {
+         bin.clear();
+      }
+      primitives_.clear();
+   }
+
+ private:
+   struct Item
+   {
+      Primitive primitive;
+      std::uint32_t color;
+      double cx;
+      double cy;
+      double extent;
+   };
+
+   struct Range
+   {
+      ptrdiff_t first;
+      ptrdiff_t last;
+   };
+
+   static size_t checkTileSize( size_t tileSize )
+   {
+      if( tileSize == 0U ) {
+         throw std::invalid_argument( "Invalid tile size" );
+      }
+      return tileSize;
+   }
+
+   ptrdiff_t width () const { return static_cast<ptrdiff_t>( framebuffer_->width() ); }
+   ptrdiff_t height() const { return static_cast<ptrdiff_t>( framebuffer_->height() ); }
+
+   // The pixels [first,last) with their centers in [c-extent,c+extent), clipped to [lower,upper)
+   static Range range( double c, double extent, ptrdiff_t lower, ptrdiff_t upper )
+   {
+      // Clamping in floating point, since the conversion of NaN, infinite or huge values to
+      // ptrdiff_t is undefined; NaN maps to 'lower', i.e. to an empty range
+      auto const bound = [lower,upper]( double x ) {
+         double const pixel( std::ceil( x - 0.5 ) );
+         if( !( pixel > static_cast<double>( lower ) ) ) return lower;
+         if( pixel >= static_cast<double>( upper ) ) return upper;
+         return static_cast<ptrdiff_t>( pixel );
+      };
+      return Range{ bound( c - extent ), bound( c + extent ) };
+   }
+
+   void rasterizeTile( size_t tile )
+   {
+      auto const tx( static_cast<ptrdiff_t>( ( tile % tilesX_ ) * tileSize_ ) );
+      auto const ty( static_cast<ptrdiff_t>( ( tile / tilesX_ ) * tileSize_ ) );
+      auto const tileSize( static_cast<ptrdiff_t>( tileSize_ ) );
+      ptrdiff_t const right ( std::min( tx + tileSize, width() ) );
+      ptrdiff_t const bottom( std::min( ty + tileSize, height() ) );
+
+      for( std::uint32_t const index : bins_[tile] )
+      {
+         Item const& item( primitives_[index] );
+         Range const rows( range( item.cy, item.extent, ty, bottom ) );
+
+         for( ptrdiff_t y=rows.first; y<rows.last; ++y )
+         {
+            double halfWidth( item.extent );
+            if( item.primitive == Primitive::circle ) {
+               double const dy( static_cast<double>( y ) + 0.5 - item.cy );
+               halfWidth = std::sqrt( std::max( 0.0, item.extent*item.extent - dy*dy ) );
+            }
+
+            Range const span( range( item.cx, halfWidth, tx, right ) );
+            std::uint32_t* const row( framebuffer_->row( static_cast<size_t>( y ) ) );
+            fillSpan( row, span.first, span.last, item.color );
+         }
+      }
+   }
+
+   Framebuffer* framebuffer_;
+   size_t tileSize_;
+   size_t tilesX_;
+   size_t tilesY_;
+   size_t threads_;
+   std::vector<Item> primitives_;
+   std::vector<std::vector<std::uint32_t>> bins_;
+};
+
+
+//---- Benchmark for the tile rasterizer ----------------------------------------------------------
+
+struct Primitive
+{
+   TileRasterizer::Primitive primitive;
+   double cx;
+   double cy;
+   double extent;
+   std::uint32_t color;
+};
+
+static void tileRasterizer(benchmark::State& state)
+{
+   std::vector<Primitive> scene( shapes );
+   std::generate( begin(scene), end(scene), []{
+      return Primitive{ coin( rng ) ? TileRasterizer::Primitive::circle
+                                    : TileRasterizer::Primitive::square
+                      , xpos( rng ), ypos( rng ), dist( rng ), colors( rng ) };
+   } );
+
+   Framebuffer framebuffer( width, height );
+   TileRasterizer rasterizer( framebuffer, tileSize, static_cast<size_t>( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      for( Primitive const& p : scene ) {
+         rasterizer.submit( p.primitive, p.cx, p.cy, p.extent, p.color );
+      }
+      rasterizer.flush();
+      benchmark::DoNotOptimize( framebuffer.row( 0U ) );
+   }
+
+   state.SetItemsProcessed( state.iterations() * shapes );
+}
+#if BENCHMARK_TILE_RASTERIZER
+BENCHMARK(tileRasterizer)->RangeMultiplier(2)->Range(1,8)->UseRealTime();
+#endif
+
@@ -0,0 +1,368 @@
+/**************************************************************************************************
+*
+* \file G25_Inplace_Observer.cpp
+* \brief Guideline 25: Apply Observers as an Abstract Notification Mechanism
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <InplaceFunction.h> ------------------------------------------------------------------------
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template< typename Signature
+        , size_t Capacity = 32U
+        , size_t Alignment = alignof(std::max_align_t) >
+class inplace_function;
+
+// A move-only replacement for std::function, which stores the callable in an in-class buffer
+// of 'Capacity' bytes. Callables that do not fit into the buffer are rejected at compile time,
+// i.e. an inplace_function never allocates dynamic memory. The invoke function is stored
+// directly in the object, so a call costs a single indirect function call. Calling an empty
+// inplace_function results in a std::bad_function_call exception, which does not require a
+// check for emptiness on the call path.
+template< typename R, typename... Args, size_t Capacity, size_t Alignment >
+class inplace_function<R(Args...),Capacity,Alignment>
+{
+ public:
+   inplace_function() = default;
+
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,inplace_function> &&
+                 std::is_invocable_r_v<R,std::decay_t<F>&,Args...> )
+   inplace_function( F&& f )
+   {
+      using Callable = std::decay_t<F>;
+
+      static_assert( sizeof(Callable) <= Capacity, "Callable exceeds the buffer capacity" );
+      static_assert( Alignment % alignof(Callable) == 0U, "Callable is overaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Callable>
+                   , "Callable must be nothrow move constructible" );
+
+      ::new (buffer_) Callable( std::forward<F>(f) );
+      invoke_ = &invoke<Callable>;
+      ops_ = &ops<Callable>;
+   }
+
+   inplace_function( inplace_function&& other ) noexcept
+      : invoke_( other.invoke_ )
+      , ops_( other.ops_ )
+   {
+      ops_->move( other.buffer_, buffer_ );
+      other.invoke_ = &empty;
+      other.ops_ = &emptyOps;
+   }
+
+   inplace_function& operator=( inplace_function&& other ) noexcept
+   {
+      if( this != &other ) {
+         ops_->destroy( buffer_ );
+         invoke_ = other.invoke_;
+         ops_ = other.ops_;
+         ops_->move( other.buffer_, buffer_ );
+         other.invoke_ = &empty;
+         other.ops_ = &emptyOps;
+      }
+      return *this;
+   }
+
+   ~inplace_function() { ops_->destroy( buffer_ ); }
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( buffer_, std::forward<Args>(args)... );
+   }
+
+   explicit operator bool() const { return ops_ != &emptyOps; }
+
+ private:
+   struct Ops
+   {
+      void (*move)( std::byte* src, std::byte* dst ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename Callable >
+   static R invoke( std::byte const* buffer, Args&&... args )
+   {
+      // Like std::function, a const inplace_function invokes a non-const callable
+      std::byte* const storage( const_cast<std::byte*>( buffer ) );
+      Callable& callable( *std::launder( reinterpret_cast<Callable*>( storage ) ) );
+      return std::invoke( callable, std::forward<Args>(args)... );
+   }
+
+   template< typename Callable >
+   static constexpr Ops ops{
+        []( std::byte* src, std::byte* dst ) noexcept {
+           auto* callable( std::launder( reinterpret_cast<Callable*>( src ) ) );
+           ::new (dst) Callable( std::move(*callable) );
+           callable->~Callable();
+        }
+      , []( std::byte* buffer ) noexcept {
+           std::launder( reinterpret_cast<Callable*>( buffer ) )->~Callable();
+        } };
+
+   static constexpr Ops emptyOps{
+        []( std::byte*, std::byte* ) noexcept {}
+      , []( std::byte* ) noexcept {} };
+
+   static R empty( std::byte const*, Args&&... ) { throw std::bad_function_call{}; }
+
+   R (*invoke_)( std::byte const*, Args&&... ){ &empty };
+   Ops const* ops_{ &emptyOps };
+   alignas(Alignment) std::byte buffer_[Capacity];
+};
+
+
+//---- <FunctionRef.h> ----------------------------------------------------------------------------
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template< typename Signature >
+class function_ref;
+
+// A non-owning reference to a callable. A function_ref consists of two pointers only and is
+// trivially copyable, but it is the responsibility of the user to guarantee that the referenced
+// callable outlives the function_ref.
+template< typename R, typename... Args >
+class function_ref<R(Args...)>
+{
+ public:
+   template< typename F >
+      requires ( !std::is_same_v<std::remove_cvref_t<F>,function_ref> &&
+                 !std::is_function_v<std::remove_reference_t<F>> &&
+                 std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F&& f )
+      : object_( const_cast<void*>( static_cast<void const*>( std::addressof(f) ) ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           using Callable = std::remove_reference_t<F>;
+           return std::invoke( *static_cast<Callable*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   template< typename F >
+      requires ( std::is_function_v<F> && std::is_invocable_r_v<R,F&,Args...> )
+   function_ref( F* f )
+      : object_( reinterpret_cast<void*>( f ) )
+      , invoke_( []( void* object, Args&&... args ) -> R {
+           return std::invoke( reinterpret_cast<F*>( object ), std::forward<Args>(args)... );
+        } )
+   {}
+
+   R operator()( Args... args ) const
+   {
+      return invoke_( object_, std::forward<Args>(args)... );
+   }
+
+ private:
+   void* object_;
+   R (*invoke_)( void*, Args&&... );
+};
+
+
+//---- <Observer.h> -------------------------------------------------------------------------------
+
+//#include <InplaceFunction.h>
+#include <utility>
+
+// The type of the callable is a template parameter. By default, the observer owns its callable
+// by means of an inplace_function, which does not allocate. Alternatively, a function_ref can
+// be used, in which case the referenced callable has to outlive the observer.
+template< typename Subject
+        , typename StateTag
+        , typename OnUpdateT = inplace_function<void(Subject const&,StateTag)> >
+class Observer
+{
+ public:
+   using OnUpdate = OnUpdateT;
+
+   // No virtual destructor necessary
+
+   explicit Observer( OnUpdate onUpdate )
+      : onUpdate_{ std::move(onUpdate) }
+   {
+      // Possibly respond on an invalid/empty function instance
+   }
+
+   // Non-virtual update function
+   void update( Subject const& subject, StateTag property )
+   {
+      onUpdate_( subject, property );
+   }
+
+ private:
+   OnUpdate onUpdate_;
+};
+
+
+//---- <Person.h> ---------------------------------------------------------------------------------
+
+//#include <Observer.h>
+#include <string>
+#include <set>
+
+class Person
+{
+ public:
+   enum StateChange
+   {
+      forenameChanged,
+      surnameChanged,
+      addressChanged
+   };
+
+   using PersonObserver = Observer<Person,StateChange>;
+
+   explicit Person( std::string forename, std::string surname )
+      : forename_{ std::move(forename) }
+      , surname_{ std::move(surname) }
+   {}
+
+   bool attach( PersonObserver* observer );
+   bool detach( PersonObserver* observer );
+
+   void notify( StateChange property );
+
+   void forename( std::string newForename );
+   void surname ( std::string newSurname );
+   void address ( std::string newAddress );
+
+   std::string const& forename() const { return forename_; }
+   std::string const& surname () const { return surname_; }
+   std::string const& address () const { return address_; }
+
+ private:
+   std::string forename_;
+   std::string surname_;
+   std::string address_;
+
+   std::set<PersonObserver*> observers_;
+};
+
+
+//---- <Person.cpp> -------------------------------------------------------------------------------
+
+//#include <Person.h>
+
+void Person::forename( std::string newForename )
+{
+   forename_ = std::move(newForename);
+   notify( forenameChanged );
+}
+
+void Person::surname( std::string newSurname )
+{
+   surname_ = std::move(newSurname);
+   notify( surnameChanged );
+}
+
+void Person::address( std::string newAddress )
+{
+   address_ = std::move(newAddress);
+   notify( addressChanged );
+}
+
+bool Person::attach( PersonObserver* observer )
+{
+   auto [pos,success] = observers_.insert( observer );
+   return success;
+}
+
+bool Person::detach( PersonObserver* observer )
+{
+   return ( observers_.erase( observer ) > 0U );
+}
+
+void Person::notify( StateChange property )
+{
+   // This formulation makes sure detach() operations
+   // can be detected during the iteration
+   for( auto iter=begin(observers_); iter!=end(observers_); )
+   {
+      auto const pos = iter++;
+      (*pos)->update(*this,property);
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Observer.h>
+//#include <Person.h>
+#include <cstdlib>
+
+void propertyChanged( Person const& person, Person::StateChange property )
+{
+   if( property == Person::forenameChanged ||
+       property == Person::surnameChanged )
+   {
+      // ... Respond to changed name
+   }
+}
+
+int main()
+{
+   using PersonObserver = Observer<Person,Person::StateChange>;
+
+   PersonObserver nameObserver( propertyChanged );
+
+   PersonObserver addressObserver(
+      [/*captured state*/]( Person const& person, Person::StateChange property ){
+         if( property == Person::addressChanged )
+         {
+            // ... Respond to changed address
+         }
+      } );
+
+   Person homer( "Homer"     , "Simpson" );
+   Person marge( "Marge"     , "Simpson" );
+   Person monty( "Montgomery", "Burns"   );
+
+   // Attaching observers
+   homer.attach( &nameObserver );
+   marge.attach( &addressObserver );
+   monty.attach( &addressObserver );
+
+   // An observer referring to, instead of owning its callable
+   using PersonObserverRef =
+      Observer<Person,Person::StateChange,function_ref<void(Person const&,Person::StateChange)>>;
+
+   PersonObserverRef nameObserverRef( propertyChanged );
+   nameObserverRef.update( homer, Person::forenameChanged );
+
+   // An observer taking over a callable with non-trivial state destroys it exactly once
+   int live{};
+   {
+      struct Tracker
+      {
+         explicit Tracker( int& l ) : live( &l ) { ++*live; }
+         Tracker( Tracker const& other ) : live( other.live ) { ++*live; }
+         Tracker( Tracker&& other ) noexcept : live( other.live ) { ++*live; }
+         ~Tracker() { --*live; }
+
+         int* live;
+      };
+
+      PersonObserver trackingObserver(
+         [tracker=Tracker{ live }]( Person const&, Person::StateChange ){} );
+      trackingObserver.update( homer, Person::addressChanged );
+   }
+   if( live != 0 ) return EXIT_FAILURE;
+
+   // ...
+
+   return EXIT_SUCCESS;
+}
+
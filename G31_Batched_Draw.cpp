@@ -0,0 +1,248 @@
+/**************************************************************************************************
+*
+* \file G31_Batched_Draw.cpp
+* \brief Guideline 31: Use External Polymorphism for Nonintrusive Runtime Polymorphism
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+class ShapeConcept
+{
+ public:
+   virtual ~ShapeConcept() = default;
+
+   virtual void draw() const = 0;
+
+   // ... Potentially more polymorphic operations
+};
+
+
+// The model is declared 'final', which enables the compiler to resolve calls to draw() on a
+// ShapeModel (in contrast to calls on a ShapeConcept) statically
+template< typename ShapeT
+        , typename DrawStrategy >
+class ShapeModel final : public ShapeConcept
+{
+ public:
+   explicit ShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <ShapeBatches.h> ---------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// The polymorphic interface of a batch, i.e. of all shapes of one particular model type
+class BatchConcept
+{
+ public:
+   virtual ~BatchConcept() = default;
+
+   virtual void drawBatch() const = 0;
+   virtual size_t size() const = 0;
+};
+
+// A batch stores the models of a single type contiguously and by value. drawBatch() loops over
+// the concrete models, i.e. the draw() calls are static and the drawing strategy can be inlined.
+template< typename ShapeT
+        , typename DrawStrategy >
+class Batch final : public BatchConcept
+{
+ public:
+   using Model = ShapeModel<ShapeT,DrawStrategy>;
+
+   void add( ShapeT shape, DrawStrategy drawer )
+   {
+      models_.emplace_back( std::move(shape), std::move(drawer) );
+   }
+
+   void drawBatch() const override
+   {
+      for( Model const& model : models_ ) {
+         model.draw();
+      }
+   }
+
+   size_t size() const override { return models_.size(); }
+
+ private:
+   std::vector<Model> models_;
+};
+
+// A collection of shapes, grouped by their model type upon insertion. Drawing all shapes
+// requires a single virtual function call per model type instead of one per shape. Note that
+// the shapes are drawn batch by batch, i.e. not in the order of insertion.
+class ShapeBatches
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   void add( ShapeT shape, DrawStrategy drawer )
+   {
+      batch<ShapeT,DrawStrategy>().add( std::move(shape), std::move(drawer) );
+   }
+
+   void drawAll() const
+   {
+      for( auto const& entry : batches_ ) {
+         entry.batch->drawBatch();
+      }
+   }
+
+   size_t size() const
+   {
+      size_t count{};
+      for( auto const& entry : batches_ ) {
+         count += entry.batch->size();
+      }
+      return count;
+   }
+
+ private:
+   // The address of this variable serves as unique key for every model type
+   template< typename ShapeT, typename DrawStrategy >
+   static constexpr char key{};
+
+   struct Entry
+   {
+      void const* key;
+      std::unique_ptr<BatchConcept> batch;
+   };
+
+   // Since a scene usually contains only a handful of model types, a linear search beats
+   // any hashing
+   template< typename ShapeT, typename DrawStrategy >
+   Batch<ShapeT,DrawStrategy>& batch()
+   {
+      using BatchT = Batch<ShapeT,DrawStrategy>;
+
+      void const* const k( &key<ShapeT,DrawStrategy> );
+      for( auto const& entry : batches_ ) {
+         if( entry.key == k ) {
+            return static_cast<BatchT&>( *entry.batch );
+         }
+      }
+
+      auto b( std::make_unique<BatchT>() );
+      BatchT& result( *b );
+      batches_.push_back( Entry{ k, std::move(b) } );
+      return result;
+   }
+
+   std::vector<Entry> batches_;
+};
+
+
+//---- <OpenGLDrawStrategy.h> ---------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* OpenGL graphics library headers */
+
+class OpenGLDrawStrategy
+{
+ public:
+   explicit OpenGLDrawStrategy( /* Drawing related arguments */ )
+   {}
+
+   void operator()( Circle const& circle ) const
+   {
+      // ... Implementing the logic for drawing a circle by means of OpenGL
+   }
+   void operator()( Square const& square ) const
+   {
+      // ... Implementing the logic for drawing a square by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g., colors, textures, ... */
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <ShapeBatches.h>
+//#include <OpenGLDrawStrategy.h>
+#include <cstdlib>
+
+int main()
+{
+   ShapeBatches shapes{};
+
+   // Creating some shapes, each one
+   //   equipped with an OpenGL drawing strategy
+   shapes.add( Circle{2.3}, OpenGLDrawStrategy(/*...red...*/) );
+   shapes.add( Square{1.2}, OpenGLDrawStrategy(/*...green...*/) );
+   shapes.add( Circle{4.1}, OpenGLDrawStrategy(/*...blue...*/) );
+
+   // Drawing all shapes, one batch per model type
+   shapes.drawAll();
+
+   return EXIT_SUCCESS;
+}
+
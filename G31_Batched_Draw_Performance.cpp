@@ -0,0 +1,254 @@
+/**************************************************************************************************
+*
+* \file G31_Batched_Draw_Performance.cpp
+* \brief Guideline 31: Use External Polymorphism for Nonintrusive Runtime Polymorphism
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to draw all
+* shapes stored in a std::vector of std::unique_ptrs to ShapeConcept (one virtual function
+* call per shape) in comparison to shapes grouped into batches by model type (one virtual
+* function call per model type).
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_POINTER_VECTOR 1  // std::vector<std::unique_ptr<ShapeConcept>>
+#define BENCHMARK_SHAPE_BATCHES  1  // Shapes grouped into batches by model type
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+double get_random_size()
+{
+   return dist( rng );
+}
+
+bool is_circle()
+{
+   return coin( rng );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+class ShapeConcept
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class ShapeModel final : public ShapeConcept
+{
+ public:
+   explicit ShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+// Instead of drawing, the strategy accumulates the covered area
+class AreaDrawStrategy
+{
+ public:
+   explicit AreaDrawStrategy( double* total ) : total_( total ) {}
+
+   void operator()( Circle const& c ) const { *total_ += std::numbers::pi*c.radius()*c.radius(); }
+   void operator()( Square const& s ) const { *total_ += s.side()*s.side(); }
+
+ private:
+   double* total_;
+};
+
+
+//---- Shape batches ------------------------------------------------------------------------------
+
+class BatchConcept
+{
+ public:
+   virtual ~BatchConcept() = default;
+   virtual void drawBatch() const = 0;
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class Batch final : public BatchConcept
+{
+ public:
+   using Model = ShapeModel<ShapeT,DrawStrategy>;
+
+   void add( ShapeT shape, DrawStrategy drawer )
+   {
+      models_.emplace_back( std::move(shape), std::move(drawer) );
+   }
+
+   void drawBatch() const override
+   {
+      for( Model const& model : models_ ) {
+         model.draw();
+      }
+   }
+
+ private:
+   std::vector<Model> models_;
+};
+
+class ShapeBatches
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   void add( ShapeT shape, DrawStrategy drawer )
+   {
+      batch<ShapeT,DrawStrategy>().add( std::move(shape), std::move(drawer) );
+   }
+
+   void drawAll() const
+   {
+      for( auto const& entry : batches_ ) {
+         entry.batch->drawBatch();
+      }
+   }
+
+ private:
+   template< typename ShapeT, typename DrawStrategy >
+   static constexpr char key{};
+
+   struct Entry
+   {
+      void const* key;
+      std::unique_ptr<BatchConcept> batch;
+   };
+
+   template< typename ShapeT, typename DrawStrategy >
+   Batch<ShapeT,DrawStrategy>& batch()
+   {
+      using BatchT = Batch<ShapeT,DrawStrategy>;
+
+      void const* const k( &key<ShapeT,DrawStrategy> );
+      for( auto const& entry : batches_ ) {
+         if( entry.key == k ) {
+            return static_cast<BatchT&>( *entry.batch );
+         }
+      }
+
+      auto b( std::make_unique<BatchT>() );
+      BatchT& result( *b );
+      batches_.push_back( Entry{ k, std::move(b) } );
+      return result;
+   }
+
+   std::vector<Entry> batches_;
+};
+
+
+//---- Benchmark for the pointer vector -----------------------------------------------------------
+
+static void pointerVector(benchmark::State& state)
+{
+   using CircleModel = ShapeModel<Circle,AreaDrawStrategy>;
+   using SquareModel = ShapeModel<Square,AreaDrawStrategy>;
+
+   double total{};
+   std::vector<std::unique_ptr<ShapeConcept>> shapes{};
+   for( size_t i=0U; i<static_cast<size_t>( state.range(0) ); ++i ) {
+      if( is_circle() )
+         shapes.emplace_back( std::make_unique<CircleModel>(
+            Circle{ get_random_size() }, AreaDrawStrategy{ &total } ) );
+      else
+         shapes.emplace_back( std::make_unique<SquareModel>(
+            Square{ get_random_size() }, AreaDrawStrategy{ &total } ) );
+   }
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         shape->draw();
+      }
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_POINTER_VECTOR
+BENCHMARK(pointerVector)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for the shape batches ------------------------------------------------------------
+
+static void shapeBatches(benchmark::State& state)
+{
+   double total{};
+   ShapeBatches shapes{};
+   for( size_t i=0U; i<static_cast<size_t>( state.range(0) ); ++i ) {
+      if( is_circle() )
+         shapes.add( Circle{ get_random_size() }, AreaDrawStrategy{ &total } );
+      else
+         shapes.add( Square{ get_random_size() }, AreaDrawStrategy{ &total } );
+   }
+
+   for( auto _ : state )
+   {
+      shapes.drawAll();
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_SHAPE_BATCHES
+BENCHMARK(shapeBatches)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
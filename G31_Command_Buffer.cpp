@@ -0,0 +1,432 @@
+/**************************************************************************************************
+*
+* \file G31_Command_Buffer.cpp
+* \brief Guideline 31: Use External Polymorphism for Nonintrusive Runtime Polymorphism
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Point.h> ----------------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius, Point center = {} )
+      : radius_( radius )
+      , center_( center )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   Point center_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <Point.h>
+
+class Square
+{
+ public:
+   explicit Square( double side, Point center = {} )
+      : side_( side )
+      , center_( center )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   Point center_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+class ShapeConcept
+{
+ public:
+   virtual ~ShapeConcept() = default;
+
+   virtual void draw() const = 0;
+
+   // ... Potentially more polymorphic operations
+};
+
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class ShapeModel : public ShapeConcept
+{
+ public:
+   explicit ShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <DrawCommand.h> ----------------------------------------------------------------------------
+
+#include <cstdint>
+#include <type_traits>
+
+enum class Primitive : std::uint8_t
+{
+   circle,
+   square
+};
+
+// Maps the unit primitive (unit circle or unit square centered at the origin) to the shape
+struct Transform
+{
+   float x;
+   float y;
+   float scale;
+};
+
+using StyleIndex = std::uint32_t;
+
+// A compact, trivially copyable record of a single draw call
+struct DrawCommand
+{
+   Primitive primitive;
+   StyleIndex style;
+   Transform transform;
+};
+
+static_assert( std::is_trivially_copyable_v<DrawCommand> );
+
+
+//---- <DrawSink.h> -------------------------------------------------------------------------------
+
+//#include <DrawCommand.h>
+#include <span>
+
+// The interface of the consumers of recorded draw commands, e.g. a graphics API or a test
+// rasterizer. A sink is called once per state change and once per batch, never per command.
+class DrawSink
+{
+ public:
+   virtual ~DrawSink() = default;
+
+   virtual void setStyle( StyleIndex style ) = 0;
+   virtual void drawBatch( Primitive primitive, std::span<DrawCommand const> commands ) = 0;
+};
+
+
+//---- <CommandBuffer.h> --------------------------------------------------------------------------
+
+//#include <DrawCommand.h>
+//#include <DrawSink.h>
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// A linear buffer of draw commands. The buffer is meant to be reused from frame to frame:
+// clear() drops the recorded commands, but keeps the memory. Upon replay the commands are
+// sorted by state (style first, then primitive), such that every state change and every batch
+// results in a single call to the sink. Since the sort is stable, commands with the same state
+// keep their recording order. Commands with different states, however, may be reordered, i.e.
+// the shapes must not depend on the drawing order (as for instance in case of a depth test).
+class CommandBuffer
+{
+ public:
+   void record( DrawCommand const& command ) { commands_.push_back( command ); }
+
+   void clear() { commands_.clear(); }
+
+   size_t size() const { return commands_.size(); }
+
+   void replay( DrawSink& sink )
+   {
+      std::stable_sort( begin(commands_), end(commands_), []( auto const& a, auto const& b ){
+         return sortKey( a ) < sortKey( b );
+      } );
+
+      auto first( begin(commands_) );
+      bool initial( true );
+      StyleIndex style{};
+
+      while( first != end(commands_) )
+      {
+         std::uint64_t const key( sortKey( *first ) );
+         auto const last( std::find_if( first, end(commands_), [key]( auto const& c ){
+            return sortKey( c ) != key;
+         } ) );
+
+         if( initial || first->style != style ) {
+            style = first->style;
+            sink.setStyle( style );
+            initial = false;
+         }
+         sink.drawBatch( first->primitive, std::span<DrawCommand const>( first, last ) );
+
+         first = last;
+      }
+   }
+
+ private:
+   static std::uint64_t sortKey( DrawCommand const& command )
+   {
+      return ( std::uint64_t{ command.style } << 8U )
+           | static_cast<std::uint64_t>( command.primitive );
+   }
+
+   std::vector<DrawCommand> commands_;
+};
+
+
+//---- <RecordingDrawStrategy.h> ------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <CommandBuffer.h>
+
+// A drawing strategy that, instead of drawing immediately, records a draw command into the
+// given command buffer
+class RecordingDrawStrategy
+{
+ public:
+   explicit RecordingDrawStrategy( CommandBuffer& buffer, StyleIndex style )
+      : buffer_( &buffer )
+      , style_( style )
+   {}
+
+   void operator()( Circle const& circle ) const
+   {
+      Point const center( circle.center() );
+      buffer_->record( DrawCommand{ Primitive::circle, style_
+                                  , Transform{ static_cast<float>( center.x )
+                                             , static_cast<float>( center.y )
+                                             , static_cast<float>( circle.radius() ) } } );
+   }
+   void operator()( Square const& square ) const
+   {
+      Point const center( square.center() );
+      buffer_->record( DrawCommand{ Primitive::square, style_
+                                  , Transform{ static_cast<float>( center.x )
+                                             , static_cast<float>( center.y )
+                                             , static_cast<float>( 0.5*square.side() ) } } );
+   }
+
+ private:
+   CommandBuffer* buffer_;
+   StyleIndex style_;
+};
+
+
+//---- <MemoryRasterizer.h> -----------------------------------------------------------------------
+
+//#include <DrawSink.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// A headless sink that rasterizes the draw commands into an in-memory framebuffer. Every
+// style is mapped to a color of the given (non-empty) palette. One unit of the shape coordinates
+// corresponds to one pixel; a pixel is covered if its center lies within the shape.
+class MemoryRasterizer : public DrawSink
+{
+ public:
+   MemoryRasterizer( size_t width, size_t height, std::vector<std::uint32_t> palette )
+      : width_( width )
+      , height_( height )
+      , palette_( std::move(palette) )
+      , pixels_( width*height )
+   {
+      if( palette_.empty() ) {
+         throw std::invalid_argument( "Empty palette" );
+      }
+   }
+
+   void setStyle( StyleIndex style ) override
+   {
+      color_ = palette_[style % palette_.size()];
+      ++styleChanges_;
+   }
+
+   void drawBatch( Primitive primitive, std::span<DrawCommand const> commands ) override
+   {
+      ++batches_;
+      for( DrawCommand const& command : commands ) {
+         Transform const& t( command.transform );
+         if( primitive == Primitive::circle ) fillCircle( t.x, t.y, t.scale );
+         else                                 fillSquare( t.x, t.y, t.scale );
+      }
+   }
+
+   void clear( std::uint32_t color = 0U ) { std::fill( begin(pixels_), end(pixels_), color ); }
+
+   std::uint32_t pixel( size_t x, size_t y ) const { return pixels_[y*width_+x]; }
+
+   size_t styleChanges() const { return styleChanges_; }
+   size_t batches() const { return batches_; }
+
+ private:
+   // The index of the first pixel with its center at or beyond the coordinate x, clamped to
+   // [0,size]. The clamping happens in floating point, since the conversion of NaN, infinite or
+   // huge values to ptrdiff_t is undefined; NaN maps to 0.
+   static ptrdiff_t pixelBound( double x, size_t size )
+   {
+      double const pixel( std::ceil( x - 0.5 ) );
+      if( !( pixel > 0.0 ) ) return 0;
+      if( pixel >= static_cast<double>( size ) ) return static_cast<ptrdiff_t>( size );
+      return static_cast<ptrdiff_t>( pixel );
+   }
+
+   // Fills the pixels [x0,x1) of row y
+   void fillSpan( size_t y, double x0, double x1 )
+   {
+      ptrdiff_t const begin( pixelBound( x0, width_ ) );
+      ptrdiff_t const end  ( pixelBound( x1, width_ ) );
+      if( begin >= end ) return;
+      std::fill( pixels_.begin() + static_cast<ptrdiff_t>( y*width_ ) + begin
+               , pixels_.begin() + static_cast<ptrdiff_t>( y*width_ ) + end, color_ );
+   }
+
+   // Fills all rows covered by a shape with the given vertical extent. The half width of the
+   // span in a row is computed from the vertical distance between the row and the center.
+   template< typename SpanHalfWidth >
+   void fillRows( double cy, double extent, double cx, SpanHalfWidth halfWidth )
+   {
+      ptrdiff_t const first( pixelBound( cy - extent, height_ ) );
+      ptrdiff_t const last ( pixelBound( cy + extent, height_ ) );
+      for( ptrdiff_t y=first; y<last; ++y ) {
+         double const w( halfWidth( static_cast<double>( y ) + 0.5 - cy ) );
+         fillSpan( static_cast<size_t>( y ), cx - w, cx + w );
+      }
+   }
+
+   void fillCircle( double cx, double cy, double radius )
+   {
+      fillRows( cy, radius, cx, [radius]( double dy ){
+         return std::sqrt( std::max( 0.0, radius*radius - dy*dy ) );
+      } );
+   }
+
+   void fillSquare( double cx, double cy, double halfSide )
+   {
+      fillRows( cy, halfSide, cx, [halfSide]( double ){ return halfSide; } );
+   }
+
+   size_t width_;
+   size_t height_;
+   std::vector<std::uint32_t> palette_;
+   std::vector<std::uint32_t> pixels_;
+   std::uint32_t color_{};
+   size_t styleChanges_{};
+   size_t batches_{};
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+//#include <CommandBuffer.h>
+//#include <MemoryRasterizer.h>
+//#include <RecordingDrawStrategy.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main()
+{
+   using Shapes = std::vector<std::unique_ptr<ShapeConcept>>;
+
+   using CircleModel = ShapeModel<Circle,RecordingDrawStrategy>;
+   using SquareModel = ShapeModel<Square,RecordingDrawStrategy>;
+
+   constexpr StyleIndex red  ( 0U );
+   constexpr StyleIndex green( 1U );
+
+   CommandBuffer commands{};
+
+   Shapes shapes{};
+
+   // Creating some shapes, each one
+   //   equipped with a recording drawing strategy
+   shapes.emplace_back(
+      std::make_unique<CircleModel>(
+         Circle{2.3, Point{ 8.0, 8.0 }}, RecordingDrawStrategy( commands, red ) ) );
+   shapes.emplace_back(
+      std::make_unique<SquareModel>(
+         Square{1.2, Point{ 20.0, 4.0 }}, RecordingDrawStrategy( commands, green ) ) );
+   shapes.emplace_back(
+      std::make_unique<CircleModel>(
+         Circle{4.1, Point{ 24.0, 16.0 }}, RecordingDrawStrategy( commands, red ) ) );
+
+   MemoryRasterizer rasterizer( 32U, 24U, { 0xFF0000FFU, 0xFF00FF00U } );
+
+   // Rendering two frames, reusing the command buffer
+   for( int frame=0; frame<2; ++frame )
+   {
+      commands.clear();
+      rasterizer.clear();
+
+      // Recording the draw commands of all shapes
+      for( auto const& shape : shapes )
+      {
+         shape->draw();
+      }
+
+      // Replaying the commands sorted by state: one style change and one batch for the two
+      // red circles, and one style change and one batch for the green square
+      commands.replay( rasterizer );
+   }
+
+   bool const correct( rasterizer.styleChanges() == 4U && rasterizer.batches() == 4U &&
+                       rasterizer.pixel(  8U,  8U ) == 0xFF0000FFU &&
+                       rasterizer.pixel( 20U,  4U ) == 0xFF00FF00U &&
+                       rasterizer.pixel(  0U,  0U ) == 0U );
+
+   return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
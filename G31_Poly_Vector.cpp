@@ -0,0 +1,378 @@
+/**************************************************************************************************
+*
+* \file G31_Poly_Vector.cpp
+* \brief Guideline 31: Use External Polymorphism for Nonintrusive Runtime Polymorphism
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {
+      /* Checking that the given radius is valid */
+   }
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {
+      /* Checking that the given side length is valid */
+   }
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+class ShapeConcept
+{
+ public:
+   virtual ~ShapeConcept() = default;
+
+   virtual void draw() const = 0;
+
+   // ... Potentially more polymorphic operations
+};
+
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class ShapeModel : public ShapeConcept
+{
+ public:
+   explicit ShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+
+//---- <PolyVector.h> -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A sequence container for objects of different types derived from 'Base'. In contrast to a
+// std::vector of std::unique_ptrs, all objects are stored back-to-back in a single, contiguous
+// byte buffer, each at an offset that respects its alignment. In case the buffer has to grow,
+// all objects are relocated (move constructed and destroyed) into the new buffer. Therefore,
+// emplace_back() invalidates all references and iterators to the elements, exactly like for
+// std::vector. Iterating over the container yields references to 'Base'.
+template< typename Base >
+class poly_vector
+{
+ private:
+   // The type-specific operations required to manage an element
+   struct Ops
+   {
+      size_t size;
+      size_t alignment;
+      Base* (*relocate)( void* destination, Base* source ) noexcept;
+      void (*destroy)( Base* object ) noexcept;
+   };
+
+   template< typename T >
+   static constexpr Ops ops{
+      sizeof(T),
+      alignof(T),
+      []( void* destination, Base* source ) noexcept -> Base* {
+         T* const object( static_cast<T*>( source ) );
+         Base* const result( ::new( destination ) T( std::move(*object) ) );
+         std::destroy_at( object );
+         return result;
+      },
+      []( Base* object ) noexcept {
+         std::destroy_at( static_cast<T*>( object ) );
+      }
+   };
+
+   struct Element
+   {
+      Base* base;
+      Ops const* ops;
+   };
+
+   template< typename Value, typename ElementIterator >
+   class Iterator
+   {
+    public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type        = std::remove_const_t<Value>;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = Value*;
+      using reference         = Value&;
+
+      Iterator() = default;
+      explicit Iterator( ElementIterator it ) : it_( it ) {}
+
+      reference operator*() const { return *it_->base; }
+      pointer operator->() const { return it_->base; }
+      reference operator[]( difference_type n ) const { return *it_[n].base; }
+
+      Iterator& operator++() { ++it_; return *this; }
+      Iterator operator++( int ) { return Iterator( it_++ ); }
+      Iterator& operator--() { --it_; return *this; }
+      Iterator operator--( int ) { return Iterator( it_-- ); }
+      Iterator& operator+=( difference_type n ) { it_ += n; return *this; }
+      Iterator& operator-=( difference_type n ) { it_ -= n; return *this; }
+
+      friend Iterator operator+( Iterator it, difference_type n ) { return it += n; }
+      friend Iterator operator+( difference_type n, Iterator it ) { return it += n; }
+      friend Iterator operator-( Iterator it, difference_type n ) { return it -= n; }
+      friend difference_type operator-( Iterator a, Iterator b ) { return a.it_ - b.it_; }
+
+      friend bool operator==( Iterator a, Iterator b ) { return a.it_ == b.it_; }
+      friend auto operator<=>( Iterator a, Iterator b ) { return a.it_ <=> b.it_; }
+
+    private:
+      ElementIterator it_{};
+   };
+
+ public:
+   using value_type     = Base;
+   using size_type      = size_t;
+   using iterator       = Iterator<Base,typename std::vector<Element>::const_iterator>;
+   using const_iterator = Iterator<Base const,typename std::vector<Element>::const_iterator>;
+
+   poly_vector() = default;
+
+   poly_vector( poly_vector const& ) = delete;
+   poly_vector& operator=( poly_vector const& ) = delete;
+
+   poly_vector( poly_vector&& other ) noexcept
+      : buffer_   ( std::exchange( other.buffer_, nullptr ) )
+      , capacity_ ( std::exchange( other.capacity_, 0U ) )
+      , used_     ( std::exchange( other.used_, 0U ) )
+      , alignment_( std::exchange( other.alignment_, alignof(std::max_align_t) ) )
+      , elements_ ( std::move( other.elements_ ) )
+   {
+      other.elements_.clear();
+   }
+
+   poly_vector& operator=( poly_vector&& other ) noexcept
+   {
+      poly_vector tmp( std::move(other) );
+      swap( tmp );
+      return *this;
+   }
+
+   ~poly_vector()
+   {
+      clear();
+      deallocate( buffer_, alignment_ );
+   }
+
+   // Constructs a new object of type T at the end of the container. In order to guarantee a
+   // consistent state in case the buffer has to grow, T is required to be nothrow movable.
+   template< typename T, typename... Args >
+      requires std::derived_from<T,Base>
+   T& emplace_back( Args&&... args )
+   {
+      static_assert( std::is_nothrow_move_constructible_v<T>
+                   , "poly_vector requires nothrow move constructible element types" );
+
+      if( elements_.size() == elements_.capacity() ) {
+         elements_.reserve( std::max( 2U*elements_.capacity(), size_t{16U} ) );
+      }
+
+      size_t const offset( roundUp( used_, alignof(T) ) );
+      if( offset + sizeof(T) > capacity_ || alignof(T) > alignment_ ) {
+         grow( offset + sizeof(T), std::max( alignment_, alignof(T) ) );
+      }
+
+      T* const object( ::new( buffer_ + offset ) T( std::forward<Args>(args)... ) );
+      elements_.push_back( Element{ object, &ops<T> } );
+      used_ = offset + sizeof(T);
+      return *object;
+   }
+
+   // Reserves memory for at least the given number of elements and bytes of object storage
+   void reserve( size_t elements, size_t bytes )
+   {
+      elements_.reserve( elements );
+      if( bytes > capacity_ ) {
+         grow( bytes, alignment_ );
+      }
+   }
+
+   void clear() noexcept
+   {
+      for( Element const& element : elements_ ) {
+         element.ops->destroy( element.base );
+      }
+      elements_.clear();
+      used_ = 0U;
+   }
+
+   void swap( poly_vector& other ) noexcept
+   {
+      std::swap( buffer_, other.buffer_ );
+      std::swap( capacity_, other.capacity_ );
+      std::swap( used_, other.used_ );
+      std::swap( alignment_, other.alignment_ );
+      elements_.swap( other.elements_ );
+   }
+
+   size_t size () const { return elements_.size(); }
+   bool   empty() const { return elements_.empty(); }
+   size_t bytes() const { return used_; }      // Number of bytes occupied by the objects
+   size_t capacity() const { return capacity_; }  // Number of bytes of the buffer
+
+   Base&       operator[]( size_t index )       { return *elements_[index].base; }
+   Base const& operator[]( size_t index ) const { return *elements_[index].base; }
+
+   iterator       begin()       { return iterator( elements_.cbegin() ); }
+   const_iterator begin() const { return const_iterator( elements_.cbegin() ); }
+   iterator       end  ()       { return iterator( elements_.cend() ); }
+   const_iterator end  () const { return const_iterator( elements_.cend() ); }
+
+ private:
+   static size_t roundUp( size_t size, size_t alignment )
+   {
+      return ( size + alignment - 1U ) / alignment * alignment;
+   }
+
+   static void deallocate( std::byte* buffer, size_t alignment ) noexcept
+   {
+      if( buffer ) {
+         ::operator delete( buffer, std::align_val_t{ alignment } );
+      }
+   }
+
+   // Allocates a new buffer of at least the given size and relocates all objects. Since the
+   // new buffer is at least as strictly aligned as the old one, all objects keep their offsets.
+   void grow( size_t required, size_t alignment )
+   {
+      size_t const capacity( std::max( { required, 2U*capacity_, size_t{256U} } ) );
+      auto* const buffer( static_cast<std::byte*>(
+         ::operator new( capacity, std::align_val_t{ alignment } ) ) );
+
+      size_t offset{};
+      for( Element& element : elements_ ) {
+         offset = roundUp( offset, element.ops->alignment );
+         element.base = element.ops->relocate( buffer + offset, element.base );
+         offset += element.ops->size;
+      }
+
+      deallocate( buffer_, alignment_ );
+      buffer_    = buffer;
+      capacity_  = capacity;
+      alignment_ = alignment;
+   }
+
+   std::byte* buffer_{};
+   size_t capacity_{};
+   size_t used_{};
+   size_t alignment_{ alignof(std::max_align_t) };
+   std::vector<Element> elements_{};
+};
+
+
+//---- <OpenGLDrawStrategy.h> ---------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include /* OpenGL graphics library headers */
+
+class OpenGLDrawStrategy
+{
+ public:
+   explicit OpenGLDrawStrategy( /* Drawing related arguments */ )
+   {}
+
+   void operator()( Circle const& circle ) const
+   {
+      // ... Implementing the logic for drawing a circle by means of OpenGL
+   }
+   void operator()( Square const& square ) const
+   {
+      // ... Implementing the logic for drawing a square by means of OpenGL
+   }
+
+ private:
+   /* Drawing related data members, e.g., colors, textures, ... */
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+//#include <OpenGLDrawStrategy.h>
+//#include <PolyVector.h>
+#include <cstdlib>
+
+int main()
+{
+   using Shapes = poly_vector<ShapeConcept>;
+
+   using CircleModel = ShapeModel<Circle,OpenGLDrawStrategy>;
+   using SquareModel = ShapeModel<Square,OpenGLDrawStrategy>;
+
+   Shapes shapes{};
+
+   // Creating some shapes, each one
+   //   equipped with an OpenGL drawing strategy
+   shapes.emplace_back<CircleModel>(
+      Circle{2.3}, OpenGLDrawStrategy(/*...red...*/) );
+   shapes.emplace_back<SquareModel>(
+      Square{1.2}, OpenGLDrawStrategy(/*...green...*/) );
+   shapes.emplace_back<CircleModel>(
+      Circle{4.1}, OpenGLDrawStrategy(/*...blue...*/) );
+
+   // Drawing all shapes
+   for( auto const& shape : shapes )
+   {
+      shape.draw();
+   }
+
+   return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,281 @@
+/**************************************************************************************************
+*
+* \file G32_Allocator_Aware_Shape.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <CountingResource.h> -----------------------------------------------------------------------
+
+#include <cstddef>
+#include <memory_resource>
+
+// A memory resource, which forwards all requests to its upstream resource and counts the number
+// of allocations and the number of allocated bytes
+class CountingResource : public std::pmr::memory_resource
+{
+ public:
+   explicit CountingResource( std::pmr::memory_resource* upstream )
+      : upstream_{ upstream }
+   {}
+
+   size_t allocations() const { return allocations_; }
+   size_t bytes() const { return bytes_; }
+
+ private:
+   void* do_allocate( size_t bytes, size_t alignment ) override
+   {
+      ++allocations_;
+      bytes_ += bytes;
+      return upstream_->allocate( bytes, alignment );
+   }
+
+   void do_deallocate( void* ptr, size_t bytes, size_t alignment ) override
+   {
+      upstream_->deallocate( ptr, bytes, alignment );
+   }
+
+   bool do_is_equal( std::pmr::memory_resource const& other ) const noexcept override
+   {
+      return this == &other;
+   }
+
+   std::pmr::memory_resource* upstream_{};
+   size_t allocations_{};
+   size_t bytes_{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+
+   // The Prototype design pattern: the clone is allocated by means of the given allocator
+   virtual ShapeConcept* clone( std::pmr::polymorphic_allocator<> alloc ) const = 0;
+
+   // Destroys the model and returns its memory to the given allocator
+   virtual void destroy( std::pmr::polymorphic_allocator<> alloc ) noexcept = 0;
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   ShapeConcept* clone( std::pmr::polymorphic_allocator<> alloc ) const override
+   {
+      return alloc.new_object<OwningShapeModel>( *this );
+   }
+
+   void destroy( std::pmr::polymorphic_allocator<> alloc ) noexcept override
+   {
+      alloc.delete_object( this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+// Returns the model to the memory resource it has been allocated from
+class ShapeDeleter
+{
+ public:
+   explicit ShapeDeleter( std::pmr::memory_resource* resource )
+      : resource_( resource )
+   {}
+
+   void operator()( ShapeConcept* model ) const noexcept { model->destroy( resource_ ); }
+
+   std::pmr::memory_resource* resource() const { return resource_; }
+
+ private:
+   std::pmr::memory_resource* resource_;
+};
+
+} // namespace detail
+
+
+// An allocator-aware Shape: the model is allocated from the given memory resource (by default
+// the default resource, i.e. usually the heap). Following the conventions of the std::pmr
+// containers, a copy uses the default resource unless a resource is given explicitly, and the
+// resource of a shape never changes by means of assignment. Since the Shape provides the nested
+// 'allocator_type', a std::pmr::vector passes its memory resource on to its shapes.
+class Shape
+{
+ public:
+   using allocator_type = std::pmr::polymorphic_allocator<>;
+
+   template< typename ShapeT
+           , typename DrawStrategy >
+      requires ( !std::is_same_v<ShapeT,Shape> )
+   Shape( ShapeT shape, DrawStrategy drawer, allocator_type alloc = {} )
+      : pimpl_( nullptr, detail::ShapeDeleter{ alloc.resource() } )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_.reset( alloc.new_object<Model>( std::move(shape), std::move(drawer) ) );
+   }
+
+   Shape( Shape const& other, allocator_type alloc = {} )
+      : pimpl_( other.pimpl_->clone( alloc ), detail::ShapeDeleter{ alloc.resource() } )
+   {}
+
+   Shape( Shape&& other ) noexcept = default;
+
+   // Takes over the model of the other shape if it uses the same memory resource, and else
+   // clones the model
+   Shape( Shape&& other, allocator_type alloc )
+      : pimpl_( nullptr, detail::ShapeDeleter{ alloc.resource() } )
+   {
+      if( other.get_allocator() == alloc ) {
+         pimpl_.reset( other.pimpl_.release() );
+      }
+      else {
+         pimpl_.reset( other.pimpl_->clone( alloc ) );
+      }
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom, the copy is allocated from the resource of this shape
+      Shape copy( other, get_allocator() );
+      std::swap( pimpl_, copy.pimpl_ );
+      return *this;
+   }
+
+   Shape& operator=( Shape&& other )
+   {
+      Shape tmp( std::move(other), get_allocator() );
+      std::swap( pimpl_, tmp.pimpl_ );
+      return *this;
+   }
+
+   ~Shape() = default;
+
+   allocator_type get_allocator() const { return pimpl_.get_deleter().resource(); }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   std::unique_ptr<detail::ShapeConcept,detail::ShapeDeleter> pimpl_;  // The Bridge design pattern
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <CountingResource.h>
+//#include <Square.h>
+//#include <Shape.h>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+int main()
+{
+   // Create a drawing strategy in form of a lambda
+   auto drawer = []( auto const& shape ){ /*...*/ };
+
+   // All allocations of a frame are served by an arena, which requests its memory from the heap
+   CountingResource heap{ std::pmr::new_delete_resource() };
+   size_t shapeAllocations{};
+
+   // Shapes, which outlive a frame, are allocated from the default resource
+   std::vector<Shape> persistent{};
+
+   for( int frame=0; frame<3; ++frame )
+   {
+      std::pmr::monotonic_buffer_resource arena{ &heap };
+      CountingResource frameResource{ &arena };
+
+      // The vector passes the memory resource on to its shapes
+      std::pmr::vector<Shape> scene{ &frameResource };
+      for( int i=0; i<100; ++i ) {
+         scene.emplace_back( Circle{ 1.0+i }, drawer );
+         scene.emplace_back( Square{ 2.0+i }, drawer );
+      }
+
+      for( auto const& shape : scene ) {
+         draw( shape );
+      }
+
+      // A copy, which outlives the frame, has to be allocated from a different resource
+      persistent.emplace_back( scene.front(), std::pmr::get_default_resource() );
+
+      shapeAllocations += frameResource.allocations();
+   }  // The arena releases the memory of the complete scene in one shot
+
+   for( auto const& shape : persistent ) {
+      draw( shape );
+   }
+
+   std::cout << "Allocations from the arena: " << shapeAllocations << '\n'
+             << "Allocations from the heap:  " << heap.allocations() << '\n';
+
+   return ( heap.allocations() < shapeAllocations ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,360 @@
+/**************************************************************************************************
+*
+* \file G32_Allocator_Aware_Shape_Performance.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to rebuild and
+* draw a scene of allocator-aware shapes per frame, once with the models allocated from the
+* default resource, once from a per-frame monotonic arena, once from a monotonic arena on a
+* reused buffer, and once from a pool resource, which persists over all frames. The 'allocs/frame'
+* counter reports the allocations requested from the memory resource of the scene, the
+* 'upstream allocs/frame' counter reports the allocations this resource requests from the heap.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_DEFAULT_RESOURCE 1  // All models are allocated from the heap
+#define BENCHMARK_FRAME_ARENA      1  // A new monotonic arena per frame
+#define BENCHMARK_REUSED_ARENA     1  // A monotonic arena on a buffer that is reused every frame
+#define BENCHMARK_POOL_RESOURCE    1  // A pool resource, which persists over all frames
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// A memory resource, which forwards all requests to its upstream resource and counts the number
+// of allocations and the number of allocated bytes
+class CountingResource : public std::pmr::memory_resource
+{
+ public:
+   explicit CountingResource( std::pmr::memory_resource* upstream )
+      : upstream_{ upstream }
+   {}
+
+   size_t allocations() const { return allocations_; }
+   size_t bytes() const { return bytes_; }
+
+ private:
+   void* do_allocate( size_t bytes, size_t alignment ) override
+   {
+      ++allocations_;
+      bytes_ += bytes;
+      return upstream_->allocate( bytes, alignment );
+   }
+
+   void do_deallocate( void* ptr, size_t bytes, size_t alignment ) override
+   {
+      upstream_->deallocate( ptr, bytes, alignment );
+   }
+
+   bool do_is_equal( std::pmr::memory_resource const& other ) const noexcept override
+   {
+      return this == &other;
+   }
+
+   std::pmr::memory_resource* upstream_{};
+   size_t allocations_{};
+   size_t bytes_{};
+};
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+auto const circleDrawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+auto const squareDrawer = []( Square const& s ){ benchmark::DoNotOptimize( s.side() ); };
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+
+   // The Prototype design pattern: the clone is allocated by means of the given allocator
+   virtual ShapeConcept* clone( std::pmr::polymorphic_allocator<> alloc ) const = 0;
+
+   // Destroys the model and returns its memory to the given allocator
+   virtual void destroy( std::pmr::polymorphic_allocator<> alloc ) noexcept = 0;
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   ShapeConcept* clone( std::pmr::polymorphic_allocator<> alloc ) const override
+   {
+      return alloc.new_object<OwningShapeModel>( *this );
+   }
+
+   void destroy( std::pmr::polymorphic_allocator<> alloc ) noexcept override
+   {
+      alloc.delete_object( this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+// Returns the model to the memory resource it has been allocated from
+class ShapeDeleter
+{
+ public:
+   explicit ShapeDeleter( std::pmr::memory_resource* resource )
+      : resource_( resource )
+   {}
+
+   void operator()( ShapeConcept* model ) const noexcept { model->destroy( resource_ ); }
+
+   std::pmr::memory_resource* resource() const { return resource_; }
+
+ private:
+   std::pmr::memory_resource* resource_;
+};
+
+} // namespace detail
+
+
+// An allocator-aware Shape: the model is allocated from the given memory resource (by default
+// the default resource, i.e. usually the heap). Following the conventions of the std::pmr
+// containers, a copy uses the default resource unless a resource is given explicitly, and the
+// resource of a shape never changes by means of assignment. Since the Shape provides the nested
+// 'allocator_type', a std::pmr::vector passes its memory resource on to its shapes.
+class Shape
+{
+ public:
+   using allocator_type = std::pmr::polymorphic_allocator<>;
+
+   template< typename ShapeT
+           , typename DrawStrategy >
+      requires ( !std::is_same_v<ShapeT,Shape> )
+   Shape( ShapeT shape, DrawStrategy drawer, allocator_type alloc = {} )
+      : pimpl_( nullptr, detail::ShapeDeleter{ alloc.resource() } )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_.reset( alloc.new_object<Model>( std::move(shape), std::move(drawer) ) );
+   }
+
+   Shape( Shape const& other, allocator_type alloc = {} )
+      : pimpl_( other.pimpl_->clone( alloc ), detail::ShapeDeleter{ alloc.resource() } )
+   {}
+
+   Shape( Shape&& other ) noexcept = default;
+
+   // Takes over the model of the other shape if it uses the same memory resource, and else
+   // clones the model
+   Shape( Shape&& other, allocator_type alloc )
+      : pimpl_( nullptr, detail::ShapeDeleter{ alloc.resource() } )
+   {
+      if( other.get_allocator() == alloc ) {
+         pimpl_.reset( other.pimpl_.release() );
+      }
+      else {
+         pimpl_.reset( other.pimpl_->clone( alloc ) );
+      }
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom, the copy is allocated from the resource of this shape
+      Shape copy( other, get_allocator() );
+      std::swap( pimpl_, copy.pimpl_ );
+      return *this;
+   }
+
+   Shape& operator=( Shape&& other )
+   {
+      Shape tmp( std::move(other), get_allocator() );
+      std::swap( pimpl_, tmp.pimpl_ );
+      return *this;
+   }
+
+   ~Shape() = default;
+
+   allocator_type get_allocator() const { return pimpl_.get_deleter().resource(); }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   std::unique_ptr<detail::ShapeConcept,detail::ShapeDeleter> pimpl_;  // The Bridge design pattern
+};
+
+
+//---- Benchmarks ---------------------------------------------------------------------------------
+
+struct SceneEntry
+{
+   bool circle;
+   double size;
+};
+
+std::vector<SceneEntry> createEntries( size_t size )
+{
+   std::vector<SceneEntry> entries( size );
+   for( auto& entry : entries ) {
+      entry = SceneEntry{ coin( rng ), dist( rng ) };
+   }
+   return entries;
+}
+
+// Rebuilds the scene from the given resource, draws all shapes and destroys the scene
+void rebuildScene( std::vector<SceneEntry> const& entries, std::pmr::memory_resource* resource )
+{
+   std::pmr::vector<Shape> scene{ resource };
+   scene.reserve( entries.size() );
+   for( auto const& e : entries ) {
+      if( e.circle )
+         scene.emplace_back( Circle{ e.size }, circleDrawer );
+      else
+         scene.emplace_back( Square{ e.size }, squareDrawer );
+   }
+
+   for( auto const& shape : scene ) {
+      draw( shape );
+   }
+}
+
+// Runs the frames of a benchmark. The given setup function provides the memory resource of a
+// frame, which requests its memory from the 'upstream' resource, and passes it to the given
+// callback.
+template< typename FrameSetup >
+void frames( benchmark::State& state, CountingResource& upstream, FrameSetup setup )
+{
+   auto const entries( createEntries( state.range(0) ) );
+
+   size_t frameAllocations{};
+   size_t upstreamAllocations{};
+
+   auto frame = [&]( std::pmr::memory_resource* resource ) {
+      CountingResource counting{ resource };
+      rebuildScene( entries, &counting );
+      frameAllocations = counting.allocations();
+   };
+
+   for( auto _ : state )
+   {
+      size_t const before( upstream.allocations() );
+      setup( frame );
+      upstreamAllocations = upstream.allocations() - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/frame"] = static_cast<double>( frameAllocations );
+   state.counters["upstream allocs/frame"] = static_cast<double>( upstreamAllocations );
+}
+
+static void defaultResource(benchmark::State& state)
+{
+   CountingResource heap{ std::pmr::new_delete_resource() };
+
+   frames( state, heap, [&heap]( auto frame ) {
+      frame( &heap );
+   } );
+}
+#if BENCHMARK_DEFAULT_RESOURCE
+BENCHMARK(defaultResource)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void frameArena(benchmark::State& state)
+{
+   CountingResource heap{ std::pmr::new_delete_resource() };
+
+   frames( state, heap, [&heap]( auto frame ) {
+      std::pmr::monotonic_buffer_resource arena{ &heap };
+      frame( &arena );
+   } );  // The arena releases the memory of the complete scene in one shot
+}
+#if BENCHMARK_FRAME_ARENA
+BENCHMARK(frameArena)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void reusedArena(benchmark::State& state)
+{
+   CountingResource heap{ std::pmr::new_delete_resource() };
+
+   // The buffer is large enough for the scene and the models (plus some alignment padding)
+   std::vector<std::byte> buffer( 2U * state.range(0) * ( sizeof(Shape) + 32U ) );
+
+   frames( state, heap, [&heap,&buffer]( auto frame ) {
+      std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), &heap };
+      frame( &arena );
+   } );
+}
+#if BENCHMARK_REUSED_ARENA
+BENCHMARK(reusedArena)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void poolResource(benchmark::State& state)
+{
+   CountingResource heap{ std::pmr::new_delete_resource() };
+   std::pmr::unsynchronized_pool_resource pool{ &heap };
+
+   frames( state, heap, [&pool]( auto frame ) {
+      frame( &pool );
+   } );
+}
+#if BENCHMARK_POOL_RESOURCE
+BENCHMARK(poolResource)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,228 @@
+/**************************************************************************************************
+*
+* \file G32_Copy_On_Write.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+   void scale( double factor ) { radius_ *= factor; }
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+   void scale( double factor ) { side_ *= factor; }
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   ShapeConcept() = default;
+
+   // A copy of a model is not shared (yet)
+   ShapeConcept( ShapeConcept const& ) {}
+   ShapeConcept& operator=( ShapeConcept const& ) = delete;
+
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+   virtual void scale( double factor ) = 0;
+   virtual std::unique_ptr<ShapeConcept> clone() const = 0;  // The Prototype design pattern
+
+   void acquire() const { refCount_.fetch_add( 1U, std::memory_order_relaxed ); }
+
+   // Returns true if the last reference has been released
+   bool release() const { return refCount_.fetch_sub( 1U, std::memory_order_acq_rel ) == 1U; }
+
+   bool isShared() const { return refCount_.load( std::memory_order_acquire ) > 1U; }
+
+ private:
+   mutable std::atomic<size_t> refCount_{ 1U };
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   void scale( double factor ) override { shape_.scale( factor ); }
+
+   std::unique_ptr<ShapeConcept> clone() const override  // The Prototype design pattern
+   {
+      return std::make_unique<OwningShapeModel>( *this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+} // namespace detail
+
+
+// A copy-on-write Shape: copies share a single, reference-counted model, which is cloned only
+// when a shared shape is modified for the first time. Since the reference count is atomic and
+// a shared model is never modified, copies of a shape can be used concurrently from several
+// threads (e.g. snapshots of a scene). A single Shape object, however, is not thread-safe.
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_ = std::make_unique<Model>( std::move(shape)
+                                      , std::move(drawer) ).release();
+   }
+
+   Shape( Shape const& other )
+      : pimpl_( other.pimpl_ )
+   {
+      pimpl_->acquire();
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      std::swap( pimpl_, copy.pimpl_ );
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : pimpl_( std::exchange( other.pimpl_, nullptr ) )
+   {}
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      Shape tmp( std::move(other) );
+      std::swap( pimpl_, tmp.pimpl_ );
+      return *this;
+   }
+
+   ~Shape()
+   {
+      if( pimpl_ && pimpl_->release() ) delete pimpl_;
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   friend void scale( Shape& shape, double factor )
+   {
+      shape.mutablePimpl()->scale( factor );
+   }
+
+   friend bool sharesModel( Shape const& lhs, Shape const& rhs )
+   {
+      return lhs.pimpl_ == rhs.pimpl_;
+   }
+
+   // Returns the model for modification, which requires a clone of a shared model
+   detail::ShapeConcept* mutablePimpl()
+   {
+      if( pimpl_->isShared() ) {
+         detail::ShapeConcept* const copy( pimpl_->clone().release() );
+         if( pimpl_->release() ) delete pimpl_;  // The other owners might be gone in between
+         pimpl_ = copy;
+      }
+      return pimpl_;
+   }
+
+   detail::ShapeConcept* pimpl_{ nullptr };  // The Bridge design pattern
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+#include <cstdlib>
+#include <vector>
+
+int main()
+{
+   double drawnRadius{};
+
+   // Create a drawing strategy in form of a lambda
+   auto drawer = [&drawnRadius]( Circle const& c ){ drawnRadius = c.radius(); };
+
+   std::vector<Shape> scene{};
+   scene.emplace_back( Circle{ 3.14 }, drawer );
+   scene.emplace_back( Circle{ 1.0 }, drawer );
+
+   // Taking a snapshot of the scene does not clone any model
+   std::vector<Shape> const snapshot( scene );
+
+   // Modifying a shape of the scene clones its model; the snapshot is not affected
+   scale( scene[0], 2.0 );
+
+   draw( snapshot[0] );
+   double const snapshotRadius( drawnRadius );
+   draw( scene[0] );
+   double const sceneRadius( drawnRadius );
+
+   bool const valid = snapshotRadius == 3.14 && sceneRadius == 6.28 &&
+                      !sharesModel( scene[0], snapshot[0] ) &&
+                      sharesModel( scene[1], snapshot[1] );
+
+   return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,388 @@
+/**************************************************************************************************
+*
+* \file G32_Copy_On_Write_Performance.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to take a snapshot
+* of a scene (i.e. to copy a std::vector of shapes) and to modify a fraction of the shapes in the
+* snapshot, once for the Shape that deep-clones its model on every copy and once for the
+* copy-on-write Shape. The 'allocs/shape' counter reports the dynamic memory allocations per
+* shape and snapshot.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_SNAPSHOT            1  // Copying the scene
+#define BENCHMARK_SNAPSHOT_AND_MODIFY 1  // Copying the scene and modifying every 10th shape
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the number of allocations per shape. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocations{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   ++allocations;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+   void scale( double factor ) { radius_ *= factor; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+   void scale( double factor ) { side_ *= factor; }
+
+ private:
+   double side_;
+};
+
+auto const circleDrawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+auto const squareDrawer = []( Square const& s ){ benchmark::DoNotOptimize( s.side() ); };
+
+
+//---- Deep copy Shape ----------------------------------------------------------------------------
+
+namespace deep_copy {
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+   virtual void scale( double factor ) = 0;
+   virtual std::unique_ptr<ShapeConcept> clone() const = 0;  // The Prototype design pattern
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   void scale( double factor ) override { shape_.scale( factor ); }
+
+   std::unique_ptr<ShapeConcept> clone() const override  // The Prototype design pattern
+   {
+      return std::make_unique<OwningShapeModel>( *this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+} // namespace detail
+
+
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_ = std::make_unique<Model>( std::move(shape)
+                                      , std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : pimpl_( other.pimpl_->clone() )
+   {}
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      pimpl_.swap( copy.pimpl_ );
+      return *this;
+   }
+
+   ~Shape() = default;
+   Shape( Shape&& ) = default;
+   Shape& operator=( Shape&& ) = default;
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   friend void scale( Shape& shape, double factor )
+   {
+      shape.pimpl_->scale( factor );
+   }
+
+   std::unique_ptr<detail::ShapeConcept> pimpl_;  // The Bridge design pattern
+};
+
+} // namespace deep_copy
+
+
+//---- Copy-on-write Shape ------------------------------------------------------------------------
+
+namespace copy_on_write {
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   ShapeConcept() = default;
+
+   // A copy of a model is not shared (yet)
+   ShapeConcept( ShapeConcept const& ) {}
+   ShapeConcept& operator=( ShapeConcept const& ) = delete;
+
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+   virtual void scale( double factor ) = 0;
+   virtual std::unique_ptr<ShapeConcept> clone() const = 0;  // The Prototype design pattern
+
+   void acquire() const { refCount_.fetch_add( 1U, std::memory_order_relaxed ); }
+
+   // Returns true if the last reference has been released
+   bool release() const { return refCount_.fetch_sub( 1U, std::memory_order_acq_rel ) == 1U; }
+
+   bool isShared() const { return refCount_.load( std::memory_order_acquire ) > 1U; }
+
+ private:
+   mutable std::atomic<size_t> refCount_{ 1U };
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   void scale( double factor ) override { shape_.scale( factor ); }
+
+   std::unique_ptr<ShapeConcept> clone() const override  // The Prototype design pattern
+   {
+      return std::make_unique<OwningShapeModel>( *this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+} // namespace detail
+
+
+// A copy-on-write Shape: copies share a single, reference-counted model, which is cloned only
+// when a shared shape is modified for the first time. Since the reference count is atomic and
+// a shared model is never modified, copies of a shape can be used concurrently from several
+// threads (e.g. snapshots of a scene). A single Shape object, however, is not thread-safe.
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_ = std::make_unique<Model>( std::move(shape)
+                                      , std::move(drawer) ).release();
+   }
+
+   Shape( Shape const& other )
+      : pimpl_( other.pimpl_ )
+   {
+      pimpl_->acquire();
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      std::swap( pimpl_, copy.pimpl_ );
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : pimpl_( std::exchange( other.pimpl_, nullptr ) )
+   {}
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      Shape tmp( std::move(other) );
+      std::swap( pimpl_, tmp.pimpl_ );
+      return *this;
+   }
+
+   ~Shape()
+   {
+      if( pimpl_ && pimpl_->release() ) delete pimpl_;
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   friend void scale( Shape& shape, double factor )
+   {
+      shape.mutablePimpl()->scale( factor );
+   }
+
+   friend bool sharesModel( Shape const& lhs, Shape const& rhs )
+   {
+      return lhs.pimpl_ == rhs.pimpl_;
+   }
+
+   // Returns the model for modification, which requires a clone of a shared model
+   detail::ShapeConcept* mutablePimpl()
+   {
+      if( pimpl_->isShared() ) {
+         detail::ShapeConcept* const copy( pimpl_->clone().release() );
+         if( pimpl_->release() ) delete pimpl_;  // The other owners might be gone in between
+         pimpl_ = copy;
+      }
+      return pimpl_;
+   }
+
+   detail::ShapeConcept* pimpl_{ nullptr };  // The Bridge design pattern
+};
+
+} // namespace copy_on_write
+
+
+//---- Benchmarks ---------------------------------------------------------------------------------
+
+template< typename Shape >
+std::vector<Shape> createScene( size_t size )
+{
+   std::vector<Shape> scene{};
+   scene.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      if( coin( rng ) )
+         scene.emplace_back( Circle{ dist( rng ) }, circleDrawer );
+      else
+         scene.emplace_back( Square{ dist( rng ) }, squareDrawer );
+   }
+   return scene;
+}
+
+// Takes a snapshot of the scene and modifies every 'stride'-th shape of the snapshot (if any)
+template< typename Shape >
+void snapshotBenchmark( benchmark::State& state, size_t stride )
+{
+   auto const scene( createScene<Shape>( state.range(0) ) );
+   size_t snapshotAllocations{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocations );
+
+      std::vector<Shape> snapshot( scene );
+      for( size_t i=0U; stride>0U && i<snapshot.size(); i+=stride ) {
+         scale( snapshot[i], 2.0 );
+      }
+      benchmark::DoNotOptimize( snapshot.data() );
+
+      snapshotAllocations = allocations - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/shape"] = static_cast<double>( snapshotAllocations ) / scene.size();
+}
+
+template< typename Shape >
+static void snapshot(benchmark::State& state)
+{
+   snapshotBenchmark<Shape>( state, 0U );
+}
+#if BENCHMARK_SNAPSHOT
+BENCHMARK_TEMPLATE(snapshot,deep_copy::Shape)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(snapshot,copy_on_write::Shape)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+template< typename Shape >
+static void snapshotAndModify(benchmark::State& state)
+{
+   snapshotBenchmark<Shape>( state, 10U );
+}
+#if BENCHMARK_SNAPSHOT_AND_MODIFY
+BENCHMARK_TEMPLATE(snapshotAndModify,deep_copy::Shape)
+   ->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(snapshotAndModify,copy_on_write::Shape)
+   ->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
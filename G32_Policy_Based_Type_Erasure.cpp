@@ -0,0 +1,1243 @@
+/**************************************************************************************************
+*
+* \file G32_Policy_Based_Type_Erasure.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Erased.h> ---------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace erasure {
+
+// An interface is a list of operations. Every operation is a class with a nested 'signature'
+// (a const qualified function type for operations that do not modify the object) and a static
+// function template 'invoke()', which performs the operation on an object of concrete type.
+template< typename... Ops >
+struct interface {};
+
+namespace detail {
+
+template< typename Op, typename... Ops >
+constexpr size_t indexOf()
+{
+   constexpr std::array<bool,sizeof...(Ops)> matches{ std::is_same_v<Op,Ops>... };
+   for( size_t i=0U; i<matches.size(); ++i ) {
+      if( matches[i] ) return i;
+   }
+   return matches.size();
+}
+
+inline void* allocate( size_t size, size_t alignment )
+{
+   if( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) {
+      return ::operator new( size );
+   }
+   return ::operator new( size, std::align_val_t{ alignment } );
+}
+
+inline void deallocate( void* memory, size_t size, size_t alignment ) noexcept
+{
+   if( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) {
+      ::operator delete( memory, size );
+   }
+   else {
+      ::operator delete( memory, size, std::align_val_t{ alignment } );
+   }
+}
+
+// The building blocks for all dispatch policies, generated from the signature of an operation:
+// the function pointer type and the according thunk for a function pointer based dispatch, and
+// the pure virtual function and its override for a virtual dispatch.
+template< typename Op, typename Signature = typename Op::signature >
+struct OpTraits;
+
+template< typename Op, typename R, typename... Args >
+struct OpTraits<Op,R(Args...) const>
+{
+   static constexpr bool modifying = false;
+
+   using Pointer = R(*)( void const*, Args... );
+
+   template< typename T >
+   static R thunk( void const* object, Args... args )
+   {
+      return Op::invoke( *std::launder( static_cast<T const*>( object ) )
+                       , std::forward<Args>(args)... );
+   }
+
+   template< typename Base >
+   struct Concept : public Base
+   {
+      using Base::invoke;
+      virtual R invoke( Op, Args... ) const = 0;
+   };
+
+   template< typename Base >
+   struct Model : public Base
+   {
+      using Base::Base;
+      using Base::invoke;
+      R invoke( Op, Args... args ) const override
+      {
+         return Op::invoke( this->value_, std::forward<Args>(args)... );
+      }
+   };
+};
+
+template< typename Op, typename R, typename... Args >
+struct OpTraits<Op,R(Args...)>
+{
+   static constexpr bool modifying = true;
+
+   using Pointer = R(*)( void*, Args... );
+
+   template< typename T >
+   static R thunk( void* object, Args... args )
+   {
+      return Op::invoke( *std::launder( static_cast<T*>( object ) ), std::forward<Args>(args)... );
+   }
+
+   template< typename Base >
+   struct Concept : public Base
+   {
+      using Base::invoke;
+      virtual R invoke( Op, Args... ) = 0;
+   };
+
+   template< typename Base >
+   struct Model : public Base
+   {
+      using Base::Base;
+      using Base::invoke;
+      R invoke( Op, Args... args ) override
+      {
+         return Op::invoke( this->value_, std::forward<Args>(args)... );
+      }
+   };
+};
+
+// The operations of a virtual dispatch are stacked in a single inheritance chain, which results
+// in a single virtual pointer per object, independent of the number of operations.
+struct ConceptRoot
+{
+   virtual ~ConceptRoot() = default;
+   virtual size_t size() const = 0;
+   virtual size_t alignment() const = 0;
+   virtual void copy( void* memory ) const = 0;
+   virtual void move( void* memory ) noexcept = 0;
+
+   void invoke() const = delete;  // Anchor for the using declarations of the operations
+};
+
+template< typename Base, typename... Ops >
+struct ConceptChain
+{
+   using type = Base;
+};
+
+template< typename Base, typename Op, typename... Ops >
+struct ConceptChain<Base,Op,Ops...>
+   : public ConceptChain<typename OpTraits<Op>::template Concept<Base>,Ops...>
+{};
+
+template< typename T, typename Base >
+struct ValueHolder : public Base
+{
+   explicit ValueHolder( T value ) : value_( std::move(value) ) {}
+
+   T value_;
+};
+
+template< typename Base, typename... Ops >
+struct ModelChain
+{
+   using type = Base;
+};
+
+template< typename Base, typename Op, typename... Ops >
+struct ModelChain<Base,Op,Ops...>
+   : public ModelChain<typename OpTraits<Op>::template Model<Base>,Ops...>
+{};
+
+// The lifetime management of a concrete type for the function pointer based dispatch policies
+struct Lifetime
+{
+   size_t size;
+   size_t alignment;
+   void (*copy)( void const* src, void* dst );
+   void (*move)( void* src, void* dst ) noexcept;
+   void (*destroy)( void* object ) noexcept;
+};
+
+template< typename T >
+constexpr Lifetime lifetime{
+     sizeof(T)
+   , alignof(T)
+   , []( void const* src, void* dst ) {
+        std::construct_at( static_cast<T*>( dst ), *std::launder( static_cast<T const*>( src ) ) );
+     }
+   , []( void* src, void* dst ) noexcept {
+        T* const object( std::launder( static_cast<T*>( src ) ) );
+        std::construct_at( static_cast<T*>( dst ), std::move(*object) );
+     }
+   , []( void* object ) noexcept {
+        std::destroy_at( std::launder( static_cast<T*>( object ) ) );
+     } };
+
+template< typename... Ops >
+struct VTable
+{
+   std::tuple<typename OpTraits<Ops>::Pointer...> operations;
+   Lifetime const* lifetime;
+};
+
+template< typename T, typename... Ops >
+constexpr VTable<Ops...> vtable{
+     { &OpTraits<Ops>::template thunk<T>... }
+   , &lifetime<T> };
+
+// A function pointer based dispatch, which either stores the complete virtual function table in
+// every object (Shared=false) or only a pointer to a single, static table (Shared=true).
+template< bool Shared, typename... Ops >
+class VTableDispatcher
+{
+ public:
+   template< typename T >
+   using stored_type = T;
+
+   template< typename T >
+   explicit VTableDispatcher( std::type_identity<T> )
+      : table_( initialTable<T>() )
+   {}
+
+   size_t size( void const* ) const { return table().lifetime->size; }
+   size_t alignment( void const* ) const { return table().lifetime->alignment; }
+   void copy( void const* src, void* dst ) const { table().lifetime->copy( src, dst ); }
+   void move( void* src, void* dst ) const noexcept { table().lifetime->move( src, dst ); }
+   void destroy( void* object ) const noexcept { table().lifetime->destroy( object ); }
+
+   template< typename Op, typename Object, typename... Args >
+   decltype(auto) invoke( Object* object, Args&&... args ) const
+   {
+      return std::get<indexOf<Op,Ops...>()>( table().operations )(
+         object, std::forward<Args>(args)... );
+   }
+
+ private:
+   using Table = VTable<Ops...>;
+
+   template< typename T >
+   static constexpr auto initialTable()
+   {
+      if constexpr( Shared ) return &vtable<T,Ops...>;
+      else return vtable<T,Ops...>;
+   }
+
+   Table const& table() const
+   {
+      if constexpr( Shared ) return *table_;
+      else return table_;
+   }
+
+   std::conditional_t<Shared,Table const*,Table> table_;
+};
+
+} // namespace detail
+
+
+//---- Dispatch policies --------------------------------------------------------------------------
+
+// Dispatch by means of a virtual 'Concept' base class and a 'Model' class template (the External
+// Polymorphism design pattern). The storage holds the model, including its virtual pointer.
+struct virtual_dispatch
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class virtual_dispatch::dispatcher<interface<Ops...>>
+{
+ private:
+   using Concept = typename detail::ConceptChain<detail::ConceptRoot,Ops...>::type;
+
+   template< typename T >
+   struct Model final
+      : public detail::ModelChain<detail::ValueHolder<T,Concept>,Ops...>::type
+   {
+      using Base = typename detail::ModelChain<detail::ValueHolder<T,Concept>,Ops...>::type;
+      using Base::Base;
+
+      size_t size() const override { return sizeof(Model); }
+      size_t alignment() const override { return alignof(Model); }
+
+      void copy( void* memory ) const override
+      {
+         std::construct_at( static_cast<Model*>( memory ), *this );
+      }
+
+      void move( void* memory ) noexcept override
+      {
+         std::construct_at( static_cast<Model*>( memory ), std::move(*this) );
+      }
+   };
+
+   static Concept const* toConcept( void const* object )
+   {
+      return std::launder( reinterpret_cast<Concept const*>( object ) );
+   }
+
+   static Concept* toConcept( void* object )
+   {
+      return std::launder( reinterpret_cast<Concept*>( object ) );
+   }
+
+ public:
+   template< typename T >
+   using stored_type = Model<T>;
+
+   template< typename T >
+   explicit dispatcher( std::type_identity<T> ) {}
+
+   size_t size( void const* object ) const { return toConcept( object )->size(); }
+   size_t alignment( void const* object ) const { return toConcept( object )->alignment(); }
+   void copy( void const* src, void* dst ) const { toConcept( src )->copy( dst ); }
+   void move( void* src, void* dst ) const noexcept { toConcept( src )->move( dst ); }
+   void destroy( void* object ) const noexcept { std::destroy_at( toConcept( object ) ); }
+
+   template< typename Op, typename Object, typename... Args >
+   decltype(auto) invoke( Object* object, Args&&... args ) const
+   {
+      return toConcept( object )->invoke( Op{}, std::forward<Args>(args)... );
+   }
+};
+
+// Dispatch by means of function pointers stored inside every object. This avoids the indirection
+// via a virtual function table, but every operation increases the size of the objects. The
+// functions for the lifetime management are shared in a static table.
+struct inline_vtable
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class inline_vtable::dispatcher<interface<Ops...>>
+   : public detail::VTableDispatcher<false,Ops...>
+{
+ public:
+   using detail::VTableDispatcher<false,Ops...>::VTableDispatcher;
+};
+
+// Dispatch by means of a single, static constexpr virtual function table per concrete type. Every
+// object stores a single pointer to this table, independent of the number of operations.
+struct shared_vtable
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class shared_vtable::dispatcher<interface<Ops...>>
+   : public detail::VTableDispatcher<true,Ops...>
+{
+ public:
+   using detail::VTableDispatcher<true,Ops...>::VTableDispatcher;
+};
+
+
+//---- Storage policies ---------------------------------------------------------------------------
+
+// Stores the object on the heap. A moved-from object is empty.
+class heap_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      void* const memory( detail::allocate( sizeof(Stored), alignof(Stored) ) );
+      try {
+         object_ = std::construct_at( static_cast<Stored*>( memory ), std::forward<Args>(args)... );
+      }
+      catch( ... ) {
+         detail::deallocate( memory, sizeof(Stored), alignof(Stored) );
+         throw;
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( heap_storage const& other, Dispatcher const& dispatcher )
+   {
+      size_t const size( dispatcher.size( other.object_ ) );
+      size_t const alignment( dispatcher.alignment( other.object_ ) );
+      void* const memory( detail::allocate( size, alignment ) );
+      try {
+         dispatcher.copy( other.object_, memory );
+      }
+      catch( ... ) {
+         detail::deallocate( memory, size, alignment );
+         throw;
+      }
+      object_ = memory;
+   }
+
+   template< typename Dispatcher >
+   void move( heap_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = std::exchange( other.object_, nullptr );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( !object_ ) return;
+      size_t const size( dispatcher.size( object_ ) );
+      size_t const alignment( dispatcher.alignment( object_ ) );
+      dispatcher.destroy( object_ );
+      detail::deallocate( object_, size, alignment );
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return object_; }
+
+ private:
+   void* object_{};
+};
+
+// Stores the object in an in-class buffer. Objects that do not fit into the buffer are rejected
+// at compile time, i.e. the storage never allocates dynamic memory.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class sbo_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      static_assert( sizeof(Stored) <= Capacity, "Given type is too large" );
+      static_assert( Alignment % alignof(Stored) == 0U, "Given type is misaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Stored>, "Given type is not movable" );
+
+      std::construct_at( reinterpret_cast<Stored*>( buffer_.data() ), std::forward<Args>(args)... );
+   }
+
+   template< typename Dispatcher >
+   void copy( sbo_storage const& other, Dispatcher const& dispatcher )
+   {
+      dispatcher.copy( other.buffer_.data(), buffer_.data() );
+   }
+
+   template< typename Dispatcher >
+   void move( sbo_storage& other, Dispatcher const& dispatcher ) noexcept
+   {
+      dispatcher.move( other.buffer_.data(), buffer_.data() );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      dispatcher.destroy( buffer_.data() );
+   }
+
+   void const* get() const { return buffer_.data(); }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return buffer_.data(); }
+
+ private:
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+// Stores a trivially copyable object (e.g. a pair of pointers) in an in-class buffer. Copies are
+// plain copies of the buffer and no destructor has to be called, i.e. the lifetime management
+// does not require any indirect function call.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class trivial_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      static_assert( sizeof(Stored) <= Capacity, "Given type is too large" );
+      static_assert( Alignment % alignof(Stored) == 0U, "Given type is misaligned" );
+      static_assert( std::is_trivially_copyable_v<Stored>, "Given type is not trivially copyable" );
+
+      std::construct_at( reinterpret_cast<Stored*>( buffer_.data() ), std::forward<Args>(args)... );
+   }
+
+   template< typename Dispatcher >
+   void copy( trivial_storage const& other, Dispatcher const& ) noexcept
+   {
+      buffer_ = other.buffer_;
+   }
+
+   template< typename Dispatcher >
+   void move( trivial_storage& other, Dispatcher const& ) noexcept
+   {
+      buffer_ = other.buffer_;
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& ) noexcept {}
+
+   void const* get() const { return buffer_.data(); }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return buffer_.data(); }
+
+ private:
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+// Stores the object in an in-class buffer if it fits and else on the heap. In contrast to the
+// pure in-class buffer, the storage has to remember where the object is located.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class sbo_fallback_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      if constexpr( fitsInline<Stored> ) {
+         object_ = std::construct_at( reinterpret_cast<Stored*>( buffer_.data() )
+                                    , std::forward<Args>(args)... );
+      }
+      else {
+         void* const memory( detail::allocate( sizeof(Stored), alignof(Stored) ) );
+         try {
+            object_ = std::construct_at( static_cast<Stored*>( memory )
+                                       , std::forward<Args>(args)... );
+         }
+         catch( ... ) {
+            detail::deallocate( memory, sizeof(Stored), alignof(Stored) );
+            throw;
+         }
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( sbo_fallback_storage const& other, Dispatcher const& dispatcher )
+   {
+      if( other.isInline() ) {
+         dispatcher.copy( other.object_, buffer_.data() );
+         object_ = buffer_.data();
+      }
+      else {
+         size_t const size( dispatcher.size( other.object_ ) );
+         size_t const alignment( dispatcher.alignment( other.object_ ) );
+         void* const memory( detail::allocate( size, alignment ) );
+         try {
+            dispatcher.copy( other.object_, memory );
+         }
+         catch( ... ) {
+            detail::deallocate( memory, size, alignment );
+            throw;
+         }
+         object_ = memory;
+      }
+   }
+
+   template< typename Dispatcher >
+   void move( sbo_fallback_storage& other, Dispatcher const& dispatcher ) noexcept
+   {
+      if( other.isInline() ) {
+         dispatcher.move( other.object_, buffer_.data() );
+         object_ = buffer_.data();
+      }
+      else {
+         object_ = std::exchange( other.object_, nullptr );
+      }
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( !object_ ) return;
+      if( isInline() ) {
+         dispatcher.destroy( object_ );
+      }
+      else {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         dispatcher.destroy( object_ );
+         detail::deallocate( object_, size, alignment );
+      }
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return object_; }
+
+ private:
+   template< typename Stored >
+   static constexpr bool fitsInline =
+      sizeof(Stored) <= Capacity && Alignment % alignof(Stored) == 0U &&
+      std::is_nothrow_move_constructible_v<Stored>;
+
+   bool isInline() const { return object_ == static_cast<void const*>( buffer_.data() ); }
+
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+   void* object_{};
+};
+
+// Refers to an object without owning it. It is the responsibility of the user to guarantee that
+// the referenced object outlives all references to it. Since the referenced object is not part
+// of the storage, this policy requires a function pointer based dispatch, and since the object
+// is referenced as const, it only supports non-modifying operations.
+class non_owning_storage
+{
+ public:
+   template< typename Stored, typename T >
+   void create( T const& object )
+   {
+      static_assert( std::is_same_v<Stored,T>, "Non-owning storage requires a vtable dispatch" );
+      object_ = std::addressof( object );
+   }
+
+   template< typename Stored, typename T >
+   void create( T const&& ) = delete;  // Binding a temporary would result in a dangling reference
+
+   template< typename Dispatcher >
+   void copy( non_owning_storage const& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+   }
+
+   template< typename Dispatcher >
+   void move( non_owning_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& ) noexcept {}
+
+   void const* get() const { return object_; }
+
+ private:
+   void const* object_{};
+};
+
+// Stores the object on the heap and shares it between all copies (copy-on-write). The reference
+// count is placed in front of the object within the same allocation. Modifying operations first
+// create an exclusive copy of a shared object.
+class cow_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      void* const memory( allocate( sizeof(Stored), alignof(Stored) ) );
+      try {
+         object_ = std::construct_at( static_cast<Stored*>( memory ), std::forward<Args>(args)... );
+      }
+      catch( ... ) {
+         deallocate( memory, sizeof(Stored), alignof(Stored) );
+         throw;
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( cow_storage const& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+      counter( object_ ).fetch_add( 1U, std::memory_order_relaxed );
+   }
+
+   template< typename Dispatcher >
+   void move( cow_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = std::exchange( other.object_, nullptr );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( object_ && counter( object_ ).fetch_sub( 1U, std::memory_order_acq_rel ) == 1U ) {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         dispatcher.destroy( object_ );
+         deallocate( object_, size, alignment );
+      }
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& dispatcher )
+   {
+      if( counter( object_ ).load( std::memory_order_acquire ) > 1U ) {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         void* const memory( allocate( size, alignment ) );
+         try {
+            dispatcher.copy( object_, memory );
+         }
+         catch( ... ) {
+            deallocate( memory, size, alignment );
+            throw;
+         }
+         destroy( dispatcher );
+         object_ = memory;
+      }
+      return object_;
+   }
+
+   bool isShared() const
+   {
+      return object_ && counter( object_ ).load( std::memory_order_relaxed ) > 1U;
+   }
+
+ private:
+   using Counter = std::atomic<size_t>;
+
+   static size_t blockAlignment( size_t alignment )
+   {
+      return std::max( alignment, alignof(Counter) );
+   }
+
+   static size_t headerSize( size_t alignment )
+   {
+      size_t const a( blockAlignment( alignment ) );
+      return ( sizeof(Counter) + a - 1U ) / a * a;
+   }
+
+   static Counter& counter( void const* object )
+   {
+      std::byte* const bytes( static_cast<std::byte*>( const_cast<void*>( object ) ) );
+      return *std::launder( reinterpret_cast<Counter*>( bytes - sizeof(Counter) ) );
+   }
+
+   // Allocates a block for the reference count and the object and returns the object address
+   static void* allocate( size_t size, size_t alignment )
+   {
+      size_t const header( headerSize( alignment ) );
+      void* const memory( detail::allocate( header + size, blockAlignment( alignment ) ) );
+      std::byte* const block( static_cast<std::byte*>( memory ) );
+      std::construct_at( reinterpret_cast<Counter*>( block + header - sizeof(Counter) ), 1U );
+      return block + header;
+   }
+
+   static void deallocate( void* object, size_t size, size_t alignment ) noexcept
+   {
+      size_t const header( headerSize( alignment ) );
+      std::destroy_at( &counter( object ) );
+      detail::deallocate( static_cast<std::byte*>( object ) - header
+                        , header + size, blockAlignment( alignment ) );
+   }
+
+   void* object_{};
+};
+
+
+//---- The type-erased wrapper --------------------------------------------------------------------
+
+// A value type for all types that provide the operations of the given interface. How the
+// object is stored is determined by the 'Storage' policy, how the operations are dispatched
+// is determined by the 'Dispatch' policy. The default combination corresponds to the classic
+// Type Erasure implementation based on std::unique_ptr and a virtual 'Concept' base class.
+template< typename Interface
+        , typename Storage = heap_storage
+        , typename Dispatch = virtual_dispatch >
+class erased
+{
+ private:
+   using Dispatcher = typename Dispatch::template dispatcher<Interface>;
+
+ public:
+   template< typename T >
+      requires ( !std::is_same_v<std::remove_cvref_t<T>,erased> )
+   explicit erased( T&& value )
+      : dispatcher_( std::type_identity<std::remove_cvref_t<T>>{} )
+   {
+      using Stored = typename Dispatcher::template stored_type<std::remove_cvref_t<T>>;
+      storage_.template create<Stored>( std::forward<T>(value) );
+   }
+
+   erased( erased const& other )
+      : dispatcher_( other.dispatcher_ )
+   {
+      storage_.copy( other.storage_, dispatcher_ );
+   }
+
+   erased& operator=( erased const& other )
+   {
+      if( this != &other ) {
+         erased copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   erased( erased&& other ) noexcept
+      : dispatcher_( other.dispatcher_ )
+   {
+      storage_.move( other.storage_, dispatcher_ );
+   }
+
+   erased& operator=( erased&& other ) noexcept
+   {
+      if( this != &other ) {
+         storage_.destroy( dispatcher_ );
+         dispatcher_ = other.dispatcher_;
+         storage_.move( other.storage_, dispatcher_ );
+      }
+      return *this;
+   }
+
+   ~erased()
+   {
+      storage_.destroy( dispatcher_ );
+   }
+
+   template< typename Op, typename... Args >
+   decltype(auto) call( Args&&... args ) const
+   {
+      static_assert( !detail::OpTraits<Op>::modifying, "Modifying operation on a const object" );
+      return dispatcher_.template invoke<Op>( storage_.get(), std::forward<Args>(args)... );
+   }
+
+   template< typename Op, typename... Args >
+   decltype(auto) call( Args&&... args )
+   {
+      if constexpr( detail::OpTraits<Op>::modifying ) {
+         return dispatcher_.template invoke<Op>(
+            storage_.getMutable( dispatcher_ ), std::forward<Args>(args)... );
+      }
+      else {
+         return std::as_const(*this).template call<Op>( std::forward<Args>(args)... );
+      }
+   }
+
+   Storage const& storage() const { return storage_; }
+
+ private:
+   [[no_unique_address]] Dispatcher dispatcher_;
+   Storage storage_;
+};
+
+} // namespace erasure
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   void scale( double factor ) { radius_ *= factor; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   void scale( double factor ) { side_ *= factor; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <Erased.h>
+#include <utility>
+
+// The operations of the Shape interface, declared once for all storage and dispatch policies
+struct Draw
+{
+   using signature = void() const;
+
+   template< typename T >
+   static void invoke( T const& drawing ) { drawing.draw(); }
+};
+
+struct Scale
+{
+   using signature = void( double );
+
+   template< typename T >
+   static void invoke( T& drawing, double factor ) { drawing.scale( factor ); }
+};
+
+// The combination of a shape and its drawing strategy, i.e. the type that is erased
+template< typename ShapeT, typename DrawStrategy >
+struct Drawing
+{
+   void draw() const { drawer( shape ); }
+   void scale( double factor ) { shape.scale( factor ); }
+
+   ShapeT shape;
+   DrawStrategy drawer;
+};
+
+template< typename Storage, typename Dispatch >
+class BasicShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   BasicShape( ShapeT shape, DrawStrategy drawer )
+      : erased_( Drawing<ShapeT,DrawStrategy>{ std::move(shape), std::move(drawer) } )
+   {}
+
+ private:
+   friend void draw( BasicShape const& shape ) { shape.erased_.template call<Draw>(); }
+   friend void scale( BasicShape& shape, double f ) { shape.erased_.template call<Scale>( f ); }
+
+   friend Storage const& storage( BasicShape const& shape ) { return shape.erased_.storage(); }
+
+   erasure::erased<erasure::interface<Draw,Scale>,Storage,Dispatch> erased_;
+};
+
+// Guideline 32: the classic Type Erasure implementation
+using Shape = BasicShape<erasure::heap_storage,erasure::virtual_dispatch>;
+
+// Guideline 33: Type Erasure with Small Buffer Optimization and with manual virtual dispatch
+using SboShape = BasicShape<erasure::sbo_storage<32U>,erasure::virtual_dispatch>;
+using ManualShape = BasicShape<erasure::heap_storage,erasure::inline_vtable>;
+using SharedVtableShape = BasicShape<erasure::sbo_storage<32U>,erasure::shared_vtable>;
+
+// A Shape that spills large models to the heap and a Shape sharing its model (copy-on-write)
+using HybridShape = BasicShape<erasure::sbo_fallback_storage<32U>,erasure::virtual_dispatch>;
+using CowShape = BasicShape<erasure::cow_storage,erasure::shared_vtable>;
+
+
+//---- <ShapeConstRef.h> --------------------------------------------------------------------------
+
+//#include <Erased.h>
+//#include <Shape.h>
+
+// Guideline 34: a non-owning reference to a shape and a drawing strategy. The two pointers are
+// stored in a trivially copyable buffer next to the pointer to the shared virtual function
+// table, which results in the same three pointers as the hand-written ShapeConstRef.
+template< typename ShapeT, typename DrawStrategy >
+struct DrawingRef
+{
+   void draw() const { (*drawer)( *shape ); }
+
+   ShapeT const* shape;
+   DrawStrategy const* drawer;
+};
+
+class ShapeConstRef
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ShapeConstRef( ShapeT const& shape, DrawStrategy const& drawer )
+      : erased_( DrawingRef<ShapeT,DrawStrategy>{ &shape, &drawer } )
+   {}
+
+ private:
+   friend void draw( ShapeConstRef const& shape ) { shape.erased_.template call<Draw>(); }
+
+   erasure::erased<erasure::interface<Draw>
+                  ,erasure::trivial_storage<2U*sizeof(void*)>
+                  ,erasure::shared_vtable> erased_;
+};
+
+
+//---- <Money.h> ----------------------------------------------------------------------------------
+
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+
+struct Money
+{
+   uint64_t value{};
+};
+
+template< typename T >
+   requires std::is_arithmetic_v<T>
+Money operator*( Money money, T factor )
+{
+   return Money{ static_cast<uint64_t>( money.value * factor ) };
+}
+
+constexpr Money operator+( Money lhs, Money rhs ) noexcept
+{
+   return Money{ lhs.value + rhs.value };
+}
+
+std::ostream& operator<<( std::ostream& os, Money money )
+{
+   return os << money.value;
+}
+
+
+//---- <Item.h> -----------------------------------------------------------------------------------
+
+//#include <Erased.h>
+//#include <Money.h>
+#include <type_traits>
+#include <utility>
+
+struct Price
+{
+   using signature = Money() const;
+
+   template< typename T >
+   static Money invoke( T const& item ) { return item.price(); }
+};
+
+// Guideline 36: the Item of the runtime Decorator
+class Item
+{
+ public:
+   template< typename T >
+      requires ( !std::is_same_v<T,Item> )
+   Item( T item )
+      : erased_( std::move(item) )
+   {}
+
+   Money price() const { return erased_.template call<Price>(); }
+
+ private:
+   erasure::erased<erasure::interface<Price>> erased_;
+};
+
+// A non-owning reference to any item, e.g. for a temporary view on an item
+using ItemRef =
+   erasure::erased<erasure::interface<Price>,erasure::non_owning_storage,erasure::shared_vtable>;
+
+
+//---- <ConferenceTicket.h> -----------------------------------------------------------------------
+
+//#include <Money.h>
+#include <string>
+#include <utility>
+
+class ConferenceTicket
+{
+ public:
+   ConferenceTicket( std::string name, Money price )
+      : name_{ std::move(name) }
+      , price_{ price }
+   {}
+
+   std::string const& name() const { return name_; }
+   Money price() const { return price_; }
+
+ private:
+   std::string name_;
+   Money price_;
+};
+
+
+//---- <Discounted.h> -----------------------------------------------------------------------------
+
+//#include <Item.h>
+#include <utility>
+
+class Discounted
+{
+ public:
+   Discounted( double discount, Item item )
+      : item_( std::move(item) )
+      , factor_( 1.0 - discount )
+   {}
+
+   Money price() const
+   {
+      return item_.price() * factor_;
+   }
+
+ private:
+   Item item_;
+   double factor_;
+};
+
+
+//---- <Taxed.h> ----------------------------------------------------------------------------------
+
+//#include <Item.h>
+#include <utility>
+
+class Taxed
+{
+ public:
+   Taxed( double taxRate, Item item )
+      : item_( std::move(item) )
+      , factor_( 1.0 + taxRate )
+   {}
+
+   Money price() const
+   {
+      return item_.price() * factor_;
+   }
+
+ private:
+   Item item_;
+   double factor_;
+};
+
+
+//---- <Observer.h> -------------------------------------------------------------------------------
+
+//#include <Erased.h>
+#include <type_traits>
+#include <utility>
+
+template< typename Subject, typename StateTag >
+struct Update
+{
+   using signature = void( Subject const&, StateTag );
+
+   template< typename T >
+   static void invoke( T& onUpdate, Subject const& subject, StateTag property )
+   {
+      onUpdate( subject, property );
+   }
+};
+
+// Guideline 25: the value-based Observer. Any callable that can be invoked with the subject and
+// the state tag responds to an update. In contrast to the std::function based Observer, the
+// callable is stored in a small buffer and invoked via a shared virtual function table.
+template< typename Subject, typename StateTag >
+class Observer
+{
+ public:
+   template< typename OnUpdate >
+      requires ( !std::is_same_v<OnUpdate,Observer> )
+   explicit Observer( OnUpdate onUpdate )
+      : erased_( std::move(onUpdate) )
+   {}
+
+   void update( Subject const& subject, StateTag property )
+   {
+      erased_.template call<Update<Subject,StateTag>>( subject, property );
+   }
+
+ private:
+   erasure::erased<erasure::interface<Update<Subject,StateTag>>
+                  ,erasure::sbo_storage<32U>
+                  ,erasure::shared_vtable> erased_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <ConferenceTicket.h>
+//#include <Discounted.h>
+//#include <Item.h>
+//#include <Observer.h>
+//#include <Shape.h>
+//#include <ShapeConstRef.h>
+//#include <Square.h>
+//#include <Taxed.h>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template< typename ShapeType >
+void drawAllShapes( std::vector<ShapeType> const& shapes )
+{
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+}
+
+int main()
+{
+   // Create a drawing strategy in form of a lambda
+   auto drawer = []( auto const& shape ){ /*...*/ };
+
+   // A drawing strategy with some more state, which does not fit into a small buffer
+   std::array<double,4> color{ 0.2, 0.4, 0.6, 1.0 };
+   auto colorDrawer = [color]( auto const& shape ){ /*...*/ };
+
+   std::vector<Shape> shapes{};
+   shapes.emplace_back( Circle{ 3.14 }, drawer );
+   shapes.emplace_back( Square{ 2.0 }, colorDrawer );
+   drawAllShapes( shapes );
+
+   std::vector<SboShape> sboShapes{ { Circle{ 3.14 }, drawer }, { Square{ 2.0 }, drawer } };
+   std::vector<ManualShape> manualShapes{ { Circle{ 3.14 }, drawer }, { Square{ 2.0 }, drawer } };
+   std::vector<SharedVtableShape> sharedShapes{ { Circle{ 3.14 }, drawer } };
+   std::vector<HybridShape> hybridShapes{ { Circle{ 3.14 }, drawer }
+                                        , { Square{ 2.0 }, colorDrawer } };
+   drawAllShapes( sboShapes );
+   drawAllShapes( manualShapes );
+   drawAllShapes( sharedShapes );
+   drawAllShapes( hybridShapes );
+
+   // The shape and the strategy have to outlive the reference
+   Circle const circle{ 1.0 };
+   ShapeConstRef const ref( circle, drawer );
+   draw( ref );
+
+   // The policies result in the same object sizes as the hand-written implementations
+   static_assert( sizeof(Shape) == sizeof(void*) );
+   static_assert( sizeof(SboShape) == 32U );
+   static_assert( sizeof(SharedVtableShape) == 32U + sizeof(void*) );
+   static_assert( sizeof(HybridShape) == 32U + sizeof(void*) );
+   static_assert( sizeof(ShapeConstRef) == 3U*sizeof(void*) );
+
+   // A copy of a copy-on-write shape shares the model until it is modified
+   CowShape const original( Square{ 2.0 }, drawer );
+   CowShape copy( original );
+   bool const sharedBefore( storage( original ).isShared() );
+   scale( copy, 2.0 );
+   bool const sharedAfter( storage( original ).isShared() );
+   draw( copy );
+
+   // 20% discount, 15% tax: (499*0.8)*1.15 = 459.08, truncated per step to 458
+   Item item( Taxed( 0.15, Discounted( 0.2, ConferenceTicket{ "Core C++", Money{499} } ) ) );
+   ItemRef const itemRef( item );
+   std::cout << "Total price: " << itemRef.call<Price>() << '\n';
+
+   // An observer of a ticket, which only responds to price changes
+   enum class TicketChange { nameChanged, priceChanged };
+   int priceChanges{};
+   Observer<ConferenceTicket,TicketChange> priceObserver(
+      [&priceChanges]( ConferenceTicket const& /*ticket*/, TicketChange property ){
+         if( property == TicketChange::priceChanged ) ++priceChanges;
+      } );
+
+   ConferenceTicket const ticket{ "Core C++", Money{499} };
+   priceObserver.update( ticket, TicketChange::nameChanged );
+   priceObserver.update( ticket, TicketChange::priceChanged );
+
+   return ( sharedBefore && !sharedAfter && item.price().value == 458U && priceChanges == 1 )
+          ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
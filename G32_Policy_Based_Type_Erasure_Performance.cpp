@@ -0,0 +1,1762 @@
+/**************************************************************************************************
+*
+* \file G32_Policy_Based_Type_Erasure_Performance.cpp
+* \brief Guideline 32: Consider Replacing Inheritance Hierarchies with Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the hand-written Type
+* Erasure wrappers of Guidelines 32 to 36 against the according combinations of storage and
+* dispatch policies of the generic 'erasure::erased' class template: the classic Shape, the
+* Shape with Small Buffer Optimization, the Shape with manual virtual dispatch, the Shape with a
+* shared virtual function table, the Shape that spills large models to the heap, the non-owning
+* ShapeConstRef, the copy-on-write Shape and the Item of the runtime Decorator. All shapes provide
+* the same 'Draw' and 'Scale' operations as in the example. The 'allocs/shape' counter reports
+* the dynamic memory allocations per shape.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_CREATE_AND_DRAW     1  // Creating a scene of shapes and drawing all shapes
+#define BENCHMARK_DRAW                1  // Drawing all shapes of an existing scene
+#define BENCHMARK_DRAW_REFS           1  // Creating references to shapes and drawing them
+#define BENCHMARK_SNAPSHOT_AND_MODIFY 1  // Copying a scene and modifying every 10th shape
+#define BENCHMARK_PRICES              1  // Computing the prices of decorated items
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the number of allocations per shape. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocations{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   ++allocations;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Shapes and items ---------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+   void scale( double factor ) { radius_ *= factor; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+   void scale( double factor ) { side_ *= factor; }
+
+ private:
+   double side_;
+};
+
+auto const circleDrawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+auto const squareDrawer = []( Square const& s ){ benchmark::DoNotOptimize( s.side() ); };
+
+struct Money
+{
+   uint64_t value{};
+};
+
+Money operator*( Money money, double factor )
+{
+   return Money{ static_cast<uint64_t>( money.value * factor ) };
+}
+
+class ConferenceTicket
+{
+ public:
+   ConferenceTicket( std::string name, Money price )
+      : name_{ std::move(name) }, price_{ price } {}
+
+   Money price() const { return price_; }
+
+ private:
+   std::string name_;
+   Money price_;
+};
+
+// A decorator, which is generic in the type of the item (i.e. the hand-written or the generated)
+template< typename ItemT >
+class Discounted
+{
+ public:
+   Discounted( double discount, ItemT item )
+      : item_( std::move(item) ), factor_( 1.0 - discount ) {}
+
+   Money price() const { return item_.price() * factor_; }
+
+ private:
+   ItemT item_;
+   double factor_;
+};
+
+
+//---- Hand-written Type Erasure wrappers ---------------------------------------------------------
+
+namespace hand_written {
+
+// Guideline 32: the classic Type Erasure implementation
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+      : pimpl_( std::make_unique<Model<ShapeT,DrawStrategy>>( std::move(shape)
+                                                            , std::move(drawer) ) )
+   {}
+
+   Shape( Shape const& other ) : pimpl_( other.pimpl_->clone() ) {}
+   Shape& operator=( Shape const& other ) { pimpl_ = other.pimpl_->clone(); return *this; }
+   Shape( Shape&& ) = default;
+   Shape& operator=( Shape&& ) = default;
+
+ private:
+   friend void draw( Shape const& shape ) { shape.pimpl_->draw(); }
+   friend void scale( Shape& shape, double factor ) { shape.pimpl_->scale( factor ); }
+
+   struct Concept
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual void scale( double factor ) = 0;
+      virtual std::unique_ptr<Concept> clone() const = 0;
+   };
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model : public Concept
+   {
+      Model( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+
+      void draw() const override { drawer_( shape_ ); }
+      void scale( double factor ) override { shape_.scale( factor ); }
+      std::unique_ptr<Concept> clone() const override { return std::make_unique<Model>( *this ); }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   std::unique_ptr<Concept> pimpl_;
+};
+
+// Guideline 33: Type Erasure with Small Buffer Optimization
+class SboShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   SboShape( ShapeT shape, DrawStrategy drawer )
+   {
+      using M = Model<ShapeT,DrawStrategy>;
+      static_assert( sizeof(M) <= sizeof(buffer_), "Given type is too large" );
+      std::construct_at( reinterpret_cast<M*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   SboShape( SboShape const& other ) { other.pimpl()->clone( buffer_.data() ); }
+   SboShape( SboShape&& other ) noexcept { other.pimpl()->move( buffer_.data() ); }
+   ~SboShape() { std::destroy_at( pimpl() ); }
+
+   SboShape& operator=( SboShape const& other )
+   {
+      SboShape copy( other );
+      std::destroy_at( pimpl() );
+      copy.pimpl()->move( buffer_.data() );
+      return *this;
+   }
+
+   SboShape& operator=( SboShape&& other ) noexcept
+   {
+      std::destroy_at( pimpl() );
+      other.pimpl()->move( buffer_.data() );
+      return *this;
+   }
+
+ private:
+   friend void draw( SboShape const& shape ) { shape.pimpl()->draw(); }
+   friend void scale( SboShape& shape, double factor ) { shape.pimpl()->scale( factor ); }
+
+   struct Concept
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual void scale( double factor ) = 0;
+      virtual void clone( std::byte* memory ) const = 0;
+      virtual void move( std::byte* memory ) noexcept = 0;
+   };
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model : public Concept
+   {
+      Model( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+
+      void draw() const override { drawer_( shape_ ); }
+      void scale( double factor ) override { shape_.scale( factor ); }
+
+      void clone( std::byte* memory ) const override
+      {
+         std::construct_at( reinterpret_cast<Model*>( memory ), *this );
+      }
+
+      void move( std::byte* memory ) noexcept override
+      {
+         std::construct_at( reinterpret_cast<Model*>( memory ), std::move(*this) );
+      }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   Concept* pimpl() { return std::launder( reinterpret_cast<Concept*>( buffer_.data() ) ); }
+
+   Concept const* pimpl() const
+   {
+      return std::launder( reinterpret_cast<Concept const*>( buffer_.data() ) );
+   }
+
+   alignas(void*) std::array<std::byte,32U> buffer_;
+};
+
+// Guideline 33: Type Erasure with manual virtual dispatch
+class ManualShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ManualShape( ShapeT shape, DrawStrategy drawer )
+      : pimpl_( new Model<ShapeT,DrawStrategy>{ std::move(shape), std::move(drawer) }
+              , []( void* bytes ){ delete static_cast<Model<ShapeT,DrawStrategy>*>( bytes ); } )
+      , draw_( []( void* bytes ){
+           auto* const model( static_cast<Model<ShapeT,DrawStrategy>*>( bytes ) );
+           model->drawer_( model->shape_ );
+        } )
+      , scale_( []( void* bytes, double factor ){
+           static_cast<Model<ShapeT,DrawStrategy>*>( bytes )->shape_.scale( factor );
+        } )
+      , clone_( []( void* bytes ) -> void* {
+           using M = Model<ShapeT,DrawStrategy>;
+           return new M( *static_cast<M*>( bytes ) );
+        } )
+   {}
+
+   ManualShape( ManualShape const& other )
+      : pimpl_( other.clone_( other.pimpl_.get() ), other.pimpl_.get_deleter() )
+      , draw_( other.draw_ )
+      , scale_( other.scale_ )
+      , clone_( other.clone_ )
+   {}
+
+   ManualShape& operator=( ManualShape const& other )
+   {
+      ManualShape copy( other );
+      *this = std::move(copy);
+      return *this;
+   }
+
+   ManualShape( ManualShape&& ) = default;
+   ManualShape& operator=( ManualShape&& ) = default;
+
+ private:
+   friend void draw( ManualShape const& shape ) { shape.draw_( shape.pimpl_.get() ); }
+
+   friend void scale( ManualShape& shape, double factor )
+   {
+      shape.scale_( shape.pimpl_.get(), factor );
+   }
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model
+   {
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   std::unique_ptr<void,void(*)(void*)> pimpl_;
+   void (*draw_)( void* );
+   void (*scale_)( void*, double );
+   void* (*clone_)( void* );
+};
+
+// Guideline 33: Type Erasure with a single, static virtual function table per model
+class SharedVtableShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   SharedVtableShape( ShapeT shape, DrawStrategy drawer )
+      : vtable_( &vtable<Model<ShapeT,DrawStrategy>> )
+   {
+      using M = Model<ShapeT,DrawStrategy>;
+      static_assert( sizeof(M) <= sizeof(buffer_), "Given type is too large" );
+      std::construct_at( reinterpret_cast<M*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   SharedVtableShape( SharedVtableShape const& other )
+      : vtable_( other.vtable_ )
+   {
+      vtable_->clone( other.buffer_.data(), buffer_.data() );
+   }
+
+   SharedVtableShape( SharedVtableShape&& other ) noexcept
+      : vtable_( other.vtable_ )
+   {
+      vtable_->move( other.buffer_.data(), buffer_.data() );
+   }
+
+   ~SharedVtableShape() { vtable_->destroy( buffer_.data() ); }
+
+   SharedVtableShape& operator=( SharedVtableShape const& other )
+   {
+      SharedVtableShape copy( other );
+      *this = std::move(copy);
+      return *this;
+   }
+
+   SharedVtableShape& operator=( SharedVtableShape&& other ) noexcept
+   {
+      vtable_->destroy( buffer_.data() );
+      vtable_ = other.vtable_;
+      vtable_->move( other.buffer_.data(), buffer_.data() );
+      return *this;
+   }
+
+ private:
+   friend void draw( SharedVtableShape const& shape )
+   {
+      shape.vtable_->draw( shape.buffer_.data() );
+   }
+
+   friend void scale( SharedVtableShape& shape, double factor )
+   {
+      shape.vtable_->scale( shape.buffer_.data(), factor );
+   }
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model
+   {
+      Model( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   struct VTable
+   {
+      void (*draw)   ( std::byte const* );
+      void (*scale)  ( std::byte*, double );
+      void (*clone)  ( std::byte const*, std::byte* );
+      void (*move)   ( std::byte*, std::byte* ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename M >
+   static M const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<M const*>( bytes ) );
+   }
+
+   template< typename M >
+   static M& model( std::byte* bytes ) { return *std::launder( reinterpret_cast<M*>( bytes ) ); }
+
+   template< typename M >
+   static constexpr VTable vtable{
+        []( std::byte const* bytes ){ auto const& m = model<M>( bytes ); m.drawer_( m.shape_ ); }
+      , []( std::byte* bytes, double factor ){ model<M>( bytes ).shape_.scale( factor ); }
+      , []( std::byte const* src, std::byte* dst ){
+           std::construct_at( reinterpret_cast<M*>( dst ), model<M>( src ) );
+        }
+      , []( std::byte* src, std::byte* dst ) noexcept {
+           std::construct_at( reinterpret_cast<M*>( dst ), std::move( model<M>( src ) ) );
+        }
+      , []( std::byte* bytes ) noexcept { std::destroy_at( &model<M>( bytes ) ); } };
+
+   VTable const* vtable_;
+   alignas(void*) std::array<std::byte,32U> buffer_;
+};
+
+// Guideline 33: Type Erasure with a small buffer, which spills large models to the heap
+class HybridShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   HybridShape( ShapeT shape, DrawStrategy drawer )
+   {
+      using M = Model<ShapeT,DrawStrategy>;
+      if constexpr( fitsInline<M> ) {
+         pimpl_ = std::construct_at( reinterpret_cast<M*>( buffer_.data() )
+                                   , std::move(shape), std::move(drawer) );
+      }
+      else {
+         pimpl_ = new M( std::move(shape), std::move(drawer) );
+      }
+   }
+
+   HybridShape( HybridShape const& other ) : pimpl_( other.pimpl_->clone( buffer_.data() ) ) {}
+
+   HybridShape( HybridShape&& other ) noexcept
+      : pimpl_( other.pimpl_->move( buffer_.data() ) )
+   {
+      other.pimpl_ = nullptr;
+   }
+
+   ~HybridShape() { if( pimpl_ ) pimpl_->destroy(); }
+
+   HybridShape& operator=( HybridShape const& other )
+   {
+      HybridShape copy( other );
+      *this = std::move(copy);
+      return *this;
+   }
+
+   HybridShape& operator=( HybridShape&& other ) noexcept
+   {
+      if( pimpl_ ) pimpl_->destroy();
+      pimpl_ = other.pimpl_->move( buffer_.data() );
+      other.pimpl_ = nullptr;
+      return *this;
+   }
+
+ private:
+   friend void draw( HybridShape const& shape ) { shape.pimpl_->draw(); }
+   friend void scale( HybridShape& shape, double factor ) { shape.pimpl_->scale( factor ); }
+
+   struct Concept
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual void scale( double factor ) = 0;
+      virtual Concept* clone( std::byte* memory ) const = 0;
+      virtual Concept* move( std::byte* memory ) noexcept = 0;  // Destroys an inline source
+      virtual void destroy() noexcept = 0;
+   };
+
+   template< typename M >
+   static constexpr bool fitsInline =
+      sizeof(M) <= 32U && alignof(M) <= alignof(void*) && std::is_nothrow_move_constructible_v<M>;
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model : public Concept
+   {
+      Model( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+
+      void draw() const override { drawer_( shape_ ); }
+      void scale( double factor ) override { shape_.scale( factor ); }
+
+      Concept* clone( std::byte* memory ) const override
+      {
+         if constexpr( fitsInline<Model> )
+            return std::construct_at( reinterpret_cast<Model*>( memory ), *this );
+         else
+            return new Model( *this );
+      }
+
+      Concept* move( std::byte* memory ) noexcept override
+      {
+         if constexpr( fitsInline<Model> ) {
+            Model* const model( std::construct_at( reinterpret_cast<Model*>( memory )
+                                                 , std::move(*this) ) );
+            std::destroy_at( this );
+            return model;
+         }
+         else {
+            return this;
+         }
+      }
+
+      void destroy() noexcept override
+      {
+         if constexpr( fitsInline<Model> )
+            std::destroy_at( this );
+         else
+            delete this;
+      }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   alignas(void*) std::array<std::byte,32U> buffer_;
+   Concept* pimpl_{};
+};
+
+// Guideline 34: a non-owning reference to a shape and a drawing strategy
+class ShapeConstRef
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ShapeConstRef( ShapeT const& shape, DrawStrategy const& drawer )
+      : shape_{ std::addressof(shape) }
+      , drawer_{ std::addressof(drawer) }
+      , draw_{ []( void const* shapeBytes, void const* drawerBytes ){
+           ( *static_cast<DrawStrategy const*>( drawerBytes ) )(
+              *static_cast<ShapeT const*>( shapeBytes ) );
+        } }
+   {}
+
+ private:
+   friend void draw( ShapeConstRef const& shape ) { shape.draw_( shape.shape_, shape.drawer_ ); }
+
+   void const* shape_;
+   void const* drawer_;
+   void (*draw_)( void const*, void const* );
+};
+
+// A copy-on-write Shape with an intrusive reference count
+class CowShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   CowShape( ShapeT shape, DrawStrategy drawer )
+      : pimpl_( new Model<ShapeT,DrawStrategy>( std::move(shape), std::move(drawer) ) )
+   {}
+
+   CowShape( CowShape const& other ) : pimpl_( other.pimpl_ ) { pimpl_->acquire(); }
+   CowShape( CowShape&& other ) noexcept : pimpl_( std::exchange( other.pimpl_, nullptr ) ) {}
+   ~CowShape() { if( pimpl_ && pimpl_->release() ) delete pimpl_; }
+
+   CowShape& operator=( CowShape const& other )
+   {
+      CowShape copy( other );
+      std::swap( pimpl_, copy.pimpl_ );
+      return *this;
+   }
+
+   CowShape& operator=( CowShape&& other ) noexcept
+   {
+      CowShape tmp( std::move(other) );
+      std::swap( pimpl_, tmp.pimpl_ );
+      return *this;
+   }
+
+ private:
+   friend void draw( CowShape const& shape ) { shape.pimpl_->draw(); }
+
+   friend void scale( CowShape& shape, double factor )
+   {
+      if( shape.pimpl_->isShared() ) {
+         Concept* const copy( shape.pimpl_->clone() );
+         if( shape.pimpl_->release() ) delete shape.pimpl_;
+         shape.pimpl_ = copy;
+      }
+      shape.pimpl_->scale( factor );
+   }
+
+   struct Concept
+   {
+      Concept() = default;
+      Concept( Concept const& ) {}
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual void scale( double factor ) = 0;
+      virtual Concept* clone() const = 0;
+
+      void acquire() const { refCount_.fetch_add( 1U, std::memory_order_relaxed ); }
+      bool release() const { return refCount_.fetch_sub( 1U, std::memory_order_acq_rel ) == 1U; }
+      bool isShared() const { return refCount_.load( std::memory_order_acquire ) > 1U; }
+
+      mutable std::atomic<size_t> refCount_{ 1U };
+   };
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct Model : public Concept
+   {
+      Model( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+
+      void draw() const override { drawer_( shape_ ); }
+      void scale( double factor ) override { shape_.scale( factor ); }
+      Concept* clone() const override { return new Model( *this ); }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   Concept* pimpl_;
+};
+
+// Guideline 36: the Item of the runtime Decorator
+class Item
+{
+ public:
+   template< typename T >
+      requires ( !std::is_same_v<T,Item> )
+   Item( T item ) : pimpl_( std::make_unique<Model<T>>( std::move(item) ) ) {}
+
+   Item( Item const& item ) : pimpl_( item.pimpl_->clone() ) {}
+   Item& operator=( Item const& item ) { pimpl_ = item.pimpl_->clone(); return *this; }
+   Item( Item&& ) = default;
+   Item& operator=( Item&& ) = default;
+
+   Money price() const { return pimpl_->price(); }
+
+ private:
+   struct Concept
+   {
+      virtual ~Concept() = default;
+      virtual Money price() const = 0;
+      virtual std::unique_ptr<Concept> clone() const = 0;
+   };
+
+   template< typename T >
+   struct Model : public Concept
+   {
+      explicit Model( T item ) : item_( std::move(item) ) {}
+
+      Money price() const override { return item_.price(); }
+      std::unique_ptr<Concept> clone() const override { return std::make_unique<Model>( *this ); }
+
+      T item_;
+   };
+
+   std::unique_ptr<Concept> pimpl_;
+};
+
+} // namespace hand_written
+
+
+//---- Policy-based Type Erasure ------------------------------------------------------------------
+
+namespace erasure {
+
+// An interface is a list of operations. Every operation is a class with a nested 'signature'
+// (a const qualified function type for operations that do not modify the object) and a static
+// function template 'invoke()', which performs the operation on an object of concrete type.
+template< typename... Ops >
+struct interface {};
+
+namespace detail {
+
+template< typename Op, typename... Ops >
+constexpr size_t indexOf()
+{
+   constexpr std::array<bool,sizeof...(Ops)> matches{ std::is_same_v<Op,Ops>... };
+   for( size_t i=0U; i<matches.size(); ++i ) {
+      if( matches[i] ) return i;
+   }
+   return matches.size();
+}
+
+inline void* allocate( size_t size, size_t alignment )
+{
+   if( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) {
+      return ::operator new( size );
+   }
+   return ::operator new( size, std::align_val_t{ alignment } );
+}
+
+inline void deallocate( void* memory, size_t size, size_t alignment ) noexcept
+{
+   if( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) {
+      ::operator delete( memory, size );
+   }
+   else {
+      ::operator delete( memory, size, std::align_val_t{ alignment } );
+   }
+}
+
+// The building blocks for all dispatch policies, generated from the signature of an operation:
+// the function pointer type and the according thunk for a function pointer based dispatch, and
+// the pure virtual function and its override for a virtual dispatch.
+template< typename Op, typename Signature = typename Op::signature >
+struct OpTraits;
+
+template< typename Op, typename R, typename... Args >
+struct OpTraits<Op,R(Args...) const>
+{
+   static constexpr bool modifying = false;
+
+   using Pointer = R(*)( void const*, Args... );
+
+   template< typename T >
+   static R thunk( void const* object, Args... args )
+   {
+      return Op::invoke( *std::launder( static_cast<T const*>( object ) )
+                       , std::forward<Args>(args)... );
+   }
+
+   template< typename Base >
+   struct Concept : public Base
+   {
+      using Base::invoke;
+      virtual R invoke( Op, Args... ) const = 0;
+   };
+
+   template< typename Base >
+   struct Model : public Base
+   {
+      using Base::Base;
+      using Base::invoke;
+      R invoke( Op, Args... args ) const override
+      {
+         return Op::invoke( this->value_, std::forward<Args>(args)... );
+      }
+   };
+};
+
+template< typename Op, typename R, typename... Args >
+struct OpTraits<Op,R(Args...)>
+{
+   static constexpr bool modifying = true;
+
+   using Pointer = R(*)( void*, Args... );
+
+   template< typename T >
+   static R thunk( void* object, Args... args )
+   {
+      return Op::invoke( *std::launder( static_cast<T*>( object ) ), std::forward<Args>(args)... );
+   }
+
+   template< typename Base >
+   struct Concept : public Base
+   {
+      using Base::invoke;
+      virtual R invoke( Op, Args... ) = 0;
+   };
+
+   template< typename Base >
+   struct Model : public Base
+   {
+      using Base::Base;
+      using Base::invoke;
+      R invoke( Op, Args... args ) override
+      {
+         return Op::invoke( this->value_, std::forward<Args>(args)... );
+      }
+   };
+};
+
+// The operations of a virtual dispatch are stacked in a single inheritance chain, which results
+// in a single virtual pointer per object, independent of the number of operations.
+struct ConceptRoot
+{
+   virtual ~ConceptRoot() = default;
+   virtual size_t size() const = 0;
+   virtual size_t alignment() const = 0;
+   virtual void copy( void* memory ) const = 0;
+   virtual void move( void* memory ) noexcept = 0;
+
+   void invoke() const = delete;  // Anchor for the using declarations of the operations
+};
+
+template< typename Base, typename... Ops >
+struct ConceptChain
+{
+   using type = Base;
+};
+
+template< typename Base, typename Op, typename... Ops >
+struct ConceptChain<Base,Op,Ops...>
+   : public ConceptChain<typename OpTraits<Op>::template Concept<Base>,Ops...>
+{};
+
+template< typename T, typename Base >
+struct ValueHolder : public Base
+{
+   explicit ValueHolder( T value ) : value_( std::move(value) ) {}
+
+   T value_;
+};
+
+template< typename Base, typename... Ops >
+struct ModelChain
+{
+   using type = Base;
+};
+
+template< typename Base, typename Op, typename... Ops >
+struct ModelChain<Base,Op,Ops...>
+   : public ModelChain<typename OpTraits<Op>::template Model<Base>,Ops...>
+{};
+
+// The lifetime management of a concrete type for the function pointer based dispatch policies
+struct Lifetime
+{
+   size_t size;
+   size_t alignment;
+   void (*copy)( void const* src, void* dst );
+   void (*move)( void* src, void* dst ) noexcept;
+   void (*destroy)( void* object ) noexcept;
+};
+
+template< typename T >
+constexpr Lifetime lifetime{
+     sizeof(T)
+   , alignof(T)
+   , []( void const* src, void* dst ) {
+        std::construct_at( static_cast<T*>( dst ), *std::launder( static_cast<T const*>( src ) ) );
+     }
+   , []( void* src, void* dst ) noexcept {
+        T* const object( std::launder( static_cast<T*>( src ) ) );
+        std::construct_at( static_cast<T*>( dst ), std::move(*object) );
+     }
+   , []( void* object ) noexcept {
+        std::destroy_at( std::launder( static_cast<T*>( object ) ) );
+     } };
+
+template< typename... Ops >
+struct VTable
+{
+   std::tuple<typename OpTraits<Ops>::Pointer...> operations;
+   Lifetime const* lifetime;
+};
+
+template< typename T, typename... Ops >
+constexpr VTable<Ops...> vtable{
+     { &OpTraits<Ops>::template thunk<T>... }
+   , &lifetime<T> };
+
+// A function pointer based dispatch, which either stores the complete virtual function table in
+// every object (Shared=false) or only a pointer to a single, static table (Shared=true).
+template< bool Shared, typename... Ops >
+class VTableDispatcher
+{
+ public:
+   template< typename T >
+   using stored_type = T;
+
+   template< typename T >
+   explicit VTableDispatcher( std::type_identity<T> )
+      : table_( initialTable<T>() )
+   {}
+
+   size_t size( void const* ) const { return table().lifetime->size; }
+   size_t alignment( void const* ) const { return table().lifetime->alignment; }
+   void copy( void const* src, void* dst ) const { table().lifetime->copy( src, dst ); }
+   void move( void* src, void* dst ) const noexcept { table().lifetime->move( src, dst ); }
+   void destroy( void* object ) const noexcept { table().lifetime->destroy( object ); }
+
+   template< typename Op, typename Object, typename... Args >
+   decltype(auto) invoke( Object* object, Args&&... args ) const
+   {
+      return std::get<indexOf<Op,Ops...>()>( table().operations )(
+         object, std::forward<Args>(args)... );
+   }
+
+ private:
+   using Table = VTable<Ops...>;
+
+   template< typename T >
+   static constexpr auto initialTable()
+   {
+      if constexpr( Shared ) return &vtable<T,Ops...>;
+      else return vtable<T,Ops...>;
+   }
+
+   Table const& table() const
+   {
+      if constexpr( Shared ) return *table_;
+      else return table_;
+   }
+
+   std::conditional_t<Shared,Table const*,Table> table_;
+};
+
+} // namespace detail
+
+
+//---- Dispatch policies --------------------------------------------------------------------------
+
+// Dispatch by means of a virtual 'Concept' base class and a 'Model' class template (the External
+// Polymorphism design pattern). The storage holds the model, including its virtual pointer.
+struct virtual_dispatch
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class virtual_dispatch::dispatcher<interface<Ops...>>
+{
+ private:
+   using Concept = typename detail::ConceptChain<detail::ConceptRoot,Ops...>::type;
+
+   template< typename T >
+   struct Model final
+      : public detail::ModelChain<detail::ValueHolder<T,Concept>,Ops...>::type
+   {
+      using Base = typename detail::ModelChain<detail::ValueHolder<T,Concept>,Ops...>::type;
+      using Base::Base;
+
+      size_t size() const override { return sizeof(Model); }
+      size_t alignment() const override { return alignof(Model); }
+
+      void copy( void* memory ) const override
+      {
+         std::construct_at( static_cast<Model*>( memory ), *this );
+      }
+
+      void move( void* memory ) noexcept override
+      {
+         std::construct_at( static_cast<Model*>( memory ), std::move(*this) );
+      }
+   };
+
+   static Concept const* toConcept( void const* object )
+   {
+      return std::launder( reinterpret_cast<Concept const*>( object ) );
+   }
+
+   static Concept* toConcept( void* object )
+   {
+      return std::launder( reinterpret_cast<Concept*>( object ) );
+   }
+
+ public:
+   template< typename T >
+   using stored_type = Model<T>;
+
+   template< typename T >
+   explicit dispatcher( std::type_identity<T> ) {}
+
+   size_t size( void const* object ) const { return toConcept( object )->size(); }
+   size_t alignment( void const* object ) const { return toConcept( object )->alignment(); }
+   void copy( void const* src, void* dst ) const { toConcept( src )->copy( dst ); }
+   void move( void* src, void* dst ) const noexcept { toConcept( src )->move( dst ); }
+   void destroy( void* object ) const noexcept { std::destroy_at( toConcept( object ) ); }
+
+   template< typename Op, typename Object, typename... Args >
+   decltype(auto) invoke( Object* object, Args&&... args ) const
+   {
+      return toConcept( object )->invoke( Op{}, std::forward<Args>(args)... );
+   }
+};
+
+// Dispatch by means of function pointers stored inside every object. This avoids the indirection
+// via a virtual function table, but every operation increases the size of the objects. The
+// functions for the lifetime management are shared in a static table.
+struct inline_vtable
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class inline_vtable::dispatcher<interface<Ops...>>
+   : public detail::VTableDispatcher<false,Ops...>
+{
+ public:
+   using detail::VTableDispatcher<false,Ops...>::VTableDispatcher;
+};
+
+// Dispatch by means of a single, static constexpr virtual function table per concrete type. Every
+// object stores a single pointer to this table, independent of the number of operations.
+struct shared_vtable
+{
+   template< typename Interface >
+   class dispatcher;
+};
+
+template< typename... Ops >
+class shared_vtable::dispatcher<interface<Ops...>>
+   : public detail::VTableDispatcher<true,Ops...>
+{
+ public:
+   using detail::VTableDispatcher<true,Ops...>::VTableDispatcher;
+};
+
+
+//---- Storage policies ---------------------------------------------------------------------------
+
+// Stores the object on the heap. A moved-from object is empty.
+class heap_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      void* const memory( detail::allocate( sizeof(Stored), alignof(Stored) ) );
+      try {
+         object_ = std::construct_at( static_cast<Stored*>( memory ), std::forward<Args>(args)... );
+      }
+      catch( ... ) {
+         detail::deallocate( memory, sizeof(Stored), alignof(Stored) );
+         throw;
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( heap_storage const& other, Dispatcher const& dispatcher )
+   {
+      size_t const size( dispatcher.size( other.object_ ) );
+      size_t const alignment( dispatcher.alignment( other.object_ ) );
+      void* const memory( detail::allocate( size, alignment ) );
+      try {
+         dispatcher.copy( other.object_, memory );
+      }
+      catch( ... ) {
+         detail::deallocate( memory, size, alignment );
+         throw;
+      }
+      object_ = memory;
+   }
+
+   template< typename Dispatcher >
+   void move( heap_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = std::exchange( other.object_, nullptr );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( !object_ ) return;
+      size_t const size( dispatcher.size( object_ ) );
+      size_t const alignment( dispatcher.alignment( object_ ) );
+      dispatcher.destroy( object_ );
+      detail::deallocate( object_, size, alignment );
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return object_; }
+
+ private:
+   void* object_{};
+};
+
+// Stores the object in an in-class buffer. Objects that do not fit into the buffer are rejected
+// at compile time, i.e. the storage never allocates dynamic memory.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class sbo_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      static_assert( sizeof(Stored) <= Capacity, "Given type is too large" );
+      static_assert( Alignment % alignof(Stored) == 0U, "Given type is misaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Stored>, "Given type is not movable" );
+
+      std::construct_at( reinterpret_cast<Stored*>( buffer_.data() ), std::forward<Args>(args)... );
+   }
+
+   template< typename Dispatcher >
+   void copy( sbo_storage const& other, Dispatcher const& dispatcher )
+   {
+      dispatcher.copy( other.buffer_.data(), buffer_.data() );
+   }
+
+   template< typename Dispatcher >
+   void move( sbo_storage& other, Dispatcher const& dispatcher ) noexcept
+   {
+      dispatcher.move( other.buffer_.data(), buffer_.data() );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      dispatcher.destroy( buffer_.data() );
+   }
+
+   void const* get() const { return buffer_.data(); }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return buffer_.data(); }
+
+ private:
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+// Stores a trivially copyable object (e.g. a pair of pointers) in an in-class buffer. Copies are
+// plain copies of the buffer and no destructor has to be called, i.e. the lifetime management
+// does not require any indirect function call.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class trivial_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      static_assert( sizeof(Stored) <= Capacity, "Given type is too large" );
+      static_assert( Alignment % alignof(Stored) == 0U, "Given type is misaligned" );
+      static_assert( std::is_trivially_copyable_v<Stored>, "Given type is not trivially copyable" );
+
+      std::construct_at( reinterpret_cast<Stored*>( buffer_.data() ), std::forward<Args>(args)... );
+   }
+
+   template< typename Dispatcher >
+   void copy( trivial_storage const& other, Dispatcher const& ) noexcept
+   {
+      buffer_ = other.buffer_;
+   }
+
+   template< typename Dispatcher >
+   void move( trivial_storage& other, Dispatcher const& ) noexcept
+   {
+      buffer_ = other.buffer_;
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& ) noexcept {}
+
+   void const* get() const { return buffer_.data(); }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return buffer_.data(); }
+
+ private:
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+// Stores the object in an in-class buffer if it fits and else on the heap. In contrast to the
+// pure in-class buffer, the storage has to remember where the object is located.
+template< size_t Capacity, size_t Alignment = alignof(void*) >
+class sbo_fallback_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      if constexpr( fitsInline<Stored> ) {
+         object_ = std::construct_at( reinterpret_cast<Stored*>( buffer_.data() )
+                                    , std::forward<Args>(args)... );
+      }
+      else {
+         void* const memory( detail::allocate( sizeof(Stored), alignof(Stored) ) );
+         try {
+            object_ = std::construct_at( static_cast<Stored*>( memory )
+                                       , std::forward<Args>(args)... );
+         }
+         catch( ... ) {
+            detail::deallocate( memory, sizeof(Stored), alignof(Stored) );
+            throw;
+         }
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( sbo_fallback_storage const& other, Dispatcher const& dispatcher )
+   {
+      if( other.isInline() ) {
+         dispatcher.copy( other.object_, buffer_.data() );
+         object_ = buffer_.data();
+      }
+      else {
+         size_t const size( dispatcher.size( other.object_ ) );
+         size_t const alignment( dispatcher.alignment( other.object_ ) );
+         void* const memory( detail::allocate( size, alignment ) );
+         try {
+            dispatcher.copy( other.object_, memory );
+         }
+         catch( ... ) {
+            detail::deallocate( memory, size, alignment );
+            throw;
+         }
+         object_ = memory;
+      }
+   }
+
+   template< typename Dispatcher >
+   void move( sbo_fallback_storage& other, Dispatcher const& dispatcher ) noexcept
+   {
+      if( other.isInline() ) {
+         dispatcher.move( other.object_, buffer_.data() );
+         object_ = buffer_.data();
+      }
+      else {
+         object_ = std::exchange( other.object_, nullptr );
+      }
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( !object_ ) return;
+      if( isInline() ) {
+         dispatcher.destroy( object_ );
+      }
+      else {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         dispatcher.destroy( object_ );
+         detail::deallocate( object_, size, alignment );
+      }
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& ) { return object_; }
+
+ private:
+   template< typename Stored >
+   static constexpr bool fitsInline =
+      sizeof(Stored) <= Capacity && Alignment % alignof(Stored) == 0U &&
+      std::is_nothrow_move_constructible_v<Stored>;
+
+   bool isInline() const { return object_ == static_cast<void const*>( buffer_.data() ); }
+
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+   void* object_{};
+};
+
+// Refers to an object without owning it. It is the responsibility of the user to guarantee that
+// the referenced object outlives all references to it. Since the referenced object is not part
+// of the storage, this policy requires a function pointer based dispatch, and since the object
+// is referenced as const, it only supports non-modifying operations.
+class non_owning_storage
+{
+ public:
+   template< typename Stored, typename T >
+   void create( T const& object )
+   {
+      static_assert( std::is_same_v<Stored,T>, "Non-owning storage requires a vtable dispatch" );
+      object_ = std::addressof( object );
+   }
+
+   template< typename Stored, typename T >
+   void create( T const&& ) = delete;  // Binding a temporary would result in a dangling reference
+
+   template< typename Dispatcher >
+   void copy( non_owning_storage const& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+   }
+
+   template< typename Dispatcher >
+   void move( non_owning_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& ) noexcept {}
+
+   void const* get() const { return object_; }
+
+ private:
+   void const* object_{};
+};
+
+// Stores the object on the heap and shares it between all copies (copy-on-write). The reference
+// count is placed in front of the object within the same allocation. Modifying operations first
+// create an exclusive copy of a shared object.
+class cow_storage
+{
+ public:
+   template< typename Stored, typename... Args >
+   void create( Args&&... args )
+   {
+      void* const memory( allocate( sizeof(Stored), alignof(Stored) ) );
+      try {
+         object_ = std::construct_at( static_cast<Stored*>( memory ), std::forward<Args>(args)... );
+      }
+      catch( ... ) {
+         deallocate( memory, sizeof(Stored), alignof(Stored) );
+         throw;
+      }
+   }
+
+   template< typename Dispatcher >
+   void copy( cow_storage const& other, Dispatcher const& ) noexcept
+   {
+      object_ = other.object_;
+      counter( object_ ).fetch_add( 1U, std::memory_order_relaxed );
+   }
+
+   template< typename Dispatcher >
+   void move( cow_storage& other, Dispatcher const& ) noexcept
+   {
+      object_ = std::exchange( other.object_, nullptr );
+   }
+
+   template< typename Dispatcher >
+   void destroy( Dispatcher const& dispatcher ) noexcept
+   {
+      if( object_ && counter( object_ ).fetch_sub( 1U, std::memory_order_acq_rel ) == 1U ) {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         dispatcher.destroy( object_ );
+         deallocate( object_, size, alignment );
+      }
+   }
+
+   void const* get() const { return object_; }
+
+   template< typename Dispatcher >
+   void* getMutable( Dispatcher const& dispatcher )
+   {
+      if( counter( object_ ).load( std::memory_order_acquire ) > 1U ) {
+         size_t const size( dispatcher.size( object_ ) );
+         size_t const alignment( dispatcher.alignment( object_ ) );
+         void* const memory( allocate( size, alignment ) );
+         try {
+            dispatcher.copy( object_, memory );
+         }
+         catch( ... ) {
+            deallocate( memory, size, alignment );
+            throw;
+         }
+         destroy( dispatcher );
+         object_ = memory;
+      }
+      return object_;
+   }
+
+   bool isShared() const
+   {
+      return object_ && counter( object_ ).load( std::memory_order_relaxed ) > 1U;
+   }
+
+ private:
+   using Counter = std::atomic<size_t>;
+
+   static size_t blockAlignment( size_t alignment )
+   {
+      return std::max( alignment, alignof(Counter) );
+   }
+
+   static size_t headerSize( size_t alignment )
+   {
+      size_t const a( blockAlignment( alignment ) );
+      return ( sizeof(Counter) + a - 1U ) / a * a;
+   }
+
+   static Counter& counter( void const* object )
+   {
+      std::byte* const bytes( static_cast<std::byte*>( const_cast<void*>( object ) ) );
+      return *std::launder( reinterpret_cast<Counter*>( bytes - sizeof(Counter) ) );
+   }
+
+   // Allocates a block for the reference count and the object and returns the object address
+   static void* allocate( size_t size, size_t alignment )
+   {
+      size_t const header( headerSize( alignment ) );
+      void* const memory( detail::allocate( header + size, blockAlignment( alignment ) ) );
+      std::byte* const block( static_cast<std::byte*>( memory ) );
+      std::construct_at( reinterpret_cast<Counter*>( block + header - sizeof(Counter) ), 1U );
+      return block + header;
+   }
+
+   static void deallocate( void* object, size_t size, size_t alignment ) noexcept
+   {
+      size_t const header( headerSize( alignment ) );
+      std::destroy_at( &counter( object ) );
+      detail::deallocate( static_cast<std::byte*>( object ) - header
+                        , header + size, blockAlignment( alignment ) );
+   }
+
+   void* object_{};
+};
+
+
+//---- The type-erased wrapper --------------------------------------------------------------------
+
+// A value type for all types that provide the operations of the given interface. How the
+// object is stored is determined by the 'Storage' policy, how the operations are dispatched
+// is determined by the 'Dispatch' policy. The default combination corresponds to the classic
+// Type Erasure implementation based on std::unique_ptr and a virtual 'Concept' base class.
+template< typename Interface
+        , typename Storage = heap_storage
+        , typename Dispatch = virtual_dispatch >
+class erased
+{
+ private:
+   using Dispatcher = typename Dispatch::template dispatcher<Interface>;
+
+ public:
+   template< typename T >
+      requires ( !std::is_same_v<std::remove_cvref_t<T>,erased> )
+   explicit erased( T&& value )
+      : dispatcher_( std::type_identity<std::remove_cvref_t<T>>{} )
+   {
+      using Stored = typename Dispatcher::template stored_type<std::remove_cvref_t<T>>;
+      storage_.template create<Stored>( std::forward<T>(value) );
+   }
+
+   erased( erased const& other )
+      : dispatcher_( other.dispatcher_ )
+   {
+      storage_.copy( other.storage_, dispatcher_ );
+   }
+
+   erased& operator=( erased const& other )
+   {
+      if( this != &other ) {
+         erased copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   erased( erased&& other ) noexcept
+      : dispatcher_( other.dispatcher_ )
+   {
+      storage_.move( other.storage_, dispatcher_ );
+   }
+
+   erased& operator=( erased&& other ) noexcept
+   {
+      if( this != &other ) {
+         storage_.destroy( dispatcher_ );
+         dispatcher_ = other.dispatcher_;
+         storage_.move( other.storage_, dispatcher_ );
+      }
+      return *this;
+   }
+
+   ~erased()
+   {
+      storage_.destroy( dispatcher_ );
+   }
+
+   template< typename Op, typename... Args >
+   decltype(auto) call( Args&&... args ) const
+   {
+      static_assert( !detail::OpTraits<Op>::modifying, "Modifying operation on a const object" );
+      return dispatcher_.template invoke<Op>( storage_.get(), std::forward<Args>(args)... );
+   }
+
+   template< typename Op, typename... Args >
+   decltype(auto) call( Args&&... args )
+   {
+      if constexpr( detail::OpTraits<Op>::modifying ) {
+         return dispatcher_.template invoke<Op>(
+            storage_.getMutable( dispatcher_ ), std::forward<Args>(args)... );
+      }
+      else {
+         return std::as_const(*this).template call<Op>( std::forward<Args>(args)... );
+      }
+   }
+
+   Storage const& storage() const { return storage_; }
+
+ private:
+   [[no_unique_address]] Dispatcher dispatcher_;
+   Storage storage_;
+};
+
+} // namespace erasure
+
+
+//---- Generated Type Erasure wrappers ------------------------------------------------------------
+
+namespace generated {
+
+struct Draw
+{
+   using signature = void() const;
+
+   template< typename T >
+   static void invoke( T const& drawing ) { drawing.draw(); }
+};
+
+struct Scale
+{
+   using signature = void( double );
+
+   template< typename T >
+   static void invoke( T& drawing, double factor ) { drawing.scale( factor ); }
+};
+
+struct Price
+{
+   using signature = Money() const;
+
+   template< typename T >
+   static Money invoke( T const& item ) { return item.price(); }
+};
+
+template< typename ShapeT, typename DrawStrategy >
+struct Drawing
+{
+   void draw() const { drawer( shape ); }
+   void scale( double factor ) { shape.scale( factor ); }
+
+   ShapeT shape;
+   DrawStrategy drawer;
+};
+
+template< typename ShapeT, typename DrawStrategy >
+struct DrawingRef
+{
+   void draw() const { (*drawer)( *shape ); }
+
+   ShapeT const* shape;
+   DrawStrategy const* drawer;
+};
+
+template< typename Storage, typename Dispatch >
+class BasicShape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   BasicShape( ShapeT shape, DrawStrategy drawer )
+      : erased_( Drawing<ShapeT,DrawStrategy>{ std::move(shape), std::move(drawer) } )
+   {}
+
+ private:
+   friend void draw( BasicShape const& shape ) { shape.erased_.template call<Draw>(); }
+   friend void scale( BasicShape& shape, double f ) { shape.erased_.template call<Scale>( f ); }
+
+   erasure::erased<erasure::interface<Draw,Scale>,Storage,Dispatch> erased_;
+};
+
+using Shape = BasicShape<erasure::heap_storage,erasure::virtual_dispatch>;
+using SboShape = BasicShape<erasure::sbo_storage<32U>,erasure::virtual_dispatch>;
+using ManualShape = BasicShape<erasure::heap_storage,erasure::inline_vtable>;
+using SharedVtableShape = BasicShape<erasure::sbo_storage<32U>,erasure::shared_vtable>;
+using HybridShape = BasicShape<erasure::sbo_fallback_storage<32U>,erasure::virtual_dispatch>;
+using CowShape = BasicShape<erasure::cow_storage,erasure::shared_vtable>;
+
+class ShapeConstRef
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ShapeConstRef( ShapeT const& shape, DrawStrategy const& drawer )
+      : erased_( DrawingRef<ShapeT,DrawStrategy>{ &shape, &drawer } )
+   {}
+
+ private:
+   friend void draw( ShapeConstRef const& shape ) { shape.erased_.template call<Draw>(); }
+
+   erasure::erased<erasure::interface<Draw>
+                  ,erasure::trivial_storage<2U*sizeof(void*)>
+                  ,erasure::shared_vtable> erased_;
+};
+
+class Item
+{
+ public:
+   template< typename T >
+      requires ( !std::is_same_v<T,Item> )
+   Item( T item ) : erased_( std::move(item) ) {}
+
+   Money price() const { return erased_.template call<Price>(); }
+
+ private:
+   erasure::erased<erasure::interface<Price>> erased_;
+};
+
+} // namespace generated
+
+
+//---- Benchmarks ---------------------------------------------------------------------------------
+
+struct SceneEntry
+{
+   bool circle;
+   double size;
+};
+
+std::vector<SceneEntry> createEntries( size_t size )
+{
+   std::vector<SceneEntry> entries( size );
+   for( auto& entry : entries ) {
+      entry = SceneEntry{ coin( rng ), dist( rng ) };
+   }
+   return entries;
+}
+
+template< typename Shape >
+std::vector<Shape> createScene( std::vector<SceneEntry> const& entries )
+{
+   std::vector<Shape> scene{};
+   scene.reserve( entries.size() );
+   for( auto const& e : entries ) {
+      if( e.circle )
+         scene.emplace_back( Circle{ e.size }, circleDrawer );
+      else
+         scene.emplace_back( Square{ e.size }, squareDrawer );
+   }
+   return scene;
+}
+
+template< typename Shape >
+static void createAndDraw(benchmark::State& state)
+{
+   auto const entries( createEntries( state.range(0) ) );
+   size_t frameAllocations{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocations );
+
+      auto const scene( createScene<Shape>( entries ) );
+      for( auto const& shape : scene ) {
+         draw( shape );
+      }
+
+      frameAllocations = allocations - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/shape"] = static_cast<double>( frameAllocations ) / entries.size();
+}
+
+#define BENCHMARK_PAIR(FN,TYPE) \
+   BENCHMARK_TEMPLATE(FN,hand_written::TYPE)->RangeMultiplier(10)->Range(minSize,maxSize); \
+   BENCHMARK_TEMPLATE(FN,generated::TYPE)->RangeMultiplier(10)->Range(minSize,maxSize)
+
+#if BENCHMARK_CREATE_AND_DRAW
+BENCHMARK_PAIR(createAndDraw,Shape);
+BENCHMARK_PAIR(createAndDraw,SboShape);
+BENCHMARK_PAIR(createAndDraw,ManualShape);
+BENCHMARK_PAIR(createAndDraw,SharedVtableShape);
+BENCHMARK_PAIR(createAndDraw,HybridShape);
+BENCHMARK_PAIR(createAndDraw,CowShape);
+#endif
+
+template< typename Shape >
+static void drawAll(benchmark::State& state)
+{
+   auto const scene( createScene<Shape>( createEntries( state.range(0) ) ) );
+
+   for( auto _ : state )
+   {
+      for( auto const& shape : scene ) {
+         draw( shape );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_DRAW
+BENCHMARK_PAIR(drawAll,Shape);
+BENCHMARK_PAIR(drawAll,SboShape);
+BENCHMARK_PAIR(drawAll,ManualShape);
+BENCHMARK_PAIR(drawAll,SharedVtableShape);
+BENCHMARK_PAIR(drawAll,HybridShape);
+BENCHMARK_PAIR(drawAll,CowShape);
+#endif
+
+template< typename ShapeRef >
+static void drawRefs(benchmark::State& state)
+{
+   std::vector<Circle> circles{};
+   std::vector<Square> squares{};
+   for( auto const& e : createEntries( state.range(0) ) ) {
+      if( e.circle ) circles.emplace_back( e.size );
+      else squares.emplace_back( e.size );
+   }
+
+   std::vector<ShapeRef> refs{};
+   refs.reserve( state.range(0) );
+
+   for( auto _ : state )
+   {
+      refs.clear();
+      for( auto const& c : circles ) refs.emplace_back( c, circleDrawer );
+      for( auto const& s : squares ) refs.emplace_back( s, squareDrawer );
+      for( auto const& ref : refs ) {
+         draw( ref );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_DRAW_REFS
+BENCHMARK_PAIR(drawRefs,ShapeConstRef);
+#endif
+
+template< typename Shape >
+static void snapshotAndModify(benchmark::State& state)
+{
+   auto const scene( createScene<Shape>( createEntries( state.range(0) ) ) );
+   size_t snapshotAllocations{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocations );
+
+      std::vector<Shape> snapshot( scene );
+      for( size_t i=0U; i<snapshot.size(); i+=10U ) {
+         scale( snapshot[i], 2.0 );
+      }
+      benchmark::DoNotOptimize( snapshot.data() );
+
+      snapshotAllocations = allocations - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/shape"] = static_cast<double>( snapshotAllocations ) / scene.size();
+}
+#if BENCHMARK_SNAPSHOT_AND_MODIFY
+BENCHMARK_PAIR(snapshotAndModify,CowShape);
+#endif
+
+template< typename Item >
+static void prices(benchmark::State& state)
+{
+   std::vector<Item> items{};
+   items.reserve( state.range(0) );
+   for( int64_t i=0; i<state.range(0); ++i ) {
+      items.emplace_back( Discounted<Item>( 0.2, ConferenceTicket{ "Core C++", Money{499} } ) );
+   }
+
+   for( auto _ : state )
+   {
+      uint64_t total{};
+      for( auto const& item : items ) {
+         total += item.price().value;
+      }
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_PRICES
+BENCHMARK_PAIR(prices,Item);
+#endif
+
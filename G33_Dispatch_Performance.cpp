@@ -0,0 +1,877 @@
+/**************************************************************************************************
+*
+* \file G33_Dispatch_Performance.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Benchmark the time to draw all shapes of a scene for every Shape design of the examples:
+* enum-based switch, tagged shape record, virtual functions, Cyclic Visitor, std::variant,
+* Acyclic Visitor, classic Strategy, std::function Strategy, Type Erasure, Type Erasure with
+* SBO, Type Erasure with manual virtual dispatch and the type-sorted ShapeStore. The scenes
+* contain 10^2 to 10^7 shapes, either only circles ('uniform') or a random mix of circles and
+* squares ('random'), in either sorted or shuffled order. In addition to the time per shape,
+* the benchmark reports the dynamic memory per shape. Cache misses can be reported via
+*
+*    ./G33_Dispatch_Performance --benchmark_perf_counters=CACHE-MISSES
+*
+* in case Google Benchmark has been built with support for libpfm.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr int64_t minSize( 100 );       // Minimum number of shapes in the generated scenes
+constexpr int64_t maxSize( 10000000 );  // Maximum number of shapes in the generated scenes
+
+#define BENCHMARK_ENUM_SWITCH         1  // Guideline 15: Procedural solution
+#define BENCHMARK_TAGGED_SHAPE        1  // Guideline 15: Tagged shape record with jump table
+#define BENCHMARK_VIRTUAL_FUNCTION    1  // Guideline 15: Object-oriented solution
+#define BENCHMARK_CYCLIC_VISITOR      1  // Guideline 16: Cyclic Visitor
+#define BENCHMARK_VARIANT             1  // Guideline 17: std::variant
+#define BENCHMARK_ACYCLIC_VISITOR     1  // Guideline 18: Acyclic Visitor
+#define BENCHMARK_STRATEGY            1  // Guideline 19: Classic Strategy
+#define BENCHMARK_FUNCTION_STRATEGY   1  // Guideline 23: std::function based Strategy
+#define BENCHMARK_TYPE_ERASURE        1  // Guideline 32: Type Erasure
+#define BENCHMARK_SBO                 1  // Guideline 33: Small Buffer Optimization
+#define BENCHMARK_MANUAL_DISPATCH     1  // Guideline 33: Manual virtual dispatch
+#define BENCHMARK_SHAPE_STORE         1  // Guideline 15: Type-sorted ShapeStore
+
+
+//---- Memory tracking ----------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the amount of dynamic memory per shape. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocatedBytes{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   allocatedBytes += bytes;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Scene generation ---------------------------------------------------------------------------
+
+enum Mix { uniformMix, randomMix };
+enum Order { sortedOrder, shuffledOrder };
+
+struct ShapeSpec
+{
+   bool isCircle;
+   double size;
+};
+
+using Scene = std::vector<ShapeSpec>;
+
+std::mt19937 rng{ 42U };
+
+// Creates a scene of the given size, sorted by type (first all circles, then all squares)
+Scene createScene( size_t size, Mix mix )
+{
+   std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+   std::bernoulli_distribution coin{};
+
+   Scene scene( size );
+   for( auto& spec : scene ) {
+      spec = ShapeSpec{ mix == uniformMix || coin( rng ), dist( rng ) };
+   }
+   std::stable_partition( begin(scene), end(scene), []( ShapeSpec s ){ return s.isCircle; } );
+   return scene;
+}
+
+
+//---- Common value types -------------------------------------------------------------------------
+
+struct Point
+{
+   double x;
+   double y;
+};
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+
+   double radius() const { return radius_; }
+   Point  center() const { return center_; }
+
+ private:
+   double radius_;
+   Point center_{};
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+
+   double side  () const { return side_; }
+   Point  center() const { return center_; }
+
+ private:
+   double side_;
+   Point center_{};
+};
+
+void draw( Circle const& c ) { benchmark::DoNotOptimize( c.radius() ); }
+void draw( Square const& s ) { benchmark::DoNotOptimize( s.side() ); }
+
+struct DrawCircle { void operator()( Circle const& c ) const { draw( c ); } };
+struct DrawSquare { void operator()( Square const& s ) const { draw( s ); } };
+
+
+//---- Generic design adaptor ---------------------------------------------------------------------
+
+// Every design provides a 'Shapes' container, a 'create()' function for a single shape or for
+// the complete scene and a 'drawAllShapes()' function. Shuffling is applied to the complete
+// container, i.e. after all shapes have been allocated in sorted order.
+template< typename Shapes, typename Create >
+Shapes createShapes( Scene const& scene, Create create )
+{
+   Shapes shapes{};
+   shapes.reserve( scene.size() );
+   for( auto const& spec : scene ) {
+      shapes.push_back( create( spec ) );
+   }
+   return shapes;
+}
+
+
+//---- Guideline 15: Procedural solution ----------------------------------------------------------
+
+struct EnumSwitch
+{
+   enum ShapeType { circle, square };
+
+   class Shape
+   {
+    protected:
+      explicit Shape( ShapeType type ) : type_( type ) {}
+    public:
+      virtual ~Shape() = default;
+      ShapeType getType() const { return type_; }
+    private:
+      ShapeType type_;
+   };
+
+   struct CircleShape : public Shape, public Circle
+   {
+      explicit CircleShape( double radius ) : Shape( circle ), Circle( radius ) {}
+   };
+
+   struct SquareShape : public Shape, public Square
+   {
+      explicit SquareShape( double side ) : Shape( square ), Square( side ) {}
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle ) return std::make_unique<CircleShape>( s.size );
+         else             return std::make_unique<SquareShape>( s.size );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         switch( shape->getType() ) {
+            case circle: draw( static_cast<CircleShape const&>( *shape ) ); break;
+            case square: draw( static_cast<SquareShape const&>( *shape ) ); break;
+         }
+      }
+   }
+};
+
+
+//---- Guideline 15: Tagged shape record ----------------------------------------------------------
+
+struct TaggedShape
+{
+   enum ShapeType { circle, square, shapeTypeCount };
+
+   class Shape
+   {
+    public:
+      Shape( Circle const& c ) : type_( circle ), circle_( c ) {}
+      Shape( Square const& s ) : type_( square ), square_( s ) {}
+
+      ShapeType getType() const { return type_; }
+      Circle const& asCircle() const { return circle_; }
+      Square const& asSquare() const { return square_; }
+
+    private:
+      ShapeType type_;
+      union {
+         Circle circle_;
+         Square square_;
+      };
+   };
+
+   using Shapes = std::vector<Shape>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> Shape {
+         if( s.isCircle ) return Circle{ s.size };
+         else             return Square{ s.size };
+      } );
+   }
+
+   static constexpr std::array<void(*)(Shape const&),shapeTypeCount> drawTable{
+      []( Shape const& shape ){ draw( shape.asCircle() ); },
+      []( Shape const& shape ){ draw( shape.asSquare() ); }
+   };
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         drawTable[shape.getType()]( shape );
+      }
+   }
+};
+
+
+//---- Guideline 15: Object-oriented solution -----------------------------------------------------
+
+struct VirtualFunction
+{
+   class Shape
+   {
+    public:
+      virtual ~Shape() = default;
+      virtual void draw() const = 0;
+   };
+
+   template< typename ShapeT >
+   class ShapeImpl : public Shape
+   {
+    public:
+      explicit ShapeImpl( double size ) : shape_( size ) {}
+      void draw() const override { ::draw( shape_ ); }
+    private:
+      ShapeT shape_;
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle ) return std::make_unique<ShapeImpl<Circle>>( s.size );
+         else             return std::make_unique<ShapeImpl<Square>>( s.size );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         shape->draw();
+      }
+   }
+};
+
+
+//---- Guideline 16: Cyclic Visitor ---------------------------------------------------------------
+
+struct CyclicVisitor
+{
+   class ShapeVisitor
+   {
+    public:
+      virtual ~ShapeVisitor() = default;
+      virtual void visit( Circle const& ) const = 0;
+      virtual void visit( Square const& ) const = 0;
+   };
+
+   class Shape
+   {
+    public:
+      virtual ~Shape() = default;
+      virtual void accept( ShapeVisitor const& v ) = 0;
+   };
+
+   template< typename ShapeT >
+   class ShapeImpl : public Shape
+   {
+    public:
+      explicit ShapeImpl( double size ) : shape_( size ) {}
+      void accept( ShapeVisitor const& v ) override { v.visit( shape_ ); }
+    private:
+      ShapeT shape_;
+   };
+
+   class Draw : public ShapeVisitor
+   {
+    public:
+      void visit( Circle const& c ) const override { draw( c ); }
+      void visit( Square const& s ) const override { draw( s ); }
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle ) return std::make_unique<ShapeImpl<Circle>>( s.size );
+         else             return std::make_unique<ShapeImpl<Square>>( s.size );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         shape->accept( Draw{} );
+      }
+   }
+};
+
+
+//---- Guideline 17: std::variant -----------------------------------------------------------------
+
+struct Variant
+{
+   struct Draw
+   {
+      void operator()( Circle const& c ) const { draw( c ); }
+      void operator()( Square const& s ) const { draw( s ); }
+   };
+
+   using Shape  = std::variant<Circle,Square>;
+   using Shapes = std::vector<Shape>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> Shape {
+         if( s.isCircle ) return Circle{ s.size };
+         else             return Square{ s.size };
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         std::visit( Draw{}, shape );
+      }
+   }
+};
+
+
+//---- Guideline 18: Acyclic Visitor --------------------------------------------------------------
+
+struct AcyclicVisitor
+{
+   class AbstractVisitor
+   {
+    public:
+      virtual ~AbstractVisitor() = default;
+   };
+
+   template< typename T >
+   class Visitor
+   {
+    protected:
+      virtual ~Visitor() = default;
+    public:
+      virtual void visit( T const& ) const = 0;
+   };
+
+   class Shape
+   {
+    public:
+      virtual ~Shape() = default;
+      virtual void accept( AbstractVisitor const& v ) = 0;
+   };
+
+   template< typename ShapeT >
+   class ShapeImpl : public Shape
+   {
+    public:
+      explicit ShapeImpl( double size ) : shape_( size ) {}
+      void accept( AbstractVisitor const& v ) override {
+         if( auto const* sv = dynamic_cast<Visitor<ShapeT> const*>(&v) ) {
+            sv->visit( shape_ );
+         }
+      }
+    private:
+      ShapeT shape_;
+   };
+
+   class Draw : public AbstractVisitor
+              , public Visitor<Circle>
+              , public Visitor<Square>
+   {
+    public:
+      void visit( Circle const& c ) const override { draw( c ); }
+      void visit( Square const& s ) const override { draw( s ); }
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle ) return std::make_unique<ShapeImpl<Circle>>( s.size );
+         else             return std::make_unique<ShapeImpl<Square>>( s.size );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         shape->accept( Draw{} );
+      }
+   }
+};
+
+
+//---- Guideline 19: Classic Strategy -------------------------------------------------------------
+
+struct Strategy
+{
+   class Shape
+   {
+    public:
+      virtual ~Shape() = default;
+      virtual void draw() const = 0;
+   };
+
+   template< typename T >
+   class DrawStrategy
+   {
+    public:
+      virtual ~DrawStrategy() = default;
+      virtual void draw( T const& ) const = 0;
+   };
+
+   template< typename T >
+   class OpenGLStrategy : public DrawStrategy<T>
+   {
+    public:
+      void draw( T const& t ) const override { ::draw( t ); }
+   };
+
+   template< typename ShapeT >
+   class ShapeImpl : public Shape
+   {
+    public:
+      ShapeImpl( double size, std::unique_ptr<DrawStrategy<ShapeT>> drawer )
+         : shape_( size ), drawer_( std::move(drawer) ) {}
+      void draw() const override { drawer_->draw( shape_ ); }
+    private:
+      ShapeT shape_;
+      std::unique_ptr<DrawStrategy<ShapeT>> drawer_;
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle )
+            return std::make_unique<ShapeImpl<Circle>>(
+               s.size, std::make_unique<OpenGLStrategy<Circle>>() );
+         else
+            return std::make_unique<ShapeImpl<Square>>(
+               s.size, std::make_unique<OpenGLStrategy<Square>>() );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         shape->draw();
+      }
+   }
+};
+
+
+//---- Guideline 23: std::function based Strategy -------------------------------------------------
+
+struct FunctionStrategy
+{
+   class Shape
+   {
+    public:
+      virtual ~Shape() = default;
+      virtual void draw() const = 0;
+   };
+
+   template< typename ShapeT >
+   class ShapeImpl : public Shape
+   {
+    public:
+      using DrawStrategy = std::function<void(ShapeT const&)>;
+
+      ShapeImpl( double size, DrawStrategy drawer )
+         : shape_( size ), drawer_( std::move(drawer) ) {}
+      void draw() const override { drawer_( shape_ ); }
+    private:
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   using Shapes = std::vector<std::unique_ptr<Shape>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> std::unique_ptr<Shape> {
+         if( s.isCircle ) return std::make_unique<ShapeImpl<Circle>>( s.size, DrawCircle{} );
+         else             return std::make_unique<ShapeImpl<Square>>( s.size, DrawSquare{} );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         shape->draw();
+      }
+   }
+};
+
+
+//---- Guideline 32: Type Erasure -----------------------------------------------------------------
+
+struct TypeErasure
+{
+   class Shape
+   {
+    public:
+      template< typename ShapeT, typename DrawStrategy >
+      Shape( ShapeT shape, DrawStrategy drawer )
+         : pimpl_( std::make_unique<Model<ShapeT,DrawStrategy>>(
+                      std::move(shape), std::move(drawer) ) )
+      {}
+
+    private:
+      friend void draw( Shape const& shape ) { shape.pimpl_->draw(); }
+
+      struct Concept
+      {
+         virtual ~Concept() = default;
+         virtual void draw() const = 0;
+      };
+
+      template< typename ShapeT, typename DrawStrategy >
+      struct Model : public Concept
+      {
+         Model( ShapeT shape, DrawStrategy drawer )
+            : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+         void draw() const override { drawer_( shape_ ); }
+         ShapeT shape_;
+         DrawStrategy drawer_;
+      };
+
+      std::unique_ptr<Concept> pimpl_;
+   };
+
+   using Shapes = std::vector<Shape>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> Shape {
+         if( s.isCircle ) return Shape( Circle{ s.size }, DrawCircle{} );
+         else             return Shape( Square{ s.size }, DrawSquare{} );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         draw( shape );
+      }
+   }
+};
+
+
+//---- Guideline 33: Small Buffer Optimization ----------------------------------------------------
+
+struct SmallBufferOptimization
+{
+   class Shape
+   {
+    public:
+      template< typename ShapeT, typename DrawStrategy >
+      Shape( ShapeT shape, DrawStrategy drawer )
+      {
+         using M = Model<ShapeT,DrawStrategy>;
+         static_assert( sizeof(M) <= Capacity && alignof(M) <= Alignment );
+         std::construct_at( static_cast<M*>( pimpl() ), std::move(shape), std::move(drawer) );
+      }
+
+      Shape( Shape&& other ) noexcept { other.pimpl()->move( pimpl() ); }
+
+      Shape& operator=( Shape&& other ) noexcept
+      {
+         Shape copy( std::move(other) );
+         buffer_.swap( copy.buffer_ );
+         return *this;
+      }
+
+      ~Shape() { std::destroy_at( pimpl() ); }
+
+    private:
+      static constexpr size_t Capacity = 48U;
+      static constexpr size_t Alignment = alignof(void*);
+
+      friend void draw( Shape const& shape ) { shape.pimpl()->draw(); }
+
+      struct Concept
+      {
+         virtual ~Concept() = default;
+         virtual void draw() const = 0;
+         virtual void move( Concept* memory ) = 0;
+      };
+
+      template< typename ShapeT, typename DrawStrategy >
+      struct Model : public Concept
+      {
+         Model( ShapeT shape, DrawStrategy drawer )
+            : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+         void draw() const override { drawer_( shape_ ); }
+         void move( Concept* memory ) override {
+            std::construct_at( static_cast<Model*>(memory), std::move(*this) );
+         }
+         ShapeT shape_;
+         DrawStrategy drawer_;
+      };
+
+      Concept*       pimpl()       { return reinterpret_cast<Concept*>( buffer_.data() ); }
+      Concept const* pimpl() const { return reinterpret_cast<Concept const*>( buffer_.data() ); }
+
+      alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+   };
+
+   using Shapes = std::vector<Shape>;
+
+   static Shapes create( Scene const& scene )
+   {
+      Shapes shapes{};
+      shapes.reserve( scene.size() );
+      for( auto const& s : scene ) {
+         if( s.isCircle ) shapes.emplace_back( Circle{ s.size }, DrawCircle{} );
+         else             shapes.emplace_back( Square{ s.size }, DrawSquare{} );
+      }
+      return shapes;
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         draw( shape );
+      }
+   }
+};
+
+
+//---- Guideline 33: Manual virtual dispatch ------------------------------------------------------
+
+struct ManualDispatch
+{
+   class Shape
+   {
+    public:
+      template< typename ShapeT, typename DrawStrategy >
+      Shape( ShapeT shape, DrawStrategy drawer )
+         : pimpl_( new Model<ShapeT,DrawStrategy>( std::move(shape), std::move(drawer) )
+                 , []( void* p ){ delete static_cast<Model<ShapeT,DrawStrategy>*>( p ); } )
+         , draw_( []( void* p ){
+              auto* const model = static_cast<Model<ShapeT,DrawStrategy>*>( p );
+              (model->drawer_)( model->shape_ ); } )
+      {}
+
+    private:
+      friend void draw( Shape const& shape ) { shape.draw_( shape.pimpl_.get() ); }
+
+      template< typename ShapeT, typename DrawStrategy >
+      struct Model
+      {
+         Model( ShapeT shape, DrawStrategy drawer )
+            : shape_( std::move(shape) ), drawer_( std::move(drawer) ) {}
+         ShapeT shape_;
+         DrawStrategy drawer_;
+      };
+
+      std::unique_ptr<void,void(*)(void*)> pimpl_;
+      void(*draw_)(void*){ nullptr };
+   };
+
+   using Shapes = std::vector<Shape>;
+
+   static Shapes create( Scene const& scene )
+   {
+      return createShapes<Shapes>( scene, []( ShapeSpec s ) -> Shape {
+         if( s.isCircle ) return Shape( Circle{ s.size }, DrawCircle{} );
+         else             return Shape( Square{ s.size }, DrawSquare{} );
+      } );
+   }
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& shape : shapes ) {
+         draw( shape );
+      }
+   }
+};
+
+
+//---- Guideline 15: Type-sorted ShapeStore -------------------------------------------------------
+
+struct ShapeStore
+{
+   // The ShapeStore is sorted by type by construction, shuffling has no effect
+   using Shapes = std::tuple<std::vector<Circle>,std::vector<Square>>;
+
+   static Shapes create( Scene const& scene )
+   {
+      auto const circles( std::count_if( begin(scene), end(scene)
+                                       , []( ShapeSpec s ){ return s.isCircle; } ) );
+
+      Shapes shapes{};
+      std::get<0>( shapes ).reserve( circles );
+      std::get<1>( shapes ).reserve( scene.size() - circles );
+      for( auto const& s : scene ) {
+         if( s.isCircle ) std::get<0>( shapes ).emplace_back( s.size );
+         else             std::get<1>( shapes ).emplace_back( s.size );
+      }
+      return shapes;
+   }
+
+   static void shuffle( Shapes& ) {}
+
+   static void drawAllShapes( Shapes const& shapes )
+   {
+      for( auto const& c : std::get<0>( shapes ) ) draw( c );
+      for( auto const& s : std::get<1>( shapes ) ) draw( s );
+   }
+};
+
+
+//---- Benchmark ----------------------------------------------------------------------------------
+
+template< typename Design >
+void shuffleShapes( typename Design::Shapes& shapes )
+{
+   if constexpr( requires { Design::shuffle( shapes ); } ) {
+      Design::shuffle( shapes );
+   }
+   else {
+      std::shuffle( begin(shapes), end(shapes), rng );
+   }
+}
+
+template< typename Design >
+static void drawAllShapes(benchmark::State& state)
+{
+   auto const size ( state.range(0) );
+   auto const mix  ( static_cast<Mix>( state.range(1) ) );
+   auto const order( static_cast<Order>( state.range(2) ) );
+
+   Scene const scene( createScene( size, mix ) );
+
+   size_t const before( allocatedBytes );
+   auto shapes( Design::create( scene ) );
+   size_t const bytes( allocatedBytes - before );
+
+   if( order == shuffledOrder ) {
+      shuffleShapes<Design>( shapes );
+   }
+
+   for( auto _ : state )
+   {
+      Design::drawAllShapes( shapes );
+   }
+
+   state.SetLabel( std::string( mix == uniformMix ? "uniform" : "random" ) + "/" +
+                   std::string( order == sortedOrder ? "sorted" : "shuffled" ) );
+   state.counters["time/shape"] = benchmark::Counter(
+      static_cast<double>( size ), benchmark::Counter::kIsIterationInvariantRate |
+                                   benchmark::Counter::kInvert );
+   state.counters["bytes/shape"] = static_cast<double>( bytes ) / size;
+}
+
+static void arguments( benchmark::internal::Benchmark* b )
+{
+   for( int64_t size=minSize; size<=maxSize; size*=10 ) {
+      for( int64_t mix : { uniformMix, randomMix } ) {
+         for( int64_t order : { sortedOrder, shuffledOrder } ) {
+            b->Args( { size, mix, order } );
+         }
+      }
+   }
+   b->ArgNames( { "shapes", "mix", "order" } );
+}
+
+#if BENCHMARK_ENUM_SWITCH
+BENCHMARK_TEMPLATE(drawAllShapes,EnumSwitch)->Apply(arguments);
+#endif
+#if BENCHMARK_TAGGED_SHAPE
+BENCHMARK_TEMPLATE(drawAllShapes,TaggedShape)->Apply(arguments);
+#endif
+#if BENCHMARK_VIRTUAL_FUNCTION
+BENCHMARK_TEMPLATE(drawAllShapes,VirtualFunction)->Apply(arguments);
+#endif
+#if BENCHMARK_CYCLIC_VISITOR
+BENCHMARK_TEMPLATE(drawAllShapes,CyclicVisitor)->Apply(arguments);
+#endif
+#if BENCHMARK_VARIANT
+BENCHMARK_TEMPLATE(drawAllShapes,Variant)->Apply(arguments);
+#endif
+#if BENCHMARK_ACYCLIC_VISITOR
+BENCHMARK_TEMPLATE(drawAllShapes,AcyclicVisitor)->Apply(arguments);
+#endif
+#if BENCHMARK_STRATEGY
+BENCHMARK_TEMPLATE(drawAllShapes,Strategy)->Apply(arguments);
+#endif
+#if BENCHMARK_FUNCTION_STRATEGY
+BENCHMARK_TEMPLATE(drawAllShapes,FunctionStrategy)->Apply(arguments);
+#endif
+#if BENCHMARK_TYPE_ERASURE
+BENCHMARK_TEMPLATE(drawAllShapes,TypeErasure)->Apply(arguments);
+#endif
+#if BENCHMARK_SBO
+BENCHMARK_TEMPLATE(drawAllShapes,SmallBufferOptimization)->Apply(arguments);
+#endif
+#if BENCHMARK_MANUAL_DISPATCH
+BENCHMARK_TEMPLATE(drawAllShapes,ManualDispatch)->Apply(arguments);
+#endif
+#if BENCHMARK_SHAPE_STORE
+BENCHMARK_TEMPLATE(drawAllShapes,ShapeStore)->Apply(arguments);
+#endif
+
@@ -0,0 +1,319 @@
+/**************************************************************************************************
+*
+* \file G33_Hybrid_Storage.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <StorageStatistics.h> ----------------------------------------------------------------------
+
+#include <cstddef>
+
+// Statistics about the storage of models: the number of models stored in the small buffer, the
+// number of models that did not fit into the buffer and were spilled to a memory resource, and
+// the total number of spilled bytes.
+struct StorageStatistics
+{
+   size_t inlined{};
+   size_t spilled{};
+   size_t spilledBytes{};
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <StorageStatistics.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+
+// A Shape, which stores its model in the small buffer if it fits and else spills it to the given
+// memory resource. By default, the spilled models are allocated on the heap. Copies and moves of
+// a shape use the memory resource of the source shape. Independent of the size of the model, a
+// moved-from shape is empty: it can be assigned to, copied, moved and destroyed, but not drawn.
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer
+        , std::pmr::memory_resource* resource = std::pmr::get_default_resource() )
+      : resource_( resource )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+      pimpl_ = create<Model>( buffer_.data(), resource_, std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : resource_( other.resource_ )
+      , pimpl_( other.pimpl_ ? other.pimpl_->clone( buffer_.data(), resource_ ) : nullptr )
+   {}
+
+   Shape& operator=( Shape const& other )
+   {
+      if( this != &other ) {
+         Shape copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : resource_( other.resource_ )
+   {
+      takeOver( other );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      if( this != &other ) {
+         reset();
+         resource_ = other.resource_;  // A spilled model belongs to the resource of the other shape
+         takeOver( other );
+      }
+      return *this;
+   }
+
+   ~Shape()
+   {
+      reset();
+   }
+
+   static StorageStatistics statistics()
+   {
+      return StorageStatistics{ inlined_.load( std::memory_order_relaxed )
+                              , spilled_.load( std::memory_order_relaxed )
+                              , spilledBytes_.load( std::memory_order_relaxed ) };
+   }
+
+   static void resetStatistics()
+   {
+      inlined_.store( 0U, std::memory_order_relaxed );
+      spilled_.store( 0U, std::memory_order_relaxed );
+      spilledBytes_.store( 0U, std::memory_order_relaxed );
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   struct Concept  // The External Polymorphism design pattern
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual Concept* clone( std::byte* buffer, std::pmr::memory_resource* resource ) const = 0;
+
+      // Moves an inline model into the given buffer and destroys the source, whereas a spilled
+      // model is taken over as is. In both cases, the source must not be used anymore.
+      virtual Concept* move( std::byte* buffer ) noexcept = 0;
+      virtual void destroy( std::pmr::memory_resource* resource ) noexcept = 0;
+   };
+
+   template< typename Model >
+   static constexpr bool fitsInline =
+      sizeof(Model) <= Capacity && Alignment % alignof(Model) == 0U &&
+      std::is_nothrow_move_constructible_v<Model>;
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct OwningModel : public Concept
+   {
+      OwningModel( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      void draw() const override
+      {
+         drawer_( shape_ );
+      }
+
+      Concept* clone( std::byte* buffer, std::pmr::memory_resource* resource ) const override
+      {
+         return create<OwningModel>( buffer, resource, *this );
+      }
+
+      Concept* move( std::byte* buffer ) noexcept override
+      {
+         if constexpr( fitsInline<OwningModel> ) {
+            OwningModel* const model(
+               std::construct_at( reinterpret_cast<OwningModel*>( buffer ), std::move(*this) ) );
+            std::destroy_at( this );
+            return model;
+         }
+         else {
+            return this;
+         }
+      }
+
+      void destroy( std::pmr::memory_resource* resource ) noexcept override
+      {
+         if constexpr( fitsInline<OwningModel> ) {
+            std::destroy_at( this );
+         }
+         else {
+            void* const memory( this );
+            std::destroy_at( this );
+            resource->deallocate( memory, sizeof(OwningModel), alignof(OwningModel) );
+         }
+      }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   // Creates a model either in the given buffer or by means of the given memory resource
+   template< typename Model, typename... Args >
+   static Concept* create( std::byte* buffer, std::pmr::memory_resource* resource, Args&&... args )
+   {
+      if constexpr( fitsInline<Model> ) {
+         Model* const model(
+            std::construct_at( reinterpret_cast<Model*>( buffer ), std::forward<Args>(args)... ) );
+         inlined_.fetch_add( 1U, std::memory_order_relaxed );
+         return model;
+      }
+      else {
+         void* const memory( resource->allocate( sizeof(Model), alignof(Model) ) );
+         Model* model{};
+         try {
+            model = std::construct_at( static_cast<Model*>( memory ), std::forward<Args>(args)... );
+         }
+         catch( ... ) {
+            resource->deallocate( memory, sizeof(Model), alignof(Model) );
+            throw;
+         }
+         spilled_.fetch_add( 1U, std::memory_order_relaxed );
+         spilledBytes_.fetch_add( sizeof(Model), std::memory_order_relaxed );
+         return model;
+      }
+   }
+
+   void takeOver( Shape& other ) noexcept
+   {
+      pimpl_ = other.pimpl_ ? other.pimpl_->move( buffer_.data() ) : nullptr;
+      other.pimpl_ = nullptr;
+   }
+
+   void reset() noexcept
+   {
+      if( pimpl_ ) pimpl_->destroy( resource_ );
+      pimpl_ = nullptr;
+   }
+
+   static inline std::atomic<size_t> inlined_{};
+   static inline std::atomic<size_t> spilled_{};
+   static inline std::atomic<size_t> spilledBytes_{};
+
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+   std::pmr::memory_resource* resource_{};
+   Concept* pimpl_{};
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+int main()
+{
+   using SmallShape = Shape<32U>;
+
+   // A stateless drawing strategy, which fits into the small buffer
+   auto drawer = []( Circle const& c ){ /*...*/ };
+
+   // A drawing strategy with some more state, which does not fit into the small buffer
+   std::array<double,4> color{ 0.2, 0.4, 0.6, 1.0 };
+   auto colorDrawer = [color]( Square const& s ){ /*...*/ };
+
+   // The spilled models are allocated from a monotonic buffer
+   std::array<std::byte,1000> raw;  // Note: not initialized!
+   std::pmr::monotonic_buffer_resource buffer{
+      raw.data(), raw.size(), std::pmr::null_memory_resource() };
+
+   std::vector<SmallShape> shapes{};
+   shapes.emplace_back( Circle{ 3.14 }, drawer );
+   shapes.emplace_back( Square{ 1.2 }, colorDrawer, &buffer );
+   shapes.emplace_back( Circle{ 4.1 }, drawer );
+
+   // Copying a spilled shape allocates from the same memory resource
+   shapes.push_back( shapes[1] );
+
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+
+   StorageStatistics const statistics( SmallShape::statistics() );
+   std::cout << "Inlined models: " << statistics.inlined << '\n'
+             << "Spilled models: " << statistics.spilled
+             << " (" << statistics.spilledBytes << " bytes)\n";
+
+   // Moving a spilled shape twice: the first move takes over the model and leaves an empty
+   // shape behind, which can again be moved, copied and assigned to
+   SmallShape moved( std::move(shapes[1]) );
+   SmallShape empty( std::move(shapes[1]) );
+   SmallShape copy( shapes[1] );
+   shapes[1] = std::move(moved);
+   draw( shapes[1] );
+
+   // Neither moving nor copying an empty shape creates a model
+   StorageStatistics const after( SmallShape::statistics() );
+
+   return ( after.spilled == statistics.spilled && after.inlined == statistics.inlined )
+          ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
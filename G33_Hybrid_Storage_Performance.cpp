@@ -0,0 +1,350 @@
+/**************************************************************************************************
+*
+* \file G33_Hybrid_Storage_Performance.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to create and
+* draw shapes with hybrid storage for different small buffer capacities. Half of the shapes use
+* a drawing strategy with additional state. The 'spilled' counter reports the fraction of models
+* that did not fit into the small buffer, which enables to tune the capacity for a given scene.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_DEFAULT_RESOURCE   1  // Spilled models are allocated on the heap
+#define BENCHMARK_MONOTONIC_RESOURCE 1  // Spilled models are allocated from a monotonic buffer
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+struct SceneEntry
+{
+   bool colored;
+   double radius;
+};
+
+std::vector<SceneEntry> createScene( size_t size )
+{
+   std::vector<SceneEntry> scene( size );
+   for( auto& entry : scene ) {
+      entry = SceneEntry{ coin( rng ), dist( rng ) };
+   }
+   return scene;
+}
+
+
+//---- Hybrid storage -----------------------------------------------------------------------------
+
+// Statistics about the storage of models: the number of models stored in the small buffer, the
+// number of models that did not fit into the buffer and were spilled to a memory resource, and
+// the total number of spilled bytes.
+struct StorageStatistics
+{
+   size_t inlined{};
+   size_t spilled{};
+   size_t spilledBytes{};
+};
+
+// A Shape, which stores its model in the small buffer if it fits and else spills it to the given
+// memory resource. By default, the spilled models are allocated on the heap. Copies and moves of
+// a shape use the memory resource of the source shape. Independent of the size of the model, a
+// moved-from shape is empty: it can be assigned to, copied, moved and destroyed, but not drawn.
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer
+        , std::pmr::memory_resource* resource = std::pmr::get_default_resource() )
+      : resource_( resource )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+      pimpl_ = create<Model>( buffer_.data(), resource_, std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : resource_( other.resource_ )
+      , pimpl_( other.pimpl_ ? other.pimpl_->clone( buffer_.data(), resource_ ) : nullptr )
+   {}
+
+   Shape& operator=( Shape const& other )
+   {
+      if( this != &other ) {
+         Shape copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : resource_( other.resource_ )
+   {
+      takeOver( other );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      if( this != &other ) {
+         reset();
+         resource_ = other.resource_;  // A spilled model belongs to the resource of the other shape
+         takeOver( other );
+      }
+      return *this;
+   }
+
+   ~Shape()
+   {
+      reset();
+   }
+
+   static StorageStatistics statistics()
+   {
+      return StorageStatistics{ inlined_.load( std::memory_order_relaxed )
+                              , spilled_.load( std::memory_order_relaxed )
+                              , spilledBytes_.load( std::memory_order_relaxed ) };
+   }
+
+   static void resetStatistics()
+   {
+      inlined_.store( 0U, std::memory_order_relaxed );
+      spilled_.store( 0U, std::memory_order_relaxed );
+      spilledBytes_.store( 0U, std::memory_order_relaxed );
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   struct Concept  // The External Polymorphism design pattern
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual Concept* clone( std::byte* buffer, std::pmr::memory_resource* resource ) const = 0;
+
+      // Moves an inline model into the given buffer and destroys the source, whereas a spilled
+      // model is taken over as is. In both cases, the source must not be used anymore.
+      virtual Concept* move( std::byte* buffer ) noexcept = 0;
+      virtual void destroy( std::pmr::memory_resource* resource ) noexcept = 0;
+   };
+
+   template< typename Model >
+   static constexpr bool fitsInline =
+      sizeof(Model) <= Capacity && Alignment % alignof(Model) == 0U &&
+      std::is_nothrow_move_constructible_v<Model>;
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct OwningModel : public Concept
+   {
+      OwningModel( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      void draw() const override
+      {
+         drawer_( shape_ );
+      }
+
+      Concept* clone( std::byte* buffer, std::pmr::memory_resource* resource ) const override
+      {
+         return create<OwningModel>( buffer, resource, *this );
+      }
+
+      Concept* move( std::byte* buffer ) noexcept override
+      {
+         if constexpr( fitsInline<OwningModel> ) {
+            OwningModel* const model(
+               std::construct_at( reinterpret_cast<OwningModel*>( buffer ), std::move(*this) ) );
+            std::destroy_at( this );
+            return model;
+         }
+         else {
+            return this;
+         }
+      }
+
+      void destroy( std::pmr::memory_resource* resource ) noexcept override
+      {
+         if constexpr( fitsInline<OwningModel> ) {
+            std::destroy_at( this );
+         }
+         else {
+            void* const memory( this );
+            std::destroy_at( this );
+            resource->deallocate( memory, sizeof(OwningModel), alignof(OwningModel) );
+         }
+      }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   // Creates a model either in the given buffer or by means of the given memory resource
+   template< typename Model, typename... Args >
+   static Concept* create( std::byte* buffer, std::pmr::memory_resource* resource, Args&&... args )
+   {
+      if constexpr( fitsInline<Model> ) {
+         Model* const model(
+            std::construct_at( reinterpret_cast<Model*>( buffer ), std::forward<Args>(args)... ) );
+         inlined_.fetch_add( 1U, std::memory_order_relaxed );
+         return model;
+      }
+      else {
+         void* const memory( resource->allocate( sizeof(Model), alignof(Model) ) );
+         Model* model{};
+         try {
+            model = std::construct_at( static_cast<Model*>( memory ), std::forward<Args>(args)... );
+         }
+         catch( ... ) {
+            resource->deallocate( memory, sizeof(Model), alignof(Model) );
+            throw;
+         }
+         spilled_.fetch_add( 1U, std::memory_order_relaxed );
+         spilledBytes_.fetch_add( sizeof(Model), std::memory_order_relaxed );
+         return model;
+      }
+   }
+
+   void takeOver( Shape& other ) noexcept
+   {
+      pimpl_ = other.pimpl_ ? other.pimpl_->move( buffer_.data() ) : nullptr;
+      other.pimpl_ = nullptr;
+   }
+
+   void reset() noexcept
+   {
+      if( pimpl_ ) pimpl_->destroy( resource_ );
+      pimpl_ = nullptr;
+   }
+
+   static inline std::atomic<size_t> inlined_{};
+   static inline std::atomic<size_t> spilled_{};
+   static inline std::atomic<size_t> spilledBytes_{};
+
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+   std::pmr::memory_resource* resource_{};
+   Concept* pimpl_{};
+};
+
+
+//---- Benchmark ----------------------------------------------------------------------------------
+
+template< size_t Capacity >
+void createAndDraw( std::vector<SceneEntry> const& scene, std::pmr::memory_resource* resource )
+{
+   using HybridShape = Shape<Capacity>;
+
+   // The stateless strategy requires 24 bytes, the colored strategy 40 bytes per model
+   auto drawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+   std::array<double,3> const color{ 0.2, 0.4, 0.6 };
+   auto coloredDrawer = [color]( Circle const& c ){
+      benchmark::DoNotOptimize( c.radius()*color[0] );
+   };
+
+   std::vector<HybridShape> shapes{};
+   shapes.reserve( scene.size() );
+   for( auto const& entry : scene ) {
+      if( entry.colored )
+         shapes.emplace_back( Circle{ entry.radius }, coloredDrawer, resource );
+      else
+         shapes.emplace_back( Circle{ entry.radius }, drawer, resource );
+   }
+
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+}
+
+template< size_t Capacity >
+void reportStatistics( benchmark::State& state )
+{
+   StorageStatistics const statistics( Shape<Capacity>::statistics() );
+   state.counters["spilled"] =
+      static_cast<double>( statistics.spilled ) / ( statistics.inlined + statistics.spilled );
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+
+template< size_t Capacity >
+static void defaultResource(benchmark::State& state)
+{
+   auto const scene( createScene( state.range(0) ) );
+   Shape<Capacity>::resetStatistics();
+
+   for( auto _ : state )
+   {
+      createAndDraw<Capacity>( scene, std::pmr::get_default_resource() );
+   }
+
+   reportStatistics<Capacity>( state );
+}
+#if BENCHMARK_DEFAULT_RESOURCE
+BENCHMARK_TEMPLATE(defaultResource,16)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(defaultResource,32)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(defaultResource,48)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+template< size_t Capacity >
+static void monotonicResource(benchmark::State& state)
+{
+   auto const scene( createScene( state.range(0) ) );
+   Shape<Capacity>::resetStatistics();
+
+   for( auto _ : state )
+   {
+      std::pmr::monotonic_buffer_resource resource{};
+      createAndDraw<Capacity>( scene, &resource );
+   }
+
+   reportStatistics<Capacity>( state );
+}
+#if BENCHMARK_MONOTONIC_RESOURCE
+BENCHMARK_TEMPLATE(monotonicResource,16)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(monotonicResource,32)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(monotonicResource,48)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,301 @@
+/**************************************************************************************************
+*
+* \file G33_Shared_Vtable.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <BoundingBox.h> ----------------------------------------------------------------------------
+
+struct BoundingBox
+{
+   double width;
+   double height;
+};
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+//#include <BoundingBox.h>
+#include <numbers>
+#include <ostream>
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+inline double area( Circle const& circle )
+{
+   return std::numbers::pi * circle.radius() * circle.radius();
+}
+
+inline BoundingBox boundingBox( Circle const& circle )
+{
+   return BoundingBox{ 2.0*circle.radius(), 2.0*circle.radius() };
+}
+
+inline void serialize( Circle const& circle, std::ostream& os )
+{
+   os << "circle " << circle.radius() << '\n';
+}
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+//#include <BoundingBox.h>
+#include <ostream>
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+inline double area( Square const& square )
+{
+   return square.side() * square.side();
+}
+
+inline BoundingBox boundingBox( Square const& square )
+{
+   return BoundingBox{ square.side(), square.side() };
+}
+
+inline void serialize( Square const& square, std::ostream& os )
+{
+   os << "square " << square.side() << '\n';
+}
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+//#include <BoundingBox.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+// A Shape with manual virtual dispatch. In contrast to storing all function pointers inside
+// every object, there is a single, static constexpr virtual function table per combination of
+// shape and drawing strategy, and every Shape stores only a pointer to this table and the model
+// in its small buffer. Therefore additional operations extend the virtual function table, but
+// do not increase the size of the Shape objects.
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+      : vtable_( &vtable<ShapeT,DrawStrategy> )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+
+      static_assert( sizeof(Model) <= Capacity, "Given type is too large" );
+      static_assert( alignof(Model) <= Alignment, "Given type is misaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Model>, "Given type is not movable" );
+
+      std::construct_at( reinterpret_cast<Model*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : vtable_( other.vtable_ )
+   {
+      vtable_->clone( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      if( this != &other ) {
+         Shape copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : vtable_( other.vtable_ )
+   {
+      vtable_->move( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      if( this != &other ) {
+         vtable_->destroy( buffer_.data() );
+         vtable_ = other.vtable_;
+         vtable_->move( other.buffer_.data(), buffer_.data() );
+      }
+      return *this;
+   }
+
+   ~Shape()
+   {
+      vtable_->destroy( buffer_.data() );
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.vtable_->draw( shape.buffer_.data() );
+   }
+
+   friend double area( Shape const& shape )
+   {
+      return shape.vtable_->area( shape.buffer_.data() );
+   }
+
+   friend BoundingBox boundingBox( Shape const& shape )
+   {
+      return shape.vtable_->boundingBox( shape.buffer_.data() );
+   }
+
+   friend void serialize( Shape const& shape, std::ostream& os )
+   {
+      shape.vtable_->serialize( shape.buffer_.data(), os );
+   }
+
+   template< typename ShapeT
+           , typename DrawStrategy >
+   struct OwningModel
+   {
+      OwningModel( ShapeT value, DrawStrategy drawer )
+         : shape_( std::move(value) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   struct VTable
+   {
+      void        (*draw)       ( std::byte const* );
+      double      (*area)       ( std::byte const* );
+      BoundingBox (*boundingBox)( std::byte const* );
+      void        (*serialize)  ( std::byte const*, std::ostream& );
+      void        (*clone)      ( std::byte const*, std::byte* );
+      void        (*move)       ( std::byte*, std::byte* ) noexcept;
+      void        (*destroy)    ( std::byte* ) noexcept;
+   };
+
+   template< typename Model >
+   static Model const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model const*>( bytes ) );
+   }
+
+   template< typename Model >
+   static Model& model( std::byte* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model*>( bytes ) );
+   }
+
+   template< typename ShapeT
+           , typename DrawStrategy >
+   static constexpr VTable vtable{
+        []( std::byte const* bytes ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           auto const& m = model<Model>( bytes );
+           m.drawer_( m.shape_ );
+        }
+      , []( std::byte const* bytes ) -> double {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           return area( model<Model>( bytes ).shape_ );
+        }
+      , []( std::byte const* bytes ) -> BoundingBox {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           return boundingBox( model<Model>( bytes ).shape_ );
+        }
+      , []( std::byte const* bytes, std::ostream& os ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           serialize( model<Model>( bytes ).shape_, os );
+        }
+      , []( std::byte const* src, std::byte* dst ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           std::construct_at( reinterpret_cast<Model*>( dst ), model<Model>( src ) );
+        }
+      , []( std::byte* src, std::byte* dst ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           std::construct_at( reinterpret_cast<Model*>( dst ), std::move( model<Model>( src ) ) );
+        }
+      , []( std::byte* bytes ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           std::destroy_at( &model<Model>( bytes ) );
+        } };
+
+   VTable const* vtable_;
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int main()
+{
+   // Create a drawing strategy in form of a lambda
+   auto drawer = []( auto const& shape ){ /*...*/ };
+
+   std::vector<Shape<>> shapes{};
+   shapes.emplace_back( Circle{ 3.14 }, drawer );
+   shapes.emplace_back( Square{ 2.0 }, drawer );
+   shapes.emplace_back( Circle{ 1.0 }, drawer );
+
+   // Create a copy of the shape by means of the copy constructor
+   Shape<> copy( shapes.front() );
+
+   // Each shape is as large as the buffer plus a single vtable pointer,
+   // independent of the number of operations
+   static_assert( sizeof(Shape<>) == 32U + sizeof(void*) );
+
+   double totalArea{};
+   for( auto const& shape : shapes ) {
+      draw( shape );
+      totalArea += area( shape );
+      serialize( shape, std::cout );
+   }
+
+   BoundingBox const box( boundingBox( copy ) );
+   std::cout << "Total area: " << totalArea << '\n'
+             << "Bounding box of the copy: " << box.width << 'x' << box.height << '\n';
+
+   return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,332 @@
+/**************************************************************************************************
+*
+* \file G33_Shared_Vtable_Performance.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the memory footprint and
+* the dispatch cost of manual virtual dispatch for an increasing number of operations. Compared
+* are the function pointers stored inside every object (with the model on the heap as in
+* 'G33_Manual_Virtual_Dispatch.cpp', and with the model in a small buffer) and a single pointer
+* to a shared, static virtual function table (with the model in a small buffer). The
+* 'bytes/shape' counter reports the size of a shape including its dynamic memory.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_INLINE_POINTERS_HEAP 1  // Function pointers in every object, model on the heap
+#define BENCHMARK_INLINE_POINTERS_SBO  1  // Function pointers in every object, model in a buffer
+#define BENCHMARK_SHARED_VTABLE        1  // Pointer to a shared vtable, model in a buffer
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+std::bernoulli_distribution coin{};
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the amount of dynamic memory per shape. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocatedBytes{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   allocatedBytes += bytes;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+// The I-th of a number of operations (e.g. draw, area, serialize, ...)
+template< size_t I >
+double operation( Circle const& c ) { return c.radius() * static_cast<double>( I+1U ); }
+
+template< size_t I >
+double operation( Square const& s ) { return s.side() + static_cast<double>( I ); }
+
+constexpr size_t bufferSize( 16U );
+
+
+//---- Function pointers in every object, model on the heap ---------------------------------------
+
+namespace inline_pointers_heap {
+
+template< size_t N >
+class Shape
+{
+ public:
+   template< typename ShapeT >
+   explicit Shape( ShapeT shape )
+      : pimpl_( new ShapeT( std::move(shape) )
+              , []( void* bytes ){ delete static_cast<ShapeT*>( bytes ); } )
+      , clone_( []( void* bytes ) -> void* {
+           return new ShapeT( *static_cast<ShapeT*>( bytes ) ); } )
+      , operations_( makeOperations<ShapeT>( std::make_index_sequence<N>{} ) )
+   {}
+
+   Shape( Shape const& other )
+      : pimpl_( other.clone_( other.pimpl_.get() ), other.pimpl_.get_deleter() )
+      , clone_( other.clone_ )
+      , operations_( other.operations_ )
+   {}
+
+   Shape( Shape&& ) = default;
+
+   double apply( size_t i ) const { return operations_[i]( pimpl_.get() ); }
+
+ private:
+   using Operation = double(void const*);
+
+   template< typename ShapeT, size_t... Is >
+   static std::array<Operation*,N> makeOperations( std::index_sequence<Is...> )
+   {
+      return { []( void const* bytes ) -> double {
+         return operation<Is>( *static_cast<ShapeT const*>( bytes ) ); }... };
+   }
+
+   std::unique_ptr<void,void(*)(void*)> pimpl_;
+   void* (*clone_)( void* );
+   std::array<Operation*,N> operations_;
+};
+
+} // namespace inline_pointers_heap
+
+
+//---- Function pointers in every object, model in a small buffer ---------------------------------
+
+namespace inline_pointers_sbo {
+
+template< size_t N >
+class Shape
+{
+ public:
+   template< typename ShapeT >
+   explicit Shape( ShapeT shape )
+      : clone_( []( std::byte const* src, std::byte* dst ) {
+           std::construct_at( reinterpret_cast<ShapeT*>( dst ), model<ShapeT>( src ) ); } )
+      , destroy_( []( std::byte* bytes ) {
+           std::destroy_at( std::launder( reinterpret_cast<ShapeT*>( bytes ) ) ); } )
+      , operations_( makeOperations<ShapeT>( std::make_index_sequence<N>{} ) )
+   {
+      static_assert( sizeof(ShapeT) <= bufferSize, "Given type is too large" );
+      std::construct_at( reinterpret_cast<ShapeT*>( buffer_.data() ), std::move(shape) );
+   }
+
+   Shape( Shape const& other )
+      : clone_( other.clone_ )
+      , destroy_( other.destroy_ )
+      , operations_( other.operations_ )
+   {
+      clone_( other.buffer_.data(), buffer_.data() );
+   }
+
+   ~Shape() { destroy_( buffer_.data() ); }
+
+   double apply( size_t i ) const { return operations_[i]( buffer_.data() ); }
+
+ private:
+   using Operation = double(std::byte const*);
+
+   template< typename ShapeT >
+   static ShapeT const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<ShapeT const*>( bytes ) );
+   }
+
+   template< typename ShapeT, size_t... Is >
+   static std::array<Operation*,N> makeOperations( std::index_sequence<Is...> )
+   {
+      return { []( std::byte const* bytes ) -> double {
+         return operation<Is>( model<ShapeT>( bytes ) ); }... };
+   }
+
+   void (*clone_)( std::byte const*, std::byte* );
+   void (*destroy_)( std::byte* );
+   std::array<Operation*,N> operations_;
+   alignas(double) std::array<std::byte,bufferSize> buffer_;
+};
+
+} // namespace inline_pointers_sbo
+
+
+//---- Pointer to a shared virtual function table, model in a small buffer ------------------------
+
+namespace shared_vtable {
+
+template< size_t N >
+class Shape
+{
+ public:
+   template< typename ShapeT >
+   explicit Shape( ShapeT shape )
+      : vtable_( &vtable<ShapeT> )
+   {
+      static_assert( sizeof(ShapeT) <= bufferSize, "Given type is too large" );
+      std::construct_at( reinterpret_cast<ShapeT*>( buffer_.data() ), std::move(shape) );
+   }
+
+   Shape( Shape const& other )
+      : vtable_( other.vtable_ )
+   {
+      vtable_->clone( other.buffer_.data(), buffer_.data() );
+   }
+
+   ~Shape() { vtable_->destroy( buffer_.data() ); }
+
+   double apply( size_t i ) const { return vtable_->operations[i]( buffer_.data() ); }
+
+ private:
+   using Operation = double(std::byte const*);
+
+   struct VTable
+   {
+      std::array<Operation*,N> operations;
+      void (*clone)( std::byte const*, std::byte* );
+      void (*destroy)( std::byte* );
+   };
+
+   template< typename ShapeT >
+   static ShapeT const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<ShapeT const*>( bytes ) );
+   }
+
+   template< typename ShapeT, size_t... Is >
+   static constexpr VTable makeVTable( std::index_sequence<Is...> )
+   {
+      return VTable{
+           { []( std::byte const* bytes ) -> double {
+                return operation<Is>( model<ShapeT>( bytes ) ); }... }
+         , []( std::byte const* src, std::byte* dst ) {
+              std::construct_at( reinterpret_cast<ShapeT*>( dst ), model<ShapeT>( src ) ); }
+         , []( std::byte* bytes ) {
+              std::destroy_at( std::launder( reinterpret_cast<ShapeT*>( bytes ) ) ); } };
+   }
+
+   template< typename ShapeT >
+   static constexpr VTable vtable{ makeVTable<ShapeT>( std::make_index_sequence<N>{} ) };
+
+   VTable const* vtable_;
+   alignas(double) std::array<std::byte,bufferSize> buffer_;
+};
+
+} // namespace shared_vtable
+
+
+//---- Benchmark ----------------------------------------------------------------------------------
+
+template< typename Shape >
+std::vector<Shape> createShapes( size_t size )
+{
+   std::vector<Shape> shapes{};
+   shapes.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      if( coin( rng ) )
+         shapes.emplace_back( Circle{ dist( rng ) } );
+      else
+         shapes.emplace_back( Square{ dist( rng ) } );
+   }
+   return shapes;
+}
+
+// Applies one of the 'N' operations to every shape, cycling through all operations
+template< typename Shape, size_t N >
+static void dispatch(benchmark::State& state)
+{
+   size_t const before( allocatedBytes );
+   auto const shapes( createShapes<Shape>( state.range(0) ) );
+   size_t const bytes( allocatedBytes - before );
+
+   for( auto _ : state )
+   {
+      double total{};
+      for( size_t i=0U; i<shapes.size(); ++i ) {
+         total += shapes[i].apply( i % N );
+      }
+      benchmark::DoNotOptimize( total );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["bytes/shape"] = static_cast<double>( bytes ) / shapes.size();
+}
+
+#define BENCHMARK_DISPATCH(NS,N) \
+   BENCHMARK_TEMPLATE(dispatch,NS::Shape<N>,N)->RangeMultiplier(10)->Range(minSize,maxSize)
+
+#if BENCHMARK_INLINE_POINTERS_HEAP
+BENCHMARK_DISPATCH(inline_pointers_heap,1);
+BENCHMARK_DISPATCH(inline_pointers_heap,4);
+BENCHMARK_DISPATCH(inline_pointers_heap,16);
+#endif
+
+#if BENCHMARK_INLINE_POINTERS_SBO
+BENCHMARK_DISPATCH(inline_pointers_sbo,1);
+BENCHMARK_DISPATCH(inline_pointers_sbo,4);
+BENCHMARK_DISPATCH(inline_pointers_sbo,16);
+#endif
+
+#if BENCHMARK_SHARED_VTABLE
+BENCHMARK_DISPATCH(shared_vtable,1);
+BENCHMARK_DISPATCH(shared_vtable,4);
+BENCHMARK_DISPATCH(shared_vtable,16);
+#endif
+
@@ -0,0 +1,258 @@
+/**************************************************************************************************
+*
+* \file G33_Trivial_Relocation.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// A small buffer Shape with manual virtual dispatch, which relocates trivially relocatable
+// models bitwise. A model is considered trivially relocatable if both the shape and the drawing
+// strategy are trivially copyable. This is a compile time property of the model: the static
+// virtual function table of such a model copies and moves it by means of 'memcpy()' and its
+// destroy operation is empty. Since the model itself is not polymorphic (there is no virtual
+// function table pointer inside the buffer), the bitwise copy is well-defined. 'Capacity' is the
+// size of the complete Shape, i.e. the buffer is reduced by the size of the vtable pointer,
+// such that the Shape is as large as a classic small buffer Shape with the same capacity.
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+      : vtable_( &vtable<ShapeT,DrawStrategy> )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+
+      static_assert( sizeof(Model) <= BufferSize, "Given type is too large" );
+      static_assert( alignof(Model) <= Alignment, "Given type is misaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Model>, "Given type is not movable" );
+
+      std::construct_at( reinterpret_cast<Model*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : vtable_( other.vtable_ )
+   {
+      vtable_->clone( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      if( this != &other ) {
+         Shape copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : vtable_( other.vtable_ )
+   {
+      vtable_->move( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      if( this != &other ) {
+         vtable_->destroy( buffer_.data() );
+         vtable_ = other.vtable_;
+         vtable_->move( other.buffer_.data(), buffer_.data() );
+      }
+      return *this;
+   }
+
+   ~Shape()
+   {
+      vtable_->destroy( buffer_.data() );
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.vtable_->draw( shape.buffer_.data() );
+   }
+
+   static constexpr size_t BufferSize = Capacity - sizeof(void*);
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct OwningModel
+   {
+      OwningModel( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   struct VTable
+   {
+      void (*draw)   ( std::byte const* );
+      void (*clone)  ( std::byte const*, std::byte* );
+      void (*move)   ( std::byte*, std::byte* ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename Model >
+   static Model const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model const*>( bytes ) );
+   }
+
+   template< typename Model >
+   static Model& model( std::byte* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model*>( bytes ) );
+   }
+
+   template< typename Model >
+   static constexpr bool isTriviallyRelocatable = std::is_trivially_copyable_v<Model>;
+
+   template< typename ShapeT, typename DrawStrategy >
+   static constexpr VTable vtable{
+        []( std::byte const* bytes ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           auto const& m = model<Model>( bytes );
+           m.drawer_( m.shape_ );
+        }
+      , []( std::byte const* src, std::byte* dst ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( isTriviallyRelocatable<Model> )
+              std::memcpy( dst, src, sizeof(Model) );
+           else
+              std::construct_at( reinterpret_cast<Model*>( dst ), model<Model>( src ) );
+        }
+      , []( std::byte* src, std::byte* dst ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( isTriviallyRelocatable<Model> ) {
+              std::memcpy( dst, src, sizeof(Model) );
+           }
+           else {
+              Model& m = model<Model>( src );
+              std::construct_at( reinterpret_cast<Model*>( dst ), std::move(m) );
+           }
+        }
+      , []( std::byte* bytes ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( !isTriviallyRelocatable<Model> )
+              std::destroy_at( &model<Model>( bytes ) );
+        } };
+
+   VTable const* vtable_;
+   alignas(Alignment) std::array<std::byte,BufferSize> buffer_;
+};
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <Shape.h>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+int main()
+{
+   // Create a circle as one representative of a concrete shape type
+   Circle circle{ 3.14 };
+
+   // Create a drawing strategy in form of a lambda
+   auto drawer = []( Circle const& c ){ /*...*/ };
+
+   // Combine the shape and the drawing strategy in a 'Shape' abstraction
+   // This constructor call will instantiate a 'detail::OwningShapeModel' for
+   // the given 'Circle' and lambda types
+   Shape shape1( circle, drawer );
+
+   // Draw the shape
+   draw( shape1 );
+
+   // Create a copy of the shape by means of the copy constructor
+   Shape shape2( shape1 );
+
+   // Drawing the copy will result in the same output
+   draw( shape2 );
+
+   // Since both the circle and the stateless lambda are trivially copyable, the
+   // shapes are relocated by 'memcpy()' when the vector grows
+   std::vector<Shape<>> shapes{};
+   shapes.push_back( shape1 );
+   shapes.push_back( std::move(shape2) );
+   shapes.emplace_back( Circle{ 1.0 }, drawer );
+
+   // A strategy with a std::shared_ptr member is not trivially copyable and is
+   // therefore relocated by means of its move constructor
+   auto texture = std::make_shared<int>( 42 );
+   shapes.emplace_back( Circle{ 2.0 }, [texture]( Circle const& c ){ /*...*/ } );
+
+   std::swap( shapes[0], shapes[2] );
+   std::swap( shapes[1], shapes[3] );
+
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+
+   // The vtable pointer is taken from the buffer, i.e. the Shape is not larger than requested
+   static_assert( sizeof(Shape<>) == 32U );
+
+   // All relocations of the non-trivial model kept exactly one copy of the texture alive
+   return ( texture.use_count() == 2 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,383 @@
+/**************************************************************************************************
+*
+* \file G33_Trivial_Relocation_Performance.cpp
+* \brief Guideline 33: Be Aware of the Optimization Potential of Type Erasure
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to grow a
+* std::vector of small buffer shapes by means of 'push_back()' and the time to reverse the vector
+* (i.e. to swap shapes), once for the SBO Shape that always moves models via a virtual function
+* and once for the SBO Shape with a manual virtual function table, which relocates trivially
+* copyable models by means of 'memcpy()'. Both Shapes have the same size.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_VECTOR_GROWTH  1  // Growing a std::vector of shapes without reserve()
+#define BENCHMARK_VECTOR_REVERSE 1  // Reversing a std::vector of shapes
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+std::vector<Circle> createCircles( size_t size )
+{
+   std::vector<Circle> circles{};
+   circles.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      circles.emplace_back( dist( rng ) );
+   }
+   return circles;
+}
+
+constexpr auto drawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+
+
+//---- SBO Shape with virtual move operations -----------------------------------------------------
+
+namespace sbo {
+
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+
+      static_assert( sizeof(Model) <= Capacity, "Given type is too large" );
+      static_assert( alignof(Model) <= Alignment, "Given type is misaligned" );
+
+      std::construct_at( reinterpret_cast<Model*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+   {
+      other.pimpl()->clone( buffer_.data() );
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      buffer_.swap( copy.buffer_ );
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+   {
+      other.pimpl()->move( buffer_.data() );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( std::move(other) );
+      buffer_.swap( copy.buffer_ );
+      return *this;
+   }
+
+   ~Shape()
+   {
+      std::destroy_at( pimpl() );
+      // or: pimpl()->~Concept();
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl()->draw();
+   }
+
+   struct Concept  // The External Polymorphism design pattern
+   {
+      virtual ~Concept() = default;
+      virtual void draw() const = 0;
+      virtual void clone( std::byte* memory ) const = 0;  // The Prototype design pattern
+      virtual void move( std::byte* memory ) = 0;
+   };
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct OwningModel : public Concept
+   {
+      OwningModel( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      void draw() const override
+      {
+         drawer_( shape_ );
+      }
+
+      void clone( std::byte* memory ) const override
+      {
+         std::construct_at( reinterpret_cast<OwningModel*>(memory), *this );
+
+      }
+
+      void move( std::byte* memory ) override
+      {
+         std::construct_at( reinterpret_cast<OwningModel*>(memory), std::move(*this) );
+
+      }
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   Concept* pimpl()  // The Bridge design pattern
+   {
+      return reinterpret_cast<Concept*>( buffer_.data() );
+   }
+
+   Concept const* pimpl() const
+   {
+      return reinterpret_cast<Concept const*>( buffer_.data() );
+   }
+
+   alignas(Alignment) std::array<std::byte,Capacity> buffer_;
+};
+
+} // namespace sbo
+
+
+//---- SBO Shape with trivial relocation ----------------------------------------------------------
+
+namespace relocatable {
+
+// A small buffer Shape with manual virtual dispatch, which relocates trivially relocatable
+// models bitwise. A model is considered trivially relocatable if both the shape and the drawing
+// strategy are trivially copyable. This is a compile time property of the model: the static
+// virtual function table of such a model copies and moves it by means of 'memcpy()' and its
+// destroy operation is empty. Since the model itself is not polymorphic (there is no virtual
+// function table pointer inside the buffer), the bitwise copy is well-defined. 'Capacity' is the
+// size of the complete Shape, i.e. the buffer is reduced by the size of the vtable pointer,
+// such that the Shape is as large as a classic small buffer Shape with the same capacity.
+template< size_t Capacity = 32U, size_t Alignment = alignof(void*) >
+class Shape
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+      : vtable_( &vtable<ShapeT,DrawStrategy> )
+   {
+      using Model = OwningModel<ShapeT,DrawStrategy>;
+
+      static_assert( sizeof(Model) <= BufferSize, "Given type is too large" );
+      static_assert( alignof(Model) <= Alignment, "Given type is misaligned" );
+      static_assert( std::is_nothrow_move_constructible_v<Model>, "Given type is not movable" );
+
+      std::construct_at( reinterpret_cast<Model*>( buffer_.data() )
+                       , std::move(shape), std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : vtable_( other.vtable_ )
+   {
+      vtable_->clone( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape const& other )
+   {
+      if( this != &other ) {
+         Shape copy( other );
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+
+   Shape( Shape&& other ) noexcept
+      : vtable_( other.vtable_ )
+   {
+      vtable_->move( other.buffer_.data(), buffer_.data() );
+   }
+
+   Shape& operator=( Shape&& other ) noexcept
+   {
+      if( this != &other ) {
+         vtable_->destroy( buffer_.data() );
+         vtable_ = other.vtable_;
+         vtable_->move( other.buffer_.data(), buffer_.data() );
+      }
+      return *this;
+   }
+
+   ~Shape()
+   {
+      vtable_->destroy( buffer_.data() );
+   }
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.vtable_->draw( shape.buffer_.data() );
+   }
+
+   static constexpr size_t BufferSize = Capacity - sizeof(void*);
+
+   template< typename ShapeT, typename DrawStrategy >
+   struct OwningModel
+   {
+      OwningModel( ShapeT shape, DrawStrategy drawer )
+         : shape_( std::move(shape) )
+         , drawer_( std::move(drawer) )
+      {}
+
+      ShapeT shape_;
+      DrawStrategy drawer_;
+   };
+
+   struct VTable
+   {
+      void (*draw)   ( std::byte const* );
+      void (*clone)  ( std::byte const*, std::byte* );
+      void (*move)   ( std::byte*, std::byte* ) noexcept;
+      void (*destroy)( std::byte* ) noexcept;
+   };
+
+   template< typename Model >
+   static Model const& model( std::byte const* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model const*>( bytes ) );
+   }
+
+   template< typename Model >
+   static Model& model( std::byte* bytes )
+   {
+      return *std::launder( reinterpret_cast<Model*>( bytes ) );
+   }
+
+   template< typename Model >
+   static constexpr bool isTriviallyRelocatable = std::is_trivially_copyable_v<Model>;
+
+   template< typename ShapeT, typename DrawStrategy >
+   static constexpr VTable vtable{
+        []( std::byte const* bytes ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           auto const& m = model<Model>( bytes );
+           m.drawer_( m.shape_ );
+        }
+      , []( std::byte const* src, std::byte* dst ) {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( isTriviallyRelocatable<Model> )
+              std::memcpy( dst, src, sizeof(Model) );
+           else
+              std::construct_at( reinterpret_cast<Model*>( dst ), model<Model>( src ) );
+        }
+      , []( std::byte* src, std::byte* dst ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( isTriviallyRelocatable<Model> ) {
+              std::memcpy( dst, src, sizeof(Model) );
+           }
+           else {
+              Model& m = model<Model>( src );
+              std::construct_at( reinterpret_cast<Model*>( dst ), std::move(m) );
+           }
+        }
+      , []( std::byte* bytes ) noexcept {
+           using Model = OwningModel<ShapeT,DrawStrategy>;
+           if constexpr( !isTriviallyRelocatable<Model> )
+              std::destroy_at( &model<Model>( bytes ) );
+        } };
+
+   VTable const* vtable_;
+   alignas(Alignment) std::array<std::byte,BufferSize> buffer_;
+};
+
+} // namespace relocatable
+
+
+//---- Benchmark for the vector growth ------------------------------------------------------------
+
+template< typename Shape >
+static void vectorGrowth(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+
+   for( auto _ : state )
+   {
+      std::vector<Shape> shapes{};
+      for( auto const& circle : circles ) {
+         shapes.emplace_back( circle, drawer );
+      }
+      benchmark::DoNotOptimize( shapes.data() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_VECTOR_GROWTH
+BENCHMARK_TEMPLATE(vectorGrowth,sbo::Shape<>)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(vectorGrowth,relocatable::Shape<>)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for reversing the vector ---------------------------------------------------------
+
+template< typename Shape >
+static void vectorReverse(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+
+   std::vector<Shape> shapes{};
+   shapes.reserve( circles.size() );
+   for( auto const& circle : circles ) {
+      shapes.emplace_back( circle, drawer );
+   }
+
+   for( auto _ : state )
+   {
+      std::reverse( shapes.begin(), shapes.end() );
+      benchmark::DoNotOptimize( shapes.data() );
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+#if BENCHMARK_VECTOR_REVERSE
+BENCHMARK_TEMPLATE(vectorReverse,sbo::Shape<>)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK_TEMPLATE(vectorReverse,relocatable::Shape<>)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -52,6 +52,7 @@ class Square
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace detail {
@@ -84,7 +85,7 @@ class OwningShapeModel : public ShapeConcept
       return std::make_unique<OwningShapeModel>( *this );
    }
 
-   void clone( ShapeConcept* memory ) const
+   void clone( ShapeConcept* memory ) const override
    {
       using Model = NonOwningShapeModel<ShapeT const,DrawStrategy const>;
 
@@ -113,9 +114,10 @@ class NonOwningShapeModel : public ShapeConcept
 
    void draw() const override { (*drawer_)(*shape_); }
 
+   // Creates a deep copy of the referenced shape and drawing strategy
    std::unique_ptr<ShapeConcept> clone() const override
    {
-      using Model = OwningShapeModel<ShapeT,DrawStrategy>;
+      using Model = OwningShapeModel<std::remove_cv_t<ShapeT>,std::remove_cv_t<DrawStrategy>>;
       return std::make_unique<Model>( *shape_, *drawer_ );
    }
 
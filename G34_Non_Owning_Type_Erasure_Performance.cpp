@@ -0,0 +1,391 @@
+/**************************************************************************************************
+*
+* \file G34_Non_Owning_Type_Erasure_Performance.cpp
+* \brief Guideline 34: Be Aware of the Setup Costs of Owning Type Erasure Wrappers
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to draw shapes
+* for every conversion path between the owning 'Shape' and the non-owning 'ShapeConstRef':
+*  - 'Shape' created from a concrete shape (one indirection plus the heap allocated model)
+*  - 'ShapeConstRef' created from a concrete shape (one indirection)
+*  - 'ShapeConstRef' created from a 'Shape', before and after binding the reference directly
+*    to the model: the naive binding refers to the 'Shape' by means of a drawing strategy
+*    (two indirections), the direct binding refers to the concrete shape (one indirection)
+*  - 'ShapeConstRef' copied from a 'ShapeConstRef'
+*  - 'Shape' deep-copied from a 'ShapeConstRef'
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_SHAPE_FROM_CONCRETE 1  // Shape( circle, drawer )
+#define BENCHMARK_REF_FROM_CONCRETE   1  // ShapeConstRef( circle, drawer )
+#define BENCHMARK_REF_FROM_SHAPE      1  // before: ShapeConstRef( shape, drawShape )
+                                         // after:  ShapeConstRef( shape )
+#define BENCHMARK_REF_FROM_REF        1  // ShapeConstRef( shaperef )
+#define BENCHMARK_SHAPE_FROM_REF      1  // Shape( shaperef )
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+
+//---- Shape and ShapeConstRef --------------------------------------------------------------------
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+   virtual std::unique_ptr<ShapeConcept> clone() const = 0;  // The Prototype design pattern
+   virtual void clone( ShapeConcept* memory ) const = 0;  // The Prototype design pattern
+};
+
+template< typename ShapeT, typename DrawStrategy > class NonOwningShapeModel;
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   std::unique_ptr<ShapeConcept> clone() const override  // The Prototype design pattern
+   {
+      return std::make_unique<OwningShapeModel>( *this );
+   }
+
+   // Creates a reference model, which refers directly to the shape and the drawing strategy
+   // (and not to the owning model), i.e. drawing via the reference requires one indirection
+   void clone( ShapeConcept* memory ) const override
+   {
+      using Model = NonOwningShapeModel<ShapeT const,DrawStrategy const>;
+
+      std::construct_at( static_cast<Model*>(memory), shape_, drawer_ );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class NonOwningShapeModel : public ShapeConcept
+{
+ public:
+   NonOwningShapeModel( ShapeT& shape, DrawStrategy& drawer )
+      : shape_{ std::addressof(shape) }
+      , drawer_{ std::addressof(drawer) }
+   {}
+
+   void draw() const override { (*drawer_)(*shape_); }
+
+   // Creates a deep copy of the referenced shape and drawing strategy
+   std::unique_ptr<ShapeConcept> clone() const override
+   {
+      using Model = OwningShapeModel<std::remove_cv_t<ShapeT>,std::remove_cv_t<DrawStrategy>>;
+      return std::make_unique<Model>( *shape_, *drawer_ );
+   }
+
+   void clone( ShapeConcept* memory ) const override
+   {
+      std::construct_at( static_cast<NonOwningShapeModel*>(memory), *this );
+   }
+
+ private:
+   ShapeT* shape_{ nullptr };
+   DrawStrategy* drawer_{ nullptr };
+};
+
+} // namespace detail
+
+
+class Shape;
+
+
+class ShapeConstRef
+{
+ public:
+   // Type 'ShapeT' and 'DrawStrategy' are possibly cv qualified;
+   // lvalue references prevent references to rvalues
+   template< typename ShapeT
+           , typename DrawStrategy >
+   ShapeConstRef( ShapeT& shape
+                , DrawStrategy& drawer )
+   {
+      using Model =
+         detail::NonOwningShapeModel<ShapeT const,DrawStrategy const>;
+      static_assert( sizeof(Model) == MODEL_SIZE, "Invalid size detected" );
+      static_assert( alignof(Model) == alignof(void*), "Misaligned detected" );
+
+      std::construct_at( static_cast<Model*>(pimpl()), shape, drawer );
+   }
+
+   ShapeConstRef( Shape& other );
+   ShapeConstRef( Shape const& other );
+
+   ShapeConstRef( ShapeConstRef const& other )
+   {
+      other.pimpl()->clone( pimpl() );
+   }
+
+   ShapeConstRef& operator=( ShapeConstRef const& other )
+   {
+      // Copy-and-swap idiom
+      ShapeConstRef copy( other );
+      raw_.swap( copy.raw_ );
+      return *this;
+   }
+
+   ~ShapeConstRef()
+   {
+      std::destroy_at( pimpl() );
+      // or: pimpl()->~ShapeConcept();
+   }
+
+   // Move operations explicitly not declared
+
+ private:
+   friend void draw( ShapeConstRef const& shape )
+   {
+      shape.pimpl()->draw();
+   }
+
+   detail::ShapeConcept* pimpl()  // The Bridge design pattern
+   {
+      return reinterpret_cast<detail::ShapeConcept*>( raw_.data() );
+   }
+
+   detail::ShapeConcept const* pimpl() const
+   {
+      return reinterpret_cast<detail::ShapeConcept const*>( raw_.data() );
+   }
+
+   // Expected size of a model instantiation:
+   //     sizeof(ShapeT*) + sizeof(DrawStrategy*) + sizeof(vptr)
+   static constexpr size_t MODEL_SIZE = 3U*sizeof(void*);
+
+   alignas(void*) std::array<std::byte,MODEL_SIZE> raw_;
+
+   friend class Shape;
+};
+
+
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_ = std::make_unique<Model>( std::move(shape)
+                                      , std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : pimpl_( other.pimpl_->clone() )
+   {}
+
+   Shape( ShapeConstRef const& other )
+      : pimpl_{ other.pimpl()->clone() }
+   {}
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      pimpl_.swap( copy.pimpl_ );
+      return *this;
+   }
+
+   ~Shape() = default;
+   Shape( Shape&& ) = default;
+   Shape& operator=( Shape&& ) = default;
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   std::unique_ptr<detail::ShapeConcept> pimpl_;  // The Bridge design pattern
+
+   friend class ShapeConstRef;
+};
+
+
+ShapeConstRef::ShapeConstRef( Shape& other )
+{
+   other.pimpl_->clone( pimpl() );
+}
+
+ShapeConstRef::ShapeConstRef( Shape const& other )
+{
+   other.pimpl_->clone( pimpl() );
+}
+
+
+//---- Benchmark setup ----------------------------------------------------------------------------
+
+auto const drawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+auto const drawShape = []( Shape const& s ){ draw( s ); };
+
+std::vector<Circle> createCircles( size_t size )
+{
+   std::vector<Circle> circles{};
+   circles.reserve( size );
+   for( size_t i=0U; i<size; ++i ) {
+      circles.emplace_back( dist( rng ) );
+   }
+   return circles;
+}
+
+std::vector<Shape> createShapes( std::vector<Circle> const& circles )
+{
+   std::vector<Shape> shapes{};
+   shapes.reserve( circles.size() );
+   for( auto const& circle : circles ) {
+      shapes.emplace_back( circle, drawer );
+   }
+   return shapes;
+}
+
+template< typename Source, typename Factory >
+auto convert( std::vector<Source> const& sources, Factory factory )
+{
+   std::vector<decltype( factory( sources.front() ) )> targets{};
+   targets.reserve( sources.size() );
+   for( auto const& source : sources ) {
+      targets.push_back( factory( source ) );
+   }
+   return targets;
+}
+
+template< typename Shapes >
+void drawAll( benchmark::State& state, Shapes const& shapes )
+{
+   for( auto _ : state )
+   {
+      for( auto const& shape : shapes ) {
+         draw( shape );
+      }
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+}
+
+
+//---- Benchmarks ---------------------------------------------------------------------------------
+
+static void shapeFromConcrete(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const shapes( createShapes( circles ) );
+   drawAll( state, shapes );
+}
+#if BENCHMARK_SHAPE_FROM_CONCRETE
+BENCHMARK(shapeFromConcrete)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void refFromConcrete(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const refs( convert( circles, []( Circle const& c ){
+      return ShapeConstRef( c, drawer ); } ) );
+   drawAll( state, refs );
+}
+#if BENCHMARK_REF_FROM_CONCRETE
+BENCHMARK(refFromConcrete)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void refFromShapeBefore(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const shapes( createShapes( circles ) );
+   auto const refs( convert( shapes, []( Shape const& s ){
+      return ShapeConstRef( s, drawShape ); } ) );
+   drawAll( state, refs );
+}
+
+static void refFromShapeAfter(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const shapes( createShapes( circles ) );
+   auto const refs( convert( shapes, []( Shape const& s ){ return ShapeConstRef( s ); } ) );
+   drawAll( state, refs );
+}
+#if BENCHMARK_REF_FROM_SHAPE
+BENCHMARK(refFromShapeBefore)->RangeMultiplier(10)->Range(minSize,maxSize);
+BENCHMARK(refFromShapeAfter)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void refFromRef(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const shapes( createShapes( circles ) );
+   auto const refs( convert( shapes, []( Shape const& s ){ return ShapeConstRef( s ); } ) );
+   auto const copies( convert( refs, []( ShapeConstRef const& r ){
+      return ShapeConstRef( r ); } ) );
+   drawAll( state, copies );
+}
+#if BENCHMARK_REF_FROM_REF
+BENCHMARK(refFromRef)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+static void shapeFromRef(benchmark::State& state)
+{
+   auto const circles( createCircles( state.range(0) ) );
+   auto const refs( convert( circles, []( Circle const& c ){
+      return ShapeConstRef( c, drawer ); } ) );
+   auto const copies( convert( refs, []( ShapeConstRef const& r ){ return Shape( r ); } ) );
+   drawAll( state, copies );
+}
+#if BENCHMARK_SHAPE_FROM_REF
+BENCHMARK(shapeFromRef)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
@@ -0,0 +1,190 @@
+/**************************************************************************************************
+*
+* \file G34_Shape_Ref_List.cpp
+* \brief Guideline 34: Be Aware of the Setup Costs of Owning Type Erasure Wrappers
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+**************************************************************************************************/
+
+
+//---- <Circle.h> ---------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius )
+      : radius_( radius )
+   {}
+
+   double radius() const { return radius_; }
+   /* Several more getters and circle-specific utility functions */
+
+ private:
+   double radius_;
+   /* Several more data members */
+};
+
+
+//---- <Square.h> ---------------------------------------------------------------------------------
+
+class Square
+{
+ public:
+   explicit Square( double side )
+      : side_( side )
+   {}
+
+   double side() const { return side_; }
+   /* Several more getters and square-specific utility functions */
+
+ private:
+   double side_;
+   /* Several more data members */
+};
+
+
+//---- <Shape.h> ----------------------------------------------------------------------------------
+
+#include <memory>
+
+class ShapeConstRef
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ShapeConstRef( ShapeT& shape, DrawStrategy& drawer )
+      : shape_{ std::addressof(shape) }
+      , drawer_{ std::addressof(drawer) }
+      , draw_{ []( void const* shapeBytes, void const* drawerBytes ){
+           auto const* shape = static_cast<ShapeT const*>(shapeBytes);
+           auto const* drawer = static_cast<DrawStrategy const*>(drawerBytes);
+           (*drawer)( *shape );
+        } }
+   {}
+
+ private:
+   friend void draw( ShapeConstRef const& shape )
+   {
+      shape.draw_( shape.shape_, shape.drawer_ );
+   }
+
+   using DrawOperation = void( void const*,void const* );
+
+   void const* shape_{ nullptr };
+   void const* drawer_{ nullptr };
+   DrawOperation* draw_{ nullptr };
+};
+
+
+//---- <ShapeRefList.h> ---------------------------------------------------------------------------
+
+//#include <Shape.h>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+// Builds a list of shape references in a caller-provided buffer (e.g. on the stack or in an
+// arena), i.e. without any dynamic memory allocation. The referenced shapes and drawing
+// strategies have to outlive the list.
+class ShapeRefList
+{
+ public:
+   static_assert( std::is_trivially_destructible_v<ShapeConstRef> );
+
+   explicit ShapeRefList( std::span<std::byte> buffer )
+   {
+      void* ptr( buffer.data() );
+      size_t space( buffer.size() );
+      if( std::align( alignof(ShapeConstRef), sizeof(ShapeConstRef), ptr, space ) ) {
+         refs_ = static_cast<ShapeConstRef*>( ptr );
+         capacity_ = space / sizeof(ShapeConstRef);
+      }
+   }
+
+   // Adds references to all shapes in the given range, which are drawn by the given strategy
+   template< typename Shapes, typename DrawStrategy >
+   ShapeRefList& add( Shapes const& shapes, DrawStrategy const& drawer )
+   {
+      if( std::size( shapes ) > capacity_ - size_ ) {
+         throw std::length_error( "Insufficient buffer for shape references" );
+      }
+      for( auto const& shape : shapes ) {
+         std::construct_at( refs_ + size_, shape, drawer );
+         ++size_;
+      }
+      return *this;
+   }
+
+   void clear() { size_ = 0U; }
+
+   std::span<ShapeConstRef const> refs() const { return { refs_, size_ }; }
+   size_t size() const { return size_; }
+   size_t capacity() const { return capacity_; }
+
+ private:
+   ShapeConstRef* refs_{ nullptr };
+   size_t size_{ 0U };
+   size_t capacity_{ 0U };
+};
+
+
+//---- <DrawAll.h> --------------------------------------------------------------------------------
+
+#include <span>
+class ShapeConstRef;
+
+void drawAll( std::span<ShapeConstRef const> shapes );
+
+
+//---- <DrawAll.cpp> ------------------------------------------------------------------------------
+
+//#include <DrawAll.h>
+//#include <Shape.h>
+
+void drawAll( std::span<ShapeConstRef const> shapes )
+{
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+}
+
+
+//---- <Main.cpp> ---------------------------------------------------------------------------------
+
+//#include <Circle.h>
+//#include <Square.h>
+//#include <DrawAll.h>
+//#include <ShapeRefList.h>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+int main()
+{
+   // The shapes of the scene, stored by concrete type
+   std::vector<Circle> const circles{ Circle{ 3.14 }, Circle{ 1.0 }, Circle{ 2.5 } };
+   std::array<Square,2U> const squares{ Square{ 1.2 }, Square{ 4.0 } };
+
+   // Create the drawing strategies in form of lambdas
+   auto const circleDrawer = []( Circle const& c ){ /*...*/ };
+   auto const squareDrawer = []( Square const& s ){ /*...*/ };
+
+   // The draw list of a frame is assembled in a buffer on the stack
+   alignas(ShapeConstRef) std::array<std::byte,16U*sizeof(ShapeConstRef)> buffer;
+   ShapeRefList list( buffer );
+
+   list.add( circles, circleDrawer )
+       .add( squares, squareDrawer );
+
+   drawAll( list.refs() );
+
+   return ( list.size() == 5U ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,334 @@
+/**************************************************************************************************
+*
+* \file G34_Shape_Ref_List_Performance.cpp
+* \brief Guideline 34: Be Aware of the Setup Costs of Owning Type Erasure Wrappers
+*
+* Copyright (C) 2022 Klaus Iglberger - All Rights Reserved
+*
+* This file is part of the supplemental material for the O'Reilly book "C++ Software Design"
+* (https://www.oreilly.com/library/view/c-software-design/9781098113155/).
+*
+* Copy-and-paste the following code into 'quick-bench.com'. Benchmark the time to assemble and
+* draw the draw list of a frame, once as a std::vector of owning 'Shape' wrappers (see Guideline
+* 32) and once as a 'ShapeRefList' of non-owning 'ShapeConstRef' references in a preallocated
+* buffer. The 'allocs/frame' counter reports the number of dynamic memory allocations per frame.
+*
+**************************************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//---- Benchmark configuration --------------------------------------------------------------------
+
+constexpr size_t minSize( 1000 );     // Minimum size of the generated containers
+constexpr size_t maxSize( 1000000 );  // Maximum size of the generated containers
+
+#define BENCHMARK_SHAPE_VECTOR   1  // std::vector<Shape> per frame
+#define BENCHMARK_SHAPE_REF_LIST 1  // ShapeRefList per frame
+
+
+//---- Random Number Setup ------------------------------------------------------------------------
+
+std::random_device rd{};
+const unsigned int seed( rd() );
+
+std::mt19937 rng{ seed };
+std::uniform_real_distribution<double> dist( 1.0, 10.0 );
+
+
+//---- Allocation counting ------------------------------------------------------------------------
+
+// All dynamic memory allocations of the benchmark are counted, which enables the report of
+// the number of allocations per frame. The replacement functions must not be inlined,
+// since the compiler would otherwise diagnose a mismatch between 'new' and 'free()'.
+size_t allocations{ 0U };
+
+[[gnu::noinline]] void* operator new( size_t bytes )
+{
+   ++allocations;
+   if( void* ptr = std::malloc( bytes ) ) return ptr;
+   throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete( void* ptr ) noexcept
+{
+   std::free( ptr );
+}
+
+[[gnu::noinline]] void operator delete( void* ptr, size_t ) noexcept
+{
+   std::free( ptr );
+}
+
+
+//---- Shapes -------------------------------------------------------------------------------------
+
+class Circle
+{
+ public:
+   explicit Circle( double radius ) : radius_( radius ) {}
+   double radius() const { return radius_; }
+
+ private:
+   double radius_;
+};
+
+class Square
+{
+ public:
+   explicit Square( double side ) : side_( side ) {}
+   double side() const { return side_; }
+
+ private:
+   double side_;
+};
+
+struct Scene
+{
+   std::vector<Circle> circles;
+   std::vector<Square> squares;
+};
+
+Scene createScene( size_t size )
+{
+   Scene scene{};
+   for( size_t i=0U; i<size/2U; ++i ) {
+      scene.circles.emplace_back( dist( rng ) );
+      scene.squares.emplace_back( dist( rng ) );
+   }
+   return scene;
+}
+
+auto const circleDrawer = []( Circle const& c ){ benchmark::DoNotOptimize( c.radius() ); };
+auto const squareDrawer = []( Square const& s ){ benchmark::DoNotOptimize( s.side() ); };
+
+
+//---- Owning Shape (Guideline 32) ----------------------------------------------------------------
+
+namespace detail {
+
+class ShapeConcept  // The External Polymorphism design pattern
+{
+ public:
+   virtual ~ShapeConcept() = default;
+   virtual void draw() const = 0;
+   virtual std::unique_ptr<ShapeConcept> clone() const = 0;  // The Prototype design pattern
+};
+
+template< typename ShapeT
+        , typename DrawStrategy >
+class OwningShapeModel : public ShapeConcept
+{
+ public:
+   explicit OwningShapeModel( ShapeT shape, DrawStrategy drawer )
+      : shape_{ std::move(shape) }
+      , drawer_{ std::move(drawer) }
+   {}
+
+   void draw() const override { drawer_(shape_); }
+
+   std::unique_ptr<ShapeConcept> clone() const override  // The Prototype design pattern
+   {
+      return std::make_unique<OwningShapeModel>( *this );
+   }
+
+ private:
+   ShapeT shape_;
+   DrawStrategy drawer_;
+};
+
+} // namespace detail
+
+
+class Shape
+{
+ public:
+   template< typename ShapeT
+           , typename DrawStrategy >
+   Shape( ShapeT shape, DrawStrategy drawer )
+   {
+      using Model = detail::OwningShapeModel<ShapeT,DrawStrategy>;
+      pimpl_ = std::make_unique<Model>( std::move(shape)
+                                      , std::move(drawer) );
+   }
+
+   Shape( Shape const& other )
+      : pimpl_( other.pimpl_->clone() )
+   {}
+
+   Shape& operator=( Shape const& other )
+   {
+      // Copy-and-Swap Idiom
+      Shape copy( other );
+      pimpl_.swap( copy.pimpl_ );
+      return *this;
+   }
+
+   ~Shape() = default;
+   Shape( Shape&& ) = default;
+   Shape& operator=( Shape&& ) = default;
+
+ private:
+   friend void draw( Shape const& shape )
+   {
+      shape.pimpl_->draw();
+   }
+
+   std::unique_ptr<detail::ShapeConcept> pimpl_;  // The Bridge design pattern
+};
+
+
+//---- ShapeConstRef and ShapeRefList -------------------------------------------------------------
+
+class ShapeConstRef
+{
+ public:
+   template< typename ShapeT, typename DrawStrategy >
+   ShapeConstRef( ShapeT& shape, DrawStrategy& drawer )
+      : shape_{ std::addressof(shape) }
+      , drawer_{ std::addressof(drawer) }
+      , draw_{ []( void const* shapeBytes, void const* drawerBytes ){
+           auto const* shape = static_cast<ShapeT const*>(shapeBytes);
+           auto const* drawer = static_cast<DrawStrategy const*>(drawerBytes);
+           (*drawer)( *shape );
+        } }
+   {}
+
+ private:
+   friend void draw( ShapeConstRef const& shape )
+   {
+      shape.draw_( shape.shape_, shape.drawer_ );
+   }
+
+   using DrawOperation = void( void const*,void const* );
+
+   void const* shape_{ nullptr };
+   void const* drawer_{ nullptr };
+   DrawOperation* draw_{ nullptr };
+};
+
+// Builds a list of shape references in a caller-provided buffer (e.g. on the stack or in an
+// arena), i.e. without any dynamic memory allocation. The referenced shapes and drawing
+// strategies have to outlive the list.
+class ShapeRefList
+{
+ public:
+   static_assert( std::is_trivially_destructible_v<ShapeConstRef> );
+
+   explicit ShapeRefList( std::span<std::byte> buffer )
+   {
+      void* ptr( buffer.data() );
+      size_t space( buffer.size() );
+      if( std::align( alignof(ShapeConstRef), sizeof(ShapeConstRef), ptr, space ) ) {
+         refs_ = static_cast<ShapeConstRef*>( ptr );
+         capacity_ = space / sizeof(ShapeConstRef);
+      }
+   }
+
+   // Adds references to all shapes in the given range, which are drawn by the given strategy
+   template< typename Shapes, typename DrawStrategy >
+   ShapeRefList& add( Shapes const& shapes, DrawStrategy const& drawer )
+   {
+      if( std::size( shapes ) > capacity_ - size_ ) {
+         throw std::length_error( "Insufficient buffer for shape references" );
+      }
+      for( auto const& shape : shapes ) {
+         std::construct_at( refs_ + size_, shape, drawer );
+         ++size_;
+      }
+      return *this;
+   }
+
+   void clear() { size_ = 0U; }
+
+   std::span<ShapeConstRef const> refs() const { return { refs_, size_ }; }
+   size_t size() const { return size_; }
+   size_t capacity() const { return capacity_; }
+
+ private:
+   ShapeConstRef* refs_{ nullptr };
+   size_t size_{ 0U };
+   size_t capacity_{ 0U };
+};
+
+void drawAll( std::span<ShapeConstRef const> shapes )
+{
+   for( auto const& shape : shapes ) {
+      draw( shape );
+   }
+}
+
+
+//---- Benchmark for a vector of owning shapes ----------------------------------------------------
+
+static void shapeVector(benchmark::State& state)
+{
+   Scene const scene( createScene( state.range(0) ) );
+   size_t frameAllocations{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocations );
+
+      std::vector<Shape> shapes{};
+      shapes.reserve( scene.circles.size() + scene.squares.size() );
+      for( auto const& circle : scene.circles ) shapes.emplace_back( circle, circleDrawer );
+      for( auto const& square : scene.squares ) shapes.emplace_back( square, squareDrawer );
+
+      for( auto const& shape : shapes ) {
+         draw( shape );
+      }
+
+      frameAllocations = allocations - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/frame"] = static_cast<double>( frameAllocations );
+}
+#if BENCHMARK_SHAPE_VECTOR
+BENCHMARK(shapeVector)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+
+
+//---- Benchmark for a list of shape references ---------------------------------------------------
+
+static void shapeRefList(benchmark::State& state)
+{
+   Scene const scene( createScene( state.range(0) ) );
+
+   // The buffer is allocated once, e.g. as part of a frame arena
+   std::vector<std::byte> buffer( state.range(0)*sizeof(ShapeConstRef) + alignof(ShapeConstRef) );
+   size_t frameAllocations{};
+
+   for( auto _ : state )
+   {
+      size_t const before( allocations );
+
+      ShapeRefList list( buffer );
+      list.add( scene.circles, circleDrawer )
+          .add( scene.squares, squareDrawer );
+
+      drawAll( list.refs() );
+
+      frameAllocations = allocations - before;
+   }
+
+   state.SetItemsProcessed( state.iterations() * state.range(0) );
+   state.counters["allocs/frame"] = static_cast<double>( frameAllocations );
+}
+#if BENCHMARK_SHAPE_REF_LIST
+BENCHMARK(shapeRefList)->RangeMultiplier(10)->Range(minSize,maxSize);
+#endif
+